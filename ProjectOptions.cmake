@@ -19,6 +19,7 @@ include(CheckCXXCompilerFlag)
 
 macro(ilp_gaffer_movie_setup_options)
   option(ilp_gaffer_movie_ENABLE_COVERAGE "Enable coverage reporting" OFF)
+  option(ilp_gaffer_movie_ENABLE_TRACE "Enable trace spans (collection is toggled at runtime)" ON)
 
   # NOTE(tohi): Skip hardening for now...
   #
@@ -3,6 +3,9 @@
 #include <GafferImage/ImageNode.h>
 
 #include <Gaffer/NumericPlug.h>
+#include <Gaffer/TypedObjectPlug.h>
+
+#include <IECore/CompoundData.h>
 
 #include <memory>// std::shared_ptr
 #include <optional>// std::optional
@@ -17,6 +20,10 @@ namespace Gaffer {
 IE_CORE_FORWARDDECLARE(StringPlug)
 }// namespace Gaffer
 
+namespace ilp_movie {
+struct InputVideoStreamHeader;
+}// namespace ilp_movie
+
 namespace IlpGafferMovie {
 
 // Convenience macro for declaring plug member functions.
@@ -40,6 +47,15 @@ public:
     Hold,
   };
 
+  // The Orientation controls the order in which rows of the decoded frames are
+  // read into tiles. Decoded frames are stored top-down, while Gaffer's pixel
+  // coordinates are bottom-up, so FlipVertical gives the expected image without
+  // having to use a "vflip" filter.
+  enum Orientation {
+    Native = 0,
+    FlipVertical,
+  };
+
   PLUG_MEMBER_DECL(fileNamePlug, Gaffer::StringPlug);
 
   // Number of times the node has been refreshed.
@@ -49,6 +65,17 @@ public:
 
   PLUG_MEMBER_DECL(videoStreamPlug, Gaffer::StringPlug);
   PLUG_MEMBER_DECL(filterGraphPlug, Gaffer::StringPlug);
+  PLUG_MEMBER_DECL(orientationPlug, Gaffer::IntPlug);
+
+  // The number of frames to decode ahead, in the background, when frames are requested in a
+  // pattern, e.g. during playback. Zero disables prefetching. Only a hint, doesn't affect the
+  // output.
+  PLUG_MEMBER_DECL(prefetchFramesPlug, Gaffer::IntPlug);
+
+  // The OCIO color space of the decoded frames. If not empty, frames are converted from this
+  // space to the working space once per frame, when decoded, and only the converted frames are
+  // cached. Empty disables conversion, i.e. frames are output as decoded.
+  PLUG_MEMBER_DECL(colorSpacePlug, Gaffer::StringPlug);
 
   PLUG_MEMBER_DECL(availableFramesPlug, Gaffer::IntVectorDataPlug);
   PLUG_MEMBER_DECL(fileValidPlug, Gaffer::BoolPlug);
@@ -58,6 +85,66 @@ public:
 
   static size_t supportedExtensions(std::vector<std::string> &extensions);
 
+  // Decoders are shared by all AvReader nodes. Decoders that have not been used recently are
+  // hibernated, releasing their file handle and decoding memory, when the number of open files
+  // exceeds this limit.
+  static void setOpenFilesLimit(size_t maxOpenFiles);
+  static size_t getOpenFilesLimit();
+
+  // Decoded frames are cached and shared by all AvReader nodes. The cache is limited by
+  // the memory, in [bytes], used by the frames.
+  static void setFrameCacheMemoryLimit(size_t bytes);
+  static size_t getFrameCacheMemoryLimit();
+
+  // Decoded frames can be cached with half precision, rather than single precision, floats,
+  // which halves the memory used per frame. Each tile is expanded to single precision when it is
+  // computed, so only the tiles in use are held as floats. Disabled by default, unless the
+  // ILP_GAFFER_MOVIE_FRAME_CACHE_HALF environment variable is set to 1. Changing the setting
+  // clears the frame cache and Gaffer's hash cache, so that images are hashed for the new
+  // storage.
+  static void setFrameCacheHalfFloat(bool enabled);
+  static bool getFrameCacheHalfFloat();
+
+  // Sets whether frames that only need a pixel format conversion, i.e. without a filter graph
+  // (or with just "vflip") and without color conversion, are cached in their native YUV pixel
+  // format. Each tile is then converted when computed, and only for the requested channel, and
+  // the cache holds several times as many frames. Disabled by default, unless the
+  // ILP_GAFFER_MOVIE_FRAME_CACHE_NATIVE environment variable is set to 1. Changing the setting
+  // clears the frame cache and Gaffer's hash cache, same as setFrameCacheHalfFloat.
+  static void setFrameCacheNativeYuv(bool enabled);
+  static bool getFrameCacheNativeYuv();
+
+  // Decoded frames evicted from memory can be written to a local scratch directory, e.g. on an
+  // SSD, and mapped back into memory when needed again instead of being decoded, which is much
+  // faster for long-GOP or high resolution video and for files on network storage. Files are
+  // private to the process and removed on exit. Disabled by default, unless the
+  // ILP_GAFFER_MOVIE_DISK_CACHE_DIR environment variable is set, an empty directory disables it.
+  // Changing the directory removes all files written so far.
+  static void setFrameCacheDiskDirectory(const std::string &directory);
+  static std::string getFrameCacheDiskDirectory();
+
+  // Sets the limit, in [bytes], for the size of the files written to the scratch directory.
+  // Least recently used frames are removed when the limit is exceeded. Defaults to 16384 MB, or
+  // to the ILP_GAFFER_MOVIE_DISK_CACHE_MB environment variable (in megabytes) if set.
+  static void setFrameCacheDiskLimit(size_t bytes);
+  static size_t getFrameCacheDiskLimit();
+
+  // Returns "memoryLimit", "memoryUsage", "hits", "misses", "evictions", "decodes",
+  // "prefetches", "diskLimit", "diskUsage", "diskHits" and "diskWrites" for the frame cache.
+  // Misses for frames that only need to be filtered again, e.g. after changing the filter graph,
+  // don't require decoding, and neither do frames mapped back from disk (disk hits). Prefetched
+  // frames count as hits when requested.
+  static IECore::CompoundDataPtr frameCacheStatistics();
+  static void resetFrameCacheStatistics();
+
+  // Trace spans for decoding, filtering, caching and muxing frames are collected while enabled,
+  // and written as Chrome trace-event JSON, which can be opened in https://ui.perfetto.dev.
+  // Collection is also enabled if the ILP_MOVIE_TRACE environment variable is set to a file
+  // name, in which case the trace is written to that file on exit.
+  static void setTraceEnabled(bool enabled);
+  static bool getTraceEnabled();
+  static bool writeTrace(const std::string &fileName);
+
 protected:
   void hash(const Gaffer::ValuePlug *output,
     const Gaffer::Context *context,
@@ -118,14 +205,59 @@ protected:
     const GafferImage::ImagePlug *parent) const override;
 
 private:
+  // Output plug where all tiles of all channels of a decoded frame are stored. The channel data
+  // plug simply redirects to the correct tile in this plug.
+  PLUG_MEMBER_DECL(tileBatchPlug, Gaffer::ObjectVectorPlug);
+
+  // Output plug holding the interned key of the decoder and filter graph, so that the file name
+  // and filter graph strings are substituted and hashed once per context rather than for every
+  // frame cache lookup.
+  PLUG_MEMBER_DECL(decoderHandlePlug, Gaffer::IntPlug);
+
+  // Output plug whose hash identifies the decoded frame, i.e. the file, frame, stream, filter
+  // graph and missing frame mode. Only the hash is used, so that the hashes of the image plugs
+  // can append this single (cached) hash instead of hashing all of the input plugs.
+  PLUG_MEMBER_DECL(frameIdentityPlug, Gaffer::IntPlug);
+
+  // Output plug holding the interned OCIO processor for the color space, so that the processor
+  // is created once rather than for every frame.
+  PLUG_MEMBER_DECL(colorProcessorHandlePlug, Gaffer::IntPlug);
+
+  // Output plug holding the cached frame, so that the frame is looked up in the frame cache (and
+  // requested from the prefetcher) once per frame rather than once per tile, when tiles are read
+  // straight from the frame, see _computeTile.
+  PLUG_MEMBER_DECL(framePlug, Gaffer::ObjectPlug);
+
   std::optional<int> _videoStreamIndex(const Gaffer::Context *context) const;
   std::string _filterGraph(const Gaffer::Context *context) const;
 
   std::shared_ptr<void> _retrieveDecoder(const Gaffer::Context *context) const;
 
-  std::shared_ptr<void> _retrieveFrame(const Gaffer::Context *context,
+  // Retrieves the header describing the decoded (filtered) frames of the selected video stream,
+  // without decoding a frame. Missing frames are handled according to the missing frame mode,
+  // returns false if default values should be used.
+  bool _retrieveStreamHeader(const Gaffer::Context *context,
+    ilp_movie::InputVideoStreamHeader &hdr,
     bool holdForBlack = false) const;
 
+  std::shared_ptr<const void> _retrieveFrame(const Gaffer::Context *context,
+    bool holdForBlack = false) const;
+
+  // Returns the number of the frame that is decoded for the (possibly fractional) context frame,
+  // taking the missing frame mode into account, same as _retrieveFrame. Returns null if black
+  // pixels are returned.
+  std::optional<int> _resolveFrameNb(const Gaffer::Context *context) const;
+
+  IECore::ConstObjectVectorPtr _computeTileBatch(const Gaffer::Context *context) const;
+
+  // Reads a single tile straight from the cached frame held by the frame plug, used instead of
+  // the tile batch when frames are cached in their native pixel format or with half precision,
+  // see setFrameCacheNativeYuv and setFrameCacheHalfFloat.
+  IECore::ConstFloatVectorDataPtr _computeTile(const std::string &channelName,
+    const Imath::V2i &tileOrigin,
+    const Gaffer::Context *context,
+    const GafferImage::ImagePlug *parent) const;
+
   void _plugSet(Gaffer::Plug *plug);
 
   static size_t g_firstPlugIndex;
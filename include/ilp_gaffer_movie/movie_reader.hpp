@@ -61,6 +61,27 @@ public:
     ClampToFrame = 2,
   };
 
+  // The Orientation controls how rows of the decoded frames are
+  // mapped to Gaffer's (bottom-up) pixel coordinates. It is distinct
+  // from AvReader::Orientation for the same reasons as above. The
+  // orientation is applied on top of the filter graph, so that the
+  // default "vflip" filter graph combined with the default Native
+  // orientation matches readers saved before the plug existed.
+  enum Orientation {
+    Native       = 0,
+    FlipVertical = 1,
+  };
+
+  // The ColorConversion controls where frames are converted from
+  // the input color space to the working space. PerTile converts
+  // tiles on request, caching them separately from the decoded
+  // frames. PerFrame converts each frame once, right after it is
+  // decoded, so that only the converted frame is cached.
+  enum ColorConversion {
+    PerTile  = 0,
+    PerFrame = 1,
+  };
+
   // clang-format on
 
   PLUG_MEMBER_DECL(fileNamePlug, Gaffer::StringPlug);
@@ -79,6 +100,9 @@ public:
 
   PLUG_MEMBER_DECL(videoStreamPlug, Gaffer::StringPlug);
   PLUG_MEMBER_DECL(filterGraphPlug, Gaffer::StringPlug);
+  PLUG_MEMBER_DECL(orientationPlug, Gaffer::IntPlug);
+  PLUG_MEMBER_DECL(prefetchFramesPlug, Gaffer::IntPlug);
+  PLUG_MEMBER_DECL(colorConversionPlug, Gaffer::IntPlug);
 
   PLUG_MEMBER_DECL(availableFramesPlug, Gaffer::IntVectorDataPlug);
   PLUG_MEMBER_DECL(fileValidPlug, Gaffer::BoolPlug);
@@ -156,6 +180,17 @@ private:
   PLUG_MEMBER_DECL(_intermediateImagePlug, GafferImage::ImagePlug);
   PLUG_MEMBER_DECL(_intermediateFileValidPlug, Gaffer::BoolPlug);
 
+  // Routes the color space either to the internal ColorSpace node
+  // or to the AvReader, depending on the color conversion mode.
+  PLUG_MEMBER_DECL(_frameColorSpacePlug, Gaffer::StringPlug);
+  PLUG_MEMBER_DECL(_tileColorConversionPlug, Gaffer::BoolPlug);
+
+  // The filter graph and orientation passed on to the AvReader. A
+  // filter graph that is just "vflip", e.g. the default, is replaced
+  // by flipping rows when tiles are read, see orientationPlug.
+  PLUG_MEMBER_DECL(_avFilterGraphPlug, Gaffer::StringPlug);
+  PLUG_MEMBER_DECL(_avOrientationPlug, Gaffer::IntPlug);
+
   // Not really plugs, but follow the same pattern.
   PLUG_MEMBER_DECL(_avReader, AvReader);
   PLUG_MEMBER_DECL(_colorSpace, GafferImage::ColorSpace);
@@ -8,6 +8,12 @@ class ILPGAFFERMOVIE_EXPORT Startup
 {
 public:
   static void initLog();
+
+  // Routes the parallel work of ilp_movie, i.e. decoding slices and converting row bands, through
+  // TBB, so that threads waiting for a frame (in a TaskMutex) help with the work. Called when the
+  // first decoder is opened, so that all decoders use as many slice threads as TBB has threads,
+  // calling it again does nothing.
+  static void initParallelFor();
 };
 
 }// namespace IlpGafferMovie
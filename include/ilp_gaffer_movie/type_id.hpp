@@ -4,11 +4,12 @@ namespace IlpGafferMovie {
 
 // clang-format off
 enum class TypeId {
-  kFirstTypeId       = 120000,
-  kAvReaderTypeId    = 120001,
-  kMovieWriterTypeId = 120002,
-  kMovieReaderTypeId = 120003,
-  kLastTypeId        = 120499,
+  kFirstTypeId             = 120000,
+  kAvReaderTypeId          = 120001,
+  kMovieWriterTypeId       = 120002,
+  kMovieReaderTypeId       = 120003,
+  kCachedFrameObjectTypeId = 120004,
+  kLastTypeId              = 120499,
 };
 // clang-format on
 
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>// std::ptrdiff_t
+#include <cstdint>// uint16_t
+
+#include "ilp_movie/frame.hpp"// ilp_movie::FrameView, ilp_movie::Comp
+#include "ilp_movie/ilp_movie_export.hpp"
+
+namespace ilp_movie {
+
+// Instruction sets used by the native conversion kernels.
+namespace ConvertIsa {
+  using ValueType = int;
+
+  // Use the best instruction set supported by the CPU.
+  constexpr ValueType kAuto = -1;
+
+  constexpr ValueType kScalar = 0;
+  constexpr ValueType kSse41 = 1;
+  constexpr ValueType kAvx2 = 2;
+}// namespace ConvertIsa
+
+struct ConvertOptions
+{
+  // Flip rows vertically, same as the "vflip" filter.
+  bool vflip = false;
+
+  // Mostly useful for testing, instruction sets not supported by the CPU are
+  // silently replaced by the best supported one.
+  ConvertIsa::ValueType isa = ConvertIsa::kAuto;
+};
+
+// Returns the best instruction set supported by the CPU.
+[[nodiscard]] ILP_MOVIE_EXPORT auto BestConvertIsa() noexcept -> ConvertIsa::ValueType;
+
+// Returns true if there is a native conversion between the pixel formats, i.e. one that does not
+// use libswscale.
+//
+// Supported conversions:
+// - Planar 8-16 bit YUV 4:2:0, 4:2:2, 4:4:0, 4:4:4 -> gbrpf32le (e.g. yuv420p, yuv422p10le)
+// - gbrpf32le, gbrapf32le -> Planar 8-16 bit YUV 4:2:0, 4:2:2, 4:4:0, 4:4:4 (alpha is ignored)
+[[nodiscard]] ILP_MOVIE_EXPORT auto CanConvertFrame(const char *src_pix_fmt_name,
+  const char *dst_pix_fmt_name) noexcept -> bool;
+
+// Convert pixels from src to dst, which must have the same dimensions. The destination planes
+// must be allocated, e.g. using GetBufferSize and FillArrays.
+//
+// The color matrix and range of the YUV frame are taken from its header, i.e. the source header
+// for YUV input and the destination header for YUV output. Unspecified values are treated the
+// same way as libswscale does (BT.601, limited range). Supported matrices are BT.709 and BT.601.
+// Chroma samples are assumed to have MPEG-2 siting (left). For RGB input, values are clamped to
+// [0, 1] and chroma is downsampled with a [1 2 1] / 4 filter horizontally and by averaging
+// vertically.
+//
+// Rows are converted in parallel. Returns false if the conversion is not supported.
+[[nodiscard]] ILP_MOVIE_EXPORT auto ConvertFrame(const FrameView &src,
+  const FrameView &dst,
+  const ConvertOptions &opts = {}) noexcept -> bool;
+
+// Convert a region of a YUV frame, see CanConvertFrame, to a single component (R, G or B) of the
+// gbrpf32le frame that ConvertFrame would produce. The region, x, y, w, h, is given in output
+// coordinates, i.e. after the optional vertical flip, and values are written to dst with
+// dst_stride floats between rows. The values are bit-exact with ConvertFrame for the same
+// instruction set.
+//
+// Only the source rows and columns needed for the region are read, which makes it possible to
+// keep frames in their (compact) native format and convert tiles on demand. Rows are converted
+// on the calling thread. Returns false if the conversion is not supported or the region is not
+// within the frame.
+[[nodiscard]] ILP_MOVIE_EXPORT auto ConvertFrameRegion(const FrameView &src,
+  Comp::ValueType c,
+  int x,
+  int y,
+  int w,
+  int h,
+  float *dst,
+  std::ptrdiff_t dst_stride,
+  const ConvertOptions &opts = {}) noexcept -> bool;
+
+// Convert n values from single precision floats to half precision (IEEE 754 binary16) floats,
+// stored as uint16_t, and back. Rounds half to even, values too large for half precision become
+// infinity. The results are bit-exact regardless of the instruction set, F16C instructions are
+// used for ConvertIsa::kAvx2 if supported by the CPU.
+ILP_MOVIE_EXPORT
+void FloatToHalf(const float *in,
+  uint16_t *out,
+  int n,
+  ConvertIsa::ValueType isa = ConvertIsa::kAuto) noexcept;
+
+ILP_MOVIE_EXPORT
+void HalfToFloat(const uint16_t *in,
+  float *out,
+  int n,
+  ConvertIsa::ValueType isa = ConvertIsa::kAuto) noexcept;
+
+}// namespace ilp_movie
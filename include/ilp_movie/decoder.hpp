@@ -2,6 +2,8 @@
 
 #include <cstddef>// std::size_t
 #include <cstdint>// int64_t, etc.
+#include <functional>// std::function
+#include <future>// std::shared_future
 #include <memory>// std::unique_ptr
 #include <optional>// std::optional
 #include <string>// std::string
@@ -59,9 +61,68 @@ struct DecoderFilterGraphDescription
   // but we don't want to expose those enum types on this interface.
   //
   // E.g. "gbrpf32le" for 32-bit float (planar) RGB frames (little endian).
+  //
+  // If empty, the filter description is ignored and the decoded frames are returned as is, i.e.
+  // in the native pixel format of the video stream. Such raw frames can be filtered separately,
+  // see FrameFilter.
   std::string out_pix_fmt_name = "";
 };
 
+// Counters and timings accumulated by a decoder, see Decoder::Stats. Timings are wall-clock time
+// in [ns], measured on the decoding thread.
+struct DecoderStats
+{
+  // Calls to DecodeVideoFrame, including asynchronous decodes, and how many of these failed or
+  // were cancelled.
+  int64_t decode_calls = 0;
+  int64_t failed_decodes = 0;
+  int64_t cancelled_decodes = 0;
+
+  // Decodes that had to re-open a hibernating decoder.
+  int64_t wakeups = 0;
+
+  // Every decode seeks to the key frame preceding the requested frame.
+  int64_t seeks = 0;
+
+  // Packets read from the decoded video stream, and packets from other streams that were skipped.
+  int64_t packets_read = 0;
+  int64_t packets_skipped = 0;
+
+  // Frames received from the codec, and how many of these were decoded only to reach the
+  // requested frame, e.g. the frames between a key frame and the requested frame.
+  int64_t frames_decoded = 0;
+  int64_t frames_discarded = 0;
+
+  int64_t wake_ns = 0;
+  int64_t seek_ns = 0;
+
+  // Reading packets from the file.
+  int64_t demux_ns = 0;
+
+  // Sending packets to, and receiving frames from, the codec.
+  int64_t decode_ns = 0;
+
+  // Filter graph, or native conversion, of the requested frame.
+  int64_t filter_ns = 0;
+
+  // Copying the requested frame to the output buffer.
+  int64_t copy_ns = 0;
+};
+
+// Returns true if a decode should be abandoned. Called repeatedly on the decoding thread, so it
+// should be cheap, e.g. checking an atomic flag.
+using DecodeCancelledFunc = std::function<bool()>;
+
+// The result of an asynchronous decode. Null if the frame could not be decoded, or if the request
+// was cancelled. Frames are shared by all requests for the same frame, hence const.
+using DecodedFrame = std::shared_ptr<const Frame>;
+
+using DecodeCallback = std::function<void(const DecodedFrame &)>;
+
+// Runs a job, typically on another thread. A job decodes a single frame, so it may take a while
+// to complete.
+using DecodeExecutor = std::function<void(std::function<void()> job)>;
+
 class DecoderImpl;
 class ILP_MOVIE_EXPORT Decoder
 {
@@ -99,6 +160,18 @@ public:
   // decoder in a state as if no file has been opened.
   void Close() noexcept;
 
+  // Release the resources held for decoding, i.e. the file handle, codec contexts and filter
+  // graphs, while keeping the stream headers and probe information. The decoder is still
+  // considered to be open and the next call to DecodeVideoFrame transparently re-opens the file.
+  void Hibernate() noexcept;
+
+  // Same as Hibernate, but returns false without waiting if the decoder is currently busy,
+  // e.g. decoding a frame on another thread. Returns true otherwise.
+  [[nodiscard]] auto TryHibernate() noexcept -> bool;
+
+  // Returns true if the decoder has been hibernated and has not decoded any frames since.
+  [[nodiscard]] auto IsHibernating() const noexcept -> bool;
+
   // Returns the video stream index considered to be "best", which is implementation defined.
   // If no such index can be determined returns a negative number. For instance, this could happen
   // if the opened file contains no video streams, or if no file has been opened.
@@ -123,9 +196,57 @@ public:
   [[nodiscard]] auto VideoStreamHeader(int stream_index) const noexcept
     -> std::optional<InputVideoStreamHeader>;
 
+  // Same as VideoStreamHeader, except that the pixel dimensions, pixel aspect ratio, pixel format
+  // and color properties describe the decoded frames, i.e. after they have been pushed through the
+  // filter graph. These properties are determined when the filter graph is configured, so no
+  // frames need to be decoded.
+  [[nodiscard]] auto FilteredVideoStreamHeader(int stream_index) const noexcept
+    -> std::optional<InputVideoStreamHeader>;
+
+  // Decode the frame with the given one-based frame number. Calls are serialized, i.e. it is
+  // safe to decode frames from multiple threads using the same decoder.
   [[nodiscard]] auto
     DecodeVideoFrame(int stream_index, int frame_nb, Frame &frame) noexcept -> bool;
 
+  // Same as above, except that the decode is abandoned, returning false, as soon as cancelled
+  // returns true. Cancellation is checked before reading each packet and before a decoded frame
+  // is filtered or copied, so an abandoned decode stops within the time it takes to decode one
+  // packet. The decoder is left in a state where subsequent frames decode as usual.
+  [[nodiscard]] auto DecodeVideoFrame(int stream_index,
+    int frame_nb,
+    Frame &frame,
+    const DecodeCancelledFunc &cancelled) noexcept -> bool;
+
+  // Decode the frame with the given one-based frame number without waiting for the result.
+  // Requests are decoded one at a time, in the order they were made, using the executor of the
+  // decoder. A request for a frame that is already queued, or being decoded, shares the result of
+  // that request instead of decoding the frame again.
+  //
+  // Requests that have not completed are cancelled, with a null result, when the decoder is
+  // closed, re-opened or destroyed. These calls wait for the frame being decoded, so they must not
+  // be made from a callback.
+  [[nodiscard]] auto DecodeVideoFrameAsync(int stream_index, int frame_nb) noexcept
+    -> std::shared_future<DecodedFrame>;
+
+  // Same as above, except that the callback is invoked with the result, on the thread that
+  // decoded the frame. Callbacks for the same decoder are invoked in the order of the requests.
+  void DecodeVideoFrameAsync(int stream_index, int frame_nb, DecodeCallback on_decoded) noexcept;
+
+  // Returns the number of asynchronous requests that have not completed, including the one being
+  // decoded. Useful for keeping a bounded number of frames in flight.
+  [[nodiscard]] auto PendingDecodeCount() const noexcept -> int;
+
+  // Sets the executor used for asynchronous decodes. By default, frames are decoded on the thread
+  // pool shared by the library. Passing an empty function restores the default.
+  void SetExecutor(DecodeExecutor executor) noexcept;
+
+  // Returns the statistics accumulated since the decoder was created, or since the last call to
+  // ResetStats. Statistics are always collected, and reading them does not wait for decodes in
+  // progress. They are kept when the decoder is closed or re-opened.
+  [[nodiscard]] auto Stats() const noexcept -> DecoderStats;
+
+  void ResetStats() noexcept;
+
 private:
   const DecoderImpl *_Pimpl() const { return _pimpl.get(); }
   DecoderImpl *_Pimpl() { return _pimpl.get(); }
@@ -128,6 +128,12 @@ template<typename PixelT>
   return p.data == nullptr || p.count == 0;
 }
 
+// Returns true if pixel data for the component can be accessed using CompPixelData for frames
+// with the given pixel format. Useful for determining which components frames have without
+// having a frame at hand.
+[[nodiscard]] ILP_MOVIE_EXPORT auto HasCompPixelData(Comp::ValueType c,
+  const char *pix_fmt_name) noexcept -> bool;
+
 // Try to access (typed) pixel data for a component. Returns an empty PixelData if this is not
 // possible.
 //
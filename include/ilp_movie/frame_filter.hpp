@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>// std::unique_ptr
+#include <optional>// std::optional
+
+#include "ilp_movie/convert.hpp"// ilp_movie::ConvertOptions
+#include "ilp_movie/decoder.hpp"// ilp_movie::DecoderFilterGraphDescription, etc
+#include "ilp_movie/ilp_movie_export.hpp"// ILP_MOVIE_EXPORT
+
+namespace ilp_movie {
+
+struct Frame;
+
+// Applies a filter graph to frames that have already been decoded, typically raw frames from a
+// decoder opened without an output pixel format. This allows decoded frames to be reused when
+// only the filter graph changes.
+//
+// Frames are filtered one at a time, so the filter graph should produce exactly one output frame
+// for each input frame, i.e. temporal filters are not supported.
+class FrameFilterImpl;
+class ILP_MOVIE_EXPORT FrameFilter
+{
+public:
+  FrameFilter();
+  ~FrameFilter();
+
+  // Movable.
+  FrameFilter(FrameFilter &&rhs) noexcept = default;
+  FrameFilter &operator=(FrameFilter &&rhs) noexcept = default;
+
+  // Not copyable.
+  FrameFilter(const FrameFilter &rhs) = delete;
+  FrameFilter &operator=(const FrameFilter &rhs) = delete;
+
+  // Configure the filter graph for input frames described by the given header, e.g. a video
+  // stream header from a decoder returning raw frames. The output pixel format must be set.
+  // Returns true if successful; otherwise false.
+  [[nodiscard]] auto SetDescription(const DecoderFilterGraphDescription &dfgd,
+    const InputVideoStreamHeader &in_hdr) noexcept -> bool;
+
+  // Returns the input header with the pixel dimensions, pixel aspect ratio, pixel format and
+  // color properties describing the filtered frames, same as Decoder::FilteredVideoStreamHeader.
+  // Returns null if no description has been set.
+  [[nodiscard]] auto OutputHeader() const noexcept -> std::optional<InputVideoStreamHeader>;
+
+  // Returns the options of the native conversion used by FilterFrame, or null if frames are
+  // passed through the filter graph. Frames can then be converted by the caller instead, e.g.
+  // one region at a time using ConvertFrameRegion, with the same results as FilterFrame.
+  [[nodiscard]] auto NativeConvert() const noexcept -> std::optional<ConvertOptions>;
+
+  // Filter a frame, which must have the pixel dimensions and pixel format of the configured
+  // input. Filter graphs that only convert the pixel format, possibly with a vertical flip, use
+  // a native conversion, in which case calls run concurrently. Otherwise calls are serialized.
+  // In both cases it is safe to filter frames from multiple threads using the same filter.
+  [[nodiscard]] auto FilterFrame(const Frame &in_frame, Frame &out_frame) const noexcept -> bool;
+
+private:
+  const FrameFilterImpl *_Pimpl() const { return _pimpl.get(); }
+  FrameFilterImpl *_Pimpl() { return _pimpl.get(); }
+
+  std::unique_ptr<FrameFilterImpl> _pimpl;
+};
+
+}// namespace ilp_movie
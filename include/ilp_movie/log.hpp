@@ -46,6 +46,7 @@ void SetLogLevel(int level) noexcept;
 [[nodiscard]] ILP_MOVIE_EXPORT
 auto LogLevelString(int level) noexcept -> const char*;
 
+// Messages logged before the call are delivered to the previous callback before it is replaced.
 ILP_MOVIE_EXPORT
 void SetLogCallback(const std::function<void(int, const char *)> &cb) noexcept;
 
@@ -55,4 +56,19 @@ auto GetLogCallback() noexcept -> std::function<void(int, const char *)> ;
 ILP_MOVIE_EXPORT
 void LogMsg(int level, const char *msg) noexcept;
 
+// When enabled, messages are queued by the logging threads and delivered to the callback on a
+// background thread, so that threads decoding frames never wait for each other, or for the
+// callback, when logging. If the queue is full, messages less severe than errors are dropped.
+// Disabled by default, i.e. the callback is invoked synchronously by the logging thread.
+// Repeated warnings and errors are collapsed in both modes.
+ILP_MOVIE_EXPORT
+void SetAsyncLogging(bool enabled) noexcept;
+
+[[nodiscard]] ILP_MOVIE_EXPORT auto IsAsyncLogging() noexcept -> bool;
+
+// Blocks until messages logged before the call have been delivered to the callback. Queued
+// messages are also delivered when the library is unloaded.
+ILP_MOVIE_EXPORT
+void FlushLog() noexcept;
+
 }// namespace ilp_movie
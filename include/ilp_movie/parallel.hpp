@@ -0,0 +1,28 @@
+#pragma once
+
+#include <functional>// std::function
+
+#include "ilp_movie/ilp_movie_export.hpp"
+
+namespace ilp_movie {
+
+// Invokes func(range_begin, range_end) for sub-ranges covering [begin, end), each spanning at
+// most grain_size elements, and returns when all sub-ranges have been processed. Sub-ranges
+// must not overlap, but need not be aligned to multiples of grain_size.
+using ParallelForFunc = std::function<void(int begin,
+  int end,
+  int grain_size,
+  const std::function<void(int range_begin, int range_end)> &func)>;
+
+// Route the parallel work done by the library, i.e. row bands when converting frames and slices
+// when decoding frames, through the given implementation instead of the built-in thread pool.
+// This lets a host application with its own task scheduler have threads that would otherwise
+// block, e.g. waiting for a frame being decoded, join the work. The concurrency is the number
+// of threads expected to execute sub-ranges concurrently, used to size the work.
+//
+// Passing an empty function restores the built-in thread pool. Decoders opened before the
+// call keep the number of slice threads they were opened with.
+ILP_MOVIE_EXPORT
+void SetParallelFor(const ParallelForFunc &parallel_for, int concurrency) noexcept;
+
+}// namespace ilp_movie
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>// int64_t
+#include <string>// std::string
+
+#include "ilp_movie/ilp_movie_export.hpp"// ILP_MOVIE_EXPORT
+
+// Trace spans in the library, and in code using the macros below, are compiled out if this is
+// defined to 0, see the ilp_gaffer_movie_ENABLE_TRACE CMake option.
+#ifndef ILP_MOVIE_ENABLE_TRACE
+#define ILP_MOVIE_ENABLE_TRACE 1// NOLINT
+#endif
+
+namespace ilp_movie {
+
+// Collection of trace events is disabled by default, unless the ILP_MOVIE_TRACE environment
+// variable is set to a file name, in which case collection is enabled when the library is loaded
+// and the trace is written to that file when the process exits.
+//
+// Events are kept in memory, in a buffer per thread, until the trace is written. When disabled,
+// a trace span costs a single relaxed atomic load.
+ILP_MOVIE_EXPORT
+void SetTraceEnabled(bool enabled) noexcept;
+
+[[nodiscard]] ILP_MOVIE_EXPORT auto IsTraceEnabled() noexcept -> bool;
+
+// Write the events collected so far as Chrome trace-event JSON, which can be opened in
+// chrome://tracing or https://ui.perfetto.dev, and discard them. Returns true if successful;
+// otherwise false.
+[[nodiscard]] ILP_MOVIE_EXPORT auto WriteTrace(const std::string &path) noexcept -> bool;
+
+// Discard the events collected so far.
+ILP_MOVIE_EXPORT
+void ClearTrace() noexcept;
+
+// Records a complete event spanning the lifetime of the object, if collection is enabled when the
+// object is created. The category, name and argument name are not copied, so these must be
+// string literals (or otherwise outlive the trace).
+class ILP_MOVIE_EXPORT TraceSpan
+{
+public:
+  TraceSpan(const char *category,
+    const char *name,
+    const char *arg_name = nullptr,
+    int64_t arg_value = 0) noexcept;
+  ~TraceSpan();
+
+  // Not copyable or movable.
+  TraceSpan(const TraceSpan &rhs) = delete;
+  TraceSpan &operator=(const TraceSpan &rhs) = delete;
+  TraceSpan(TraceSpan &&rhs) = delete;
+  TraceSpan &operator=(TraceSpan &&rhs) = delete;
+
+private:
+  const char *_category;
+  const char *_name;
+  const char *_arg_name;
+  int64_t _arg_value;
+
+  // Negative if collection was disabled when the span started.
+  int64_t _begin_ns = -1;
+};
+
+// Records an instant event, if collection is enabled. Same requirements on strings as TraceSpan.
+ILP_MOVIE_EXPORT
+void TraceInstant(const char *category,
+  const char *name,
+  const char *arg_name = nullptr,
+  int64_t arg_value = 0) noexcept;
+
+}// namespace ilp_movie
+
+// clang-format off
+#if ILP_MOVIE_ENABLE_TRACE
+#define ILP_MOVIE_TRACE_CONCAT_IMPL(a, b) a##b
+#define ILP_MOVIE_TRACE_CONCAT(a, b) ILP_MOVIE_TRACE_CONCAT_IMPL(a, b)
+#define ILP_MOVIE_TRACE_SPAN(category, name) \
+  const ::ilp_movie::TraceSpan ILP_MOVIE_TRACE_CONCAT(ilp_movie_trace_span_, __LINE__){ \
+    category, name }
+#define ILP_MOVIE_TRACE_SPAN_ARG(category, name, arg_name, arg_value) \
+  const ::ilp_movie::TraceSpan ILP_MOVIE_TRACE_CONCAT(ilp_movie_trace_span_, __LINE__){ \
+    category, name, arg_name, static_cast<int64_t>(arg_value) }
+#define ILP_MOVIE_TRACE_INSTANT(category, name) ::ilp_movie::TraceInstant(category, name)
+#define ILP_MOVIE_TRACE_INSTANT_ARG(category, name, arg_name, arg_value) \
+  ::ilp_movie::TraceInstant(category, name, arg_name, static_cast<int64_t>(arg_value))
+#else
+#define ILP_MOVIE_TRACE_SPAN(category, name) static_cast<void>(0)
+#define ILP_MOVIE_TRACE_SPAN_ARG(category, name, arg_name, arg_value) static_cast<void>(0)
+#define ILP_MOVIE_TRACE_INSTANT(category, name) static_cast<void>(0)
+#define ILP_MOVIE_TRACE_INSTANT_ARG(category, name, arg_name, arg_value) static_cast<void>(0)
+#endif
+// clang-format on
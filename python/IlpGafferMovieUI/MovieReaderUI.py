@@ -215,7 +215,13 @@ Gaffer.Metadata.registerNode(
 			"description",
 			"""
 			The filter graph applied to the decoded frames.\n
-			FFmpeg command-line equivalent of '-vf'.
+			FFmpeg command-line equivalent of '-vf'.\n
+			The default, 'vflip', flips the top-down decoded frames
+			to Gaffer's bottom-up orientation. A filter graph that is
+			just 'vflip' is not run through FFmpeg, rows are instead
+			flipped when tiles are read, which is cheaper. Graphs that
+			also do other things, e.g. 'vflip,scale=1280:-1', are run
+			as is, and an empty graph leaves frames top-down.
 			""",
 
 			"label", "Filter Graph",
@@ -223,6 +229,59 @@ Gaffer.Metadata.registerNode(
 
 		],
 
+		"orientation" : [
+
+			"description",
+			"""
+			Flips the filtered frames vertically when tiles are read, on
+			top of any flip done by the filter graph. The default
+			filter graph already flips frames, so the default is
+			'Native'. Use 'Flip Vertical' together with a custom filter
+			graph, instead of starting that graph with 'vflip', to avoid
+			an extra pass over each frame in FFmpeg.
+			""",
+
+			"preset:Native", IlpGafferMovie.MovieReader.Orientation.Native,
+			"preset:Flip Vertical", IlpGafferMovie.MovieReader.Orientation.FlipVertical,
+
+			"plugValueWidget:type", "GafferUI.PresetsPlugValueWidget",
+
+		],
+
+		"prefetchFrames" : [
+
+			"description",
+			"""
+			The number of frames to decode ahead, in the background,
+			when frames are requested in a pattern, e.g. during
+			playback (forward, backward or stepping over frames).
+			Prefetched frames are stored in the shared frame cache,
+			within its memory limit. Zero disables prefetching.
+			""",
+
+			"label", "Prefetch Frames",
+
+		],
+
+		"colorConversion" : [
+
+			"description",
+			"""
+			Where frames are converted from the colour space to the
+			working space. `Per Tile` converts tiles as they are
+			requested, caching them separately from the decoded frames.
+			`Per Frame` converts each frame once, right after it is
+			decoded, and caches only the converted frame, which roughly
+			halves the memory used for every frame viewed.
+			""",
+
+			"preset:Per Tile", IlpGafferMovie.MovieReader.ColorConversion.PerTile,
+			"preset:Per Frame", IlpGafferMovie.MovieReader.ColorConversion.PerFrame,
+
+			"plugValueWidget:type", "GafferUI.PresetsPlugValueWidget",
+
+		],
+
 		# section: Frames
 
 		"availableFrames" : [
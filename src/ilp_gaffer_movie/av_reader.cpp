@@ -2,10 +2,16 @@
 
 // The nested TaskMutex needs to be the first to include tbb
 #include "internal/LRUCache.h"
+#include "internal/CachedFrame.h"
+#include "internal/CachedFrameObject.h"
+#include "internal/DiskFrameCache.h"
+#include "internal/FramePrefetcher.h"
+#include "internal/SharedColorProcessors.h"
 #include "internal/SharedDecoders.h"
+#include "internal/SharedFilters.h"
 #include "internal/SharedFrames.h"
-#include "internal/trace.hpp"
 
+#include <algorithm>// std::find
 #include <cassert>// assert
 #include <mutex>// std::call_once
 #include <numeric>// std::iota
@@ -15,23 +21,128 @@
 // HACK(tohi): Disable TBB deprecation warning.
 #define __TBB_show_deprecation_message_task_scheduler_init_H
 
+#include <GafferImage/BufferAlgo.h>
 #include <GafferImage/FormatPlug.h>
 #include <GafferImage/ImageAlgo.h>
 #include <GafferImage/ImageReader.h>
+#include <GafferImage/OpenColorIOAlgo.h>
 
 #include <Gaffer/Context.h>
 #include <Gaffer/StringPlug.h>
+#include <Gaffer/ValuePlug.h>
 
 #include <boost/bind/bind.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include "ilp_movie/decoder.hpp"
 #include "ilp_movie/frame.hpp"
 #include "ilp_movie/log.hpp"
+#include "ilp_movie/trace.hpp"
 
 using namespace std::literals;
 
 GAFFER_NODE_DEFINE_TYPE(IlpGafferMovie::AvReader);
 
+namespace {
+
+[[nodiscard]] auto channelComp(const std::string &channelName) -> ilp_movie::Comp::ValueType
+{
+  namespace Comp = ilp_movie::Comp;
+  if (channelName == GafferImage::ImageAlgo::channelNameR) { return Comp::kR; }
+  if (channelName == GafferImage::ImageAlgo::channelNameG) { return Comp::kG; }
+  if (channelName == GafferImage::ImageAlgo::channelNameB) { return Comp::kB; }
+  if (channelName == GafferImage::ImageAlgo::channelNameA) { return Comp::kA; }
+  return Comp::kUnknown;
+}
+
+// Tiles in a tile batch are stored per channel, in the order of the channel names, and in
+// row-major order within each channel, starting at the tile containing the data window origin.
+struct TileBatchLayout
+{
+  explicit TileBatchLayout(const Imath::Box2i &dataWindow)
+  {
+    if (GafferImage::BufferAlgo::empty(dataWindow)) { return; }
+    minTileOrigin = GafferImage::ImagePlug::tileOrigin(dataWindow.min);
+    const Imath::V2i maxTileOrigin =
+      GafferImage::ImagePlug::tileOrigin(dataWindow.max - Imath::V2i(1));
+    numTiles = (maxTileOrigin - minTileOrigin) / GafferImage::ImagePlug::tileSize() + Imath::V2i(1);
+  }
+
+  [[nodiscard]] auto tilesPerChannel() const -> std::size_t
+  {
+    return static_cast<std::size_t>(numTiles.x) * static_cast<std::size_t>(numTiles.y);
+  }
+
+  [[nodiscard]] auto tileOrigin(const int tileX, const int tileY) const -> Imath::V2i
+  {
+    return minTileOrigin + Imath::V2i(tileX, tileY) * GafferImage::ImagePlug::tileSize();
+  }
+
+  [[nodiscard]] auto index(const std::size_t channelIndex, const Imath::V2i &tileOrigin) const
+    -> std::size_t
+  {
+    const Imath::V2i tile = (tileOrigin - minTileOrigin) / GafferImage::ImagePlug::tileSize();
+    return channelIndex * tilesPerChannel()
+           + static_cast<std::size_t>(tile.y) * static_cast<std::size_t>(numTiles.x)
+           + static_cast<std::size_t>(tile.x);
+  }
+
+  Imath::V2i minTileOrigin = Imath::V2i(0);
+  Imath::V2i numTiles = Imath::V2i(0);
+};
+
+// Tiles are read straight from the cached frame, rather than redirected into the tile batch, when
+// frames are cached in their native pixel format or with half precision. Expanding such frames
+// into a tile batch would hold a float copy of every frame in Gaffer's cache, undoing the memory
+// saved by the frame cache.
+[[nodiscard]] bool readsTilesFromFrame()
+{
+  using IlpGafferMovie::shared_frames_internal::SharedFrames;
+  return SharedFrames::getNativeStorage() || SharedFrames::getHalfStorage();
+}
+
+void checkTileBound(const Imath::Box2i &dataWindow, const Imath::Box2i &tileBound)
+{
+  if (!GafferImage::BufferAlgo::intersects(dataWindow, tileBound)) {
+    throw IECore::Exception(
+      boost::str(boost::format("AvReader : Invalid tile (%i,%i) -> (%i,%i) not within "
+                               "data window (%i,%i) -> (%i,%i).")
+                 % tileBound.min.x % tileBound.min.y % tileBound.max.x % tileBound.max.y
+                 % dataWindow.min.x % dataWindow.min.y % dataWindow.max.x % dataWindow.max.y));
+  }
+}
+
+// Copies the part of the frame covered by a tile, pixels outside the data window are left as is.
+void readTile(const IlpGafferMovie::cached_frame_internal::CachedFrame &frame,
+  const ilp_movie::Comp::ValueType c,
+  const Imath::V2i &tileOrigin,
+  const Imath::Box2i &dataWindow,
+  const bool flipVertical,
+  std::vector<float> &tile)
+{
+  constexpr auto kTileSize = static_cast<size_t>(GafferImage::ImagePlug::tileSize());
+  const Imath::Box2i tileBound(
+    /*minT=*/tileOrigin,
+    /*maxT=*/tileOrigin + Imath::V2i(GafferImage::ImagePlug::tileSize()));
+  const Imath::Box2i tileRegion = GafferImage::BufferAlgo::intersection(tileBound, dataWindow);
+  float *dst = &tile[static_cast<size_t>(tileRegion.min.y - tileOrigin.y) * kTileSize
+                     + static_cast<size_t>(tileRegion.min.x - tileOrigin.x)];
+  if (!frame.readRegion(c,
+        tileRegion.min.x,
+        tileRegion.min.y,
+        tileRegion.max.x - tileRegion.min.x,
+        tileRegion.max.y - tileRegion.min.y,
+        flipVertical,
+        dst,
+        static_cast<std::ptrdiff_t>(kTileSize))) {
+    throw IECore::Exception("Cannot convert pixel data");
+  }
+}
+
+}// namespace
+
 namespace IlpGafferMovie {
 
 std::size_t AvReader::g_firstPlugIndex = 0;
@@ -65,17 +176,50 @@ AvReader::AvReader(const std::string &name) : GafferImage::ImageNode{ name }
   addChild(new StringPlug(// [4]
     /*name=*/"filterGraph",
     /*direction=*/Plug::In));
+  addChild(new IntPlug(// [5]
+    /*name=*/"orientation",
+    /*direction=*/Plug::In,
+    /*defaultValue=*/static_cast<int>(Orientation::Native),
+    /*minValue=*/static_cast<int>(Orientation::Native),
+    /*maxValue=*/static_cast<int>(Orientation::FlipVertical)));
+  addChild(new IntPlug(// [6]
+    /*name=*/"prefetchFrames",
+    /*direction=*/Plug::In,
+    /*defaultValue=*/0,
+    /*minValue=*/0));
+  addChild(new StringPlug(// [7]
+    /*name=*/"colorSpace",
+    /*direction=*/Plug::In));
 
-  addChild(new IntVectorDataPlug(// [5]
+  addChild(new IntVectorDataPlug(// [8]
     /*name=*/"availableFrames",
     /*direction=*/Plug::Out,
     /*defaultValue=*/new IntVectorData));
-  addChild(new BoolPlug(// [6]
+  addChild(new BoolPlug(// [9]
     /*name=*/"fileValid",
     /*direction=*/Plug::Out));
-  addChild(new StringPlug(// [7]
+  addChild(new StringPlug(// [10]
     /*name=*/"probe",
     /*direction=*/Plug::Out));
+  addChild(new Gaffer::ObjectVectorPlug(// [11]
+    /*name=*/"__tileBatch",
+    /*direction=*/Plug::Out,
+    /*defaultValue=*/new IECore::ObjectVector));
+  addChild(new IntPlug(// [12]
+    /*name=*/"__decoderHandle",
+    /*direction=*/Plug::Out,
+    /*defaultValue=*/shared_decoders_internal::kInvalidDecoderHandle));
+  addChild(new IntPlug(// [13]
+    /*name=*/"__frameIdentity",
+    /*direction=*/Plug::Out));
+  addChild(new IntPlug(// [14]
+    /*name=*/"__colorProcessorHandle",
+    /*direction=*/Plug::Out,
+    /*defaultValue=*/shared_color_processors_internal::kNoColorProcessor));
+  addChild(new Gaffer::ObjectPlug(// [15]
+    /*name=*/"__frame",
+    /*direction=*/Plug::Out,
+    /*defaultValue=*/new cached_frame_internal::CachedFrameObject));
 
   // NOLINTNEXTLINE
   plugSetSignal().connect(boost::bind(&AvReader::_plugSet, this, boost::placeholders::_1));
@@ -99,10 +243,18 @@ PLUG_MEMBER_IMPL(refreshCountPlug, Gaffer::IntPlug, 1U);
 PLUG_MEMBER_IMPL(missingFrameModePlug, Gaffer::IntPlug, 2U);
 PLUG_MEMBER_IMPL(videoStreamPlug, Gaffer::StringPlug, 3U);
 PLUG_MEMBER_IMPL(filterGraphPlug, Gaffer::StringPlug, 4U);
-
-PLUG_MEMBER_IMPL(availableFramesPlug, Gaffer::IntVectorDataPlug, 5U);
-PLUG_MEMBER_IMPL(fileValidPlug, Gaffer::BoolPlug, 6U);
-PLUG_MEMBER_IMPL(probePlug, Gaffer::StringPlug, 7U);
+PLUG_MEMBER_IMPL(orientationPlug, Gaffer::IntPlug, 5U);
+PLUG_MEMBER_IMPL(prefetchFramesPlug, Gaffer::IntPlug, 6U);
+PLUG_MEMBER_IMPL(colorSpacePlug, Gaffer::StringPlug, 7U);
+
+PLUG_MEMBER_IMPL(availableFramesPlug, Gaffer::IntVectorDataPlug, 8U);
+PLUG_MEMBER_IMPL(fileValidPlug, Gaffer::BoolPlug, 9U);
+PLUG_MEMBER_IMPL(probePlug, Gaffer::StringPlug, 10U);
+PLUG_MEMBER_IMPL(tileBatchPlug, Gaffer::ObjectVectorPlug, 11U);
+PLUG_MEMBER_IMPL(decoderHandlePlug, Gaffer::IntPlug, 12U);
+PLUG_MEMBER_IMPL(frameIdentityPlug, Gaffer::IntPlug, 13U);
+PLUG_MEMBER_IMPL(colorProcessorHandlePlug, Gaffer::IntPlug, 14U);
+PLUG_MEMBER_IMPL(framePlug, Gaffer::ObjectPlug, 15U);
 
 size_t AvReader::supportedExtensions(std::vector<std::string> &extensions)
 {
@@ -110,6 +262,108 @@ size_t AvReader::supportedExtensions(std::vector<std::string> &extensions)
   return extensions.size();
 }
 
+void AvReader::setOpenFilesLimit(const size_t maxOpenFiles)
+{
+  shared_decoders_internal::SharedDecoders::setOpenFilesLimit(maxOpenFiles);
+}
+
+size_t AvReader::getOpenFilesLimit()
+{
+  return shared_decoders_internal::SharedDecoders::getOpenFilesLimit();
+}
+
+void AvReader::setFrameCacheMemoryLimit(const size_t bytes)
+{
+  shared_frames_internal::SharedFrames::setMemoryLimit(bytes);
+}
+
+size_t AvReader::getFrameCacheMemoryLimit()
+{
+  return shared_frames_internal::SharedFrames::getMemoryLimit();
+}
+
+void AvReader::setFrameCacheHalfFloat(const bool enabled)
+{
+  if (enabled == shared_frames_internal::SharedFrames::getHalfStorage()) { return; }
+  shared_frames_internal::SharedFrames::setHalfStorage(enabled);
+
+  // Channel data is hashed differently depending on the frame storage, see readsTilesFromFrame,
+  // and Gaffer cannot tell that this process-wide setting has changed.
+  Gaffer::ValuePlug::clearHashCache();
+}
+
+bool AvReader::getFrameCacheHalfFloat()
+{
+  return shared_frames_internal::SharedFrames::getHalfStorage();
+}
+
+void AvReader::setFrameCacheNativeYuv(const bool enabled)
+{
+  if (enabled == shared_frames_internal::SharedFrames::getNativeStorage()) { return; }
+  shared_frames_internal::SharedFrames::setNativeStorage(enabled);
+
+  // Same as for half storage, see setFrameCacheHalfFloat.
+  Gaffer::ValuePlug::clearHashCache();
+}
+
+bool AvReader::getFrameCacheNativeYuv()
+{
+  return shared_frames_internal::SharedFrames::getNativeStorage();
+}
+
+void AvReader::setFrameCacheDiskDirectory(const std::string &directory)
+{
+  disk_frame_cache_internal::DiskFrameCache::setDirectory(directory);
+}
+
+std::string AvReader::getFrameCacheDiskDirectory()
+{
+  return disk_frame_cache_internal::DiskFrameCache::getDirectory();
+}
+
+void AvReader::setFrameCacheDiskLimit(const size_t bytes)
+{
+  disk_frame_cache_internal::DiskFrameCache::setSizeLimit(bytes);
+}
+
+size_t AvReader::getFrameCacheDiskLimit()
+{
+  return disk_frame_cache_internal::DiskFrameCache::getSizeLimit();
+}
+
+IECore::CompoundDataPtr AvReader::frameCacheStatistics()
+{
+  using UInt64Data = IECore::UInt64Data;
+  const auto stats = shared_frames_internal::SharedFrames::statistics();
+
+  // clang-format off
+  IECore::CompoundDataPtr result = new IECore::CompoundData;
+  result->writable()["memoryLimit"] = new UInt64Data(stats.memoryLimit);// NOLINT
+  result->writable()["memoryUsage"] = new UInt64Data(stats.memoryUsage);// NOLINT
+  result->writable()["hits"] = new UInt64Data(stats.hits);// NOLINT
+  result->writable()["misses"] = new UInt64Data(stats.misses);// NOLINT
+  result->writable()["evictions"] = new UInt64Data(stats.evictions);// NOLINT
+  result->writable()["decodes"] = new UInt64Data(stats.decodes);// NOLINT
+  result->writable()["prefetches"] = new UInt64Data(stats.prefetches);// NOLINT
+  result->writable()["diskLimit"] = new UInt64Data(stats.diskLimit);// NOLINT
+  result->writable()["diskUsage"] = new UInt64Data(stats.diskUsage);// NOLINT
+  result->writable()["diskHits"] = new UInt64Data(stats.diskHits);// NOLINT
+  result->writable()["diskWrites"] = new UInt64Data(stats.diskWrites);// NOLINT
+  // clang-format on
+  return result;
+}
+
+void AvReader::resetFrameCacheStatistics()
+{
+  shared_frames_internal::SharedFrames::resetStatistics();
+}
+
+void AvReader::setTraceEnabled(const bool enabled) { ilp_movie::SetTraceEnabled(enabled); }
+
+bool AvReader::getTraceEnabled() { return ilp_movie::IsTraceEnabled(); }
+
+bool AvReader::writeTrace(const std::string &fileName) { return ilp_movie::WriteTrace(fileName); }
+
 void AvReader::affects(const Gaffer::Plug *input, AffectedPlugsContainer &outputs) const
 {
   // clang-format off
@@ -136,6 +390,34 @@ void AvReader::affects(const Gaffer::Plug *input, AffectedPlugsContainer &output
     for (Gaffer::ValuePlug::Iterator it(outPlug()); !it.done(); ++it) {
       outputs.push_back(it->get());
     }
+    outputs.push_back(tileBatchPlug());
+    outputs.push_back(frameIdentityPlug());
+    outputs.push_back(framePlug());
+  }
+
+  if (input == fileNamePlug() || 
+      input == filterGraphPlug()) {
+    outputs.push_back(decoderHandlePlug());
+  }
+
+  if (input == orientationPlug()) {
+    // Flipping is done when copying rows into tiles, which only affects channel data.
+    outputs.push_back(tileBatchPlug());
+  }
+
+  if (input == colorSpacePlug()) {
+    outputs.push_back(colorProcessorHandlePlug());
+  }
+
+  if (input == colorProcessorHandlePlug()) {
+    // Color conversion is done when frames are decoded, which only affects channel data.
+    outputs.push_back(tileBatchPlug());
+    outputs.push_back(framePlug());
+  }
+
+  if (input == tileBatchPlug() ||
+      input == framePlug()) {
+    outputs.push_back(outPlug()->channelDataPlug());
   }
 
   // clang-format on
@@ -157,6 +439,37 @@ void AvReader::hash(const Gaffer::ValuePlug *output,
     fileNamePlug()->hash(/*out*/ h);
     refreshCountPlug()->hash(/*out*/ h);
     videoStreamPlug()->hash(/*out*/ h);
+  } else if (output == tileBatchPlug()) {
+    frameIdentityPlug()->hash(/*out*/ h);
+    orientationPlug()->hash(/*out*/ h);
+    colorProcessorHandlePlug()->hash(/*out*/ h);
+    outPlug()->dataWindowPlug()->hash(/*out*/ h);
+    outPlug()->channelNamesPlug()->hash(/*out*/ h);
+  } else if (output == framePlug()) {
+    // The storage settings determine how the cached frame is stored.
+    frameIdentityPlug()->hash(/*out*/ h);
+    colorProcessorHandlePlug()->hash(/*out*/ h);
+    h.append(shared_frames_internal::SharedFrames::getHalfStorage());
+    h.append(shared_frames_internal::SharedFrames::getNativeStorage());
+  } else if (output == decoderHandlePlug()) {
+    fileNamePlug()->hash(/*out*/ h);
+    filterGraphPlug()->hash(/*out*/ h);
+  } else if (output == colorProcessorHandlePlug()) {
+    // The processor depends on the current config and working space, see OpenColorIOAlgo.
+    colorSpacePlug()->hash(/*out*/ h);
+    h.append(GafferImage::OpenColorIOAlgo::currentConfigHash());
+    h.append(GafferImage::OpenColorIOAlgo::getWorkingSpace(context));
+  } else if (output == frameIdentityPlug()) {
+    // Hash the frame that is actually decoded, rather than the context frame, so that sub-frame
+    // contexts and held frames share hashes, and thereby cached values, with the decoded frame.
+    fileNamePlug()->hash(/*out*/ h);
+    const auto frameNb = _resolveFrameNb(context);
+    h.append(frameNb.has_value());
+    if (frameNb.has_value()) { h.append(*frameNb); }
+    refreshCountPlug()->hash(/*out*/ h);
+    missingFrameModePlug()->hash(/*out*/ h);
+    videoStreamPlug()->hash(/*out*/ h);
+    filterGraphPlug()->hash(/*out*/ h);
   }
 
   // clang-format on
@@ -202,6 +515,46 @@ void AvReader::compute(Gaffer::ValuePlug *output, const Gaffer::Context *context
     result.resize(static_cast<std::size_t>(hdr->frame_count));
     std::iota(std::begin(result), std::end(result), hdr->first_frame_nb);
     static_cast<IntVectorDataPlug *>(output)->setValue(resultData);// NOLINT
+  } else if (output == tileBatchPlug()) {
+    static_cast<Gaffer::ObjectVectorPlug *>(output)->setValue(_computeTileBatch(context));// NOLINT
+  } else if (output == framePlug()) {
+    auto frame =
+      std::static_pointer_cast<const cached_frame_internal::CachedFrame>(_retrieveFrame(context));
+    static_cast<Gaffer::ObjectPlug *>(output)->setValue(// NOLINT
+      new cached_frame_internal::CachedFrameObject(std::move(frame)));
+  } else if (output == decoderHandlePlug()) {
+    const std::string fileName = fileNamePlug()->getValue();
+    if (fileName.empty()) {
+      static_cast<Gaffer::IntPlug *>(output)->setToDefault();// NOLINT
+      return;
+    }
+
+    // clang-format off
+    const auto handle = shared_decoders_internal::SharedDecoders::intern(
+      /*key=*/shared_decoders_internal::DecoderCacheKey{ 
+        /*.fileName=*/context->substitute(fileName),
+        /*.filterGraphDescr=*/{ 
+          /*.filter_descr=*/_filterGraph(context),
+          /*.out_pix_fmt_name=*/"gbrpf32le" 
+        } 
+      });
+    // clang-format on
+    static_cast<Gaffer::IntPlug *>(output)->setValue(handle);// NOLINT
+  } else if (output == colorProcessorHandlePlug()) {
+    const std::string colorSpace = colorSpacePlug()->getValue();
+    if (colorSpace.empty()) {
+      static_cast<Gaffer::IntPlug *>(output)->setToDefault();// NOLINT
+      return;
+    }
+
+    // Converts to the working space, same as GafferImage::ColorSpace with an empty output space.
+    const auto handle = shared_color_processors_internal::SharedColorProcessors::intern(
+      /*inputSpace=*/colorSpace,
+      /*outputSpace=*/GafferImage::OpenColorIOAlgo::getWorkingSpace(context));
+    static_cast<Gaffer::IntPlug *>(output)->setValue(handle);// NOLINT
+  } else if (output == frameIdentityPlug()) {
+    // Only the hash of this plug is used.
+    static_cast<Gaffer::IntPlug *>(output)->setToDefault();// NOLINT
   } else if (output == probePlug()) {
     const auto decoder = std::static_pointer_cast<ilp_movie::Decoder>(_retrieveDecoder(context));
     if (decoder != nullptr) {
@@ -216,11 +569,17 @@ void AvReader::compute(Gaffer::ValuePlug *output, const Gaffer::Context *context
 
 Gaffer::ValuePlug::CachePolicy AvReader::computeCachePolicy(const Gaffer::ValuePlug *output) const
 {
-  if (output == outPlug()->channelDataPlug()) {
+  if (output == outPlug()->channelDataPlug() && !readsTilesFromFrame()) {
     // Disable caching on channelDataPlug, since it is just a redirect to the correct tile of
-    // the private tileBatchPlug, which is already being cached.
+    // the private tileBatchPlug, which is already being cached. Tiles read straight from frames
+    // cached in their native pixel format or with half precision are cached as usual.
     return Gaffer::ValuePlug::CachePolicy::Uncached;
   }
+  if (output == tileBatchPlug() || output == framePlug()) {
+    // Allow concurrent requests for tiles of the same frame to wait for, and help with, a single
+    // decode and tiling pass, or a single frame cache lookup.
+    return Gaffer::ValuePlug::CachePolicy::TaskCollaboration;
+  }
   return GafferImage::ImageNode::computeCachePolicy(output);
 }
 
@@ -246,12 +605,7 @@ void AvReader::hashFormat(const GafferImage::ImagePlug *parent,
   IECore::MurmurHash &h) const
 {
   ImageNode::hashFormat(parent, context, /*out*/ h);
-  fileNamePlug()->hash(/*out*/ h);
-  h.append(context->getFrame());
-  refreshCountPlug()->hash(/*out*/ h);
-  missingFrameModePlug()->hash(/*out*/ h);
-  videoStreamPlug()->hash(/*out*/ h);
-  filterGraphPlug()->hash(/*out*/ h);
+  frameIdentityPlug()->hash(/*out*/ h);
 
   // Check if defaults have changed.
   const auto format = GafferImage::FormatPlug::getDefaultFormat(context);
@@ -265,24 +619,24 @@ GafferImage::Format AvReader::computeFormat(const Gaffer::Context *context,
   const GafferImage::ImagePlug * /*parent*/) const
 {
   // NOTE(tohi):
-  // We cannot rely on the video stream headers here, since the pixel dimensions of
-  // the video frames could be modified by the filter graph.
+  // The pixel dimensions of the video frames could be modified by the filter graph, so we use the
+  // filtered stream header, which is known without decoding any frames.
 
-  const auto frame =
-    std::static_pointer_cast<ilp_movie::Frame>(_retrieveFrame(context, /*holdForBlack=*/true));
-  if (frame == nullptr) { return GafferImage::FormatPlug::getDefaultFormat(context); }
+  ilp_movie::InputVideoStreamHeader hdr{};
+  if (!_retrieveStreamHeader(context, /*out*/ hdr, /*holdForBlack=*/true)) {
+    return GafferImage::FormatPlug::getDefaultFormat(context);
+  }
 
   double pixelAspect = 1.0;
-  if (frame->hdr.pixel_aspect_ratio.num > 0 && frame->hdr.pixel_aspect_ratio.den > 0) {
-    pixelAspect =
-      static_cast<double>(frame->hdr.pixel_aspect_ratio.num) / frame->hdr.pixel_aspect_ratio.den;
+  if (hdr.pixel_aspect_ratio.num > 0 && hdr.pixel_aspect_ratio.den > 0) {
+    pixelAspect = static_cast<double>(hdr.pixel_aspect_ratio.num) / hdr.pixel_aspect_ratio.den;
   }
 
   // clang-format off
   return GafferImage::Format{ 
     Imath::Box2i{ 
       /*minT=*/Imath::V2i{ 0, 0 },
-      /*maxT=*/Imath::V2i{ frame->hdr.width, frame->hdr.height } },
+      /*maxT=*/Imath::V2i{ hdr.width, hdr.height } },
     pixelAspect };
   // clang-format on
 }
@@ -292,12 +646,7 @@ void AvReader::hashDataWindow(const GafferImage::ImagePlug *parent,
   IECore::MurmurHash &h) const
 {
   ImageNode::hashDataWindow(parent, context, /*out*/ h);
-  fileNamePlug()->hash(/*out*/ h);
-  h.append(context->getFrame());
-  refreshCountPlug()->hash(/*out*/ h);
-  missingFrameModePlug()->hash(/*out*/ h);
-  videoStreamPlug()->hash(/*out*/ h);
-  filterGraphPlug()->hash(/*out*/ h);
+  frameIdentityPlug()->hash(/*out*/ h);
 
   h.append(context->get<std::string>(
     GafferImage::ImagePlug::viewNameContextName, GafferImage::ImagePlug::defaultViewName));
@@ -306,17 +655,15 @@ void AvReader::hashDataWindow(const GafferImage::ImagePlug *parent,
 Imath::Box2i AvReader::computeDataWindow(const Gaffer::Context *context,
   const GafferImage::ImagePlug *parent) const
 {
-  // NOTE(tohi):
-  // We cannot rely on the video stream headers here, since the pixel dimensions of
-  // the video frames could be modified by the filter graph.
-
-  const auto frame = std::static_pointer_cast<ilp_movie::Frame>(_retrieveFrame(context));
-  if (frame == nullptr) { return parent->dataWindowPlug()->defaultValue(); }
+  ilp_movie::InputVideoStreamHeader hdr{};
+  if (!_retrieveStreamHeader(context, /*out*/ hdr)) {
+    return parent->dataWindowPlug()->defaultValue();
+  }
 
   // clang-format off
   return Imath::Box2i{ 
       /*minT=*/Imath::V2i{ 0, 0 },
-      /*maxT=*/Imath::V2i{ frame->hdr.width, frame->hdr.height } };
+      /*maxT=*/Imath::V2i{ hdr.width, hdr.height } };
   // clang-format on
 }
 
@@ -325,12 +672,7 @@ void AvReader::hashMetadata(const GafferImage::ImagePlug *parent,
   IECore::MurmurHash &h) const
 {
   GafferImage::ImageNode::hashMetadata(parent, context, /*out*/ h);
-  fileNamePlug()->hash(/*out*/ h);
-  h.append(context->getFrame());
-  refreshCountPlug()->hash(/*out*/ h);
-  missingFrameModePlug()->hash(/*out*/ h);
-  videoStreamPlug()->hash(/*out*/ h);
-  filterGraphPlug()->hash(/*out*/ h);
+  frameIdentityPlug()->hash(/*out*/ h);
   h.append(context->get<std::string>(
     GafferImage::ImagePlug::viewNameContextName, GafferImage::ImagePlug::defaultViewName));
 }
@@ -338,8 +680,10 @@ void AvReader::hashMetadata(const GafferImage::ImagePlug *parent,
 IECore::ConstCompoundDataPtr AvReader::computeMetadata(const Gaffer::Context *context,
   const GafferImage::ImagePlug *parent) const
 {
-  const auto frame = std::static_pointer_cast<ilp_movie::Frame>(_retrieveFrame(context));
-  if (frame == nullptr) { return parent->metadataPlug()->defaultValue(); }
+  ilp_movie::InputVideoStreamHeader hdr{};
+  if (!_retrieveStreamHeader(context, /*out*/ hdr)) {
+    return parent->metadataPlug()->defaultValue();
+  }
 
   // In theory we could use metadata, like written below, to perform
   // "optimal" color conversion using OCIO. In practice, however, we
@@ -349,11 +693,11 @@ IECore::ConstCompoundDataPtr AvReader::computeMetadata(const Gaffer::Context *co
 
   // clang-format off
   IECore::CompoundDataPtr result = new IECore::CompoundData;
-  result->writable()["pixelFormat"] = new IECore::StringData(frame->hdr.pix_fmt_name);// NOLINT
-  result->writable()["colorRange"] = new IECore::StringData(frame->hdr.color_range_name);// NOLINT
-  result->writable()["colorSpace"] = new IECore::StringData(frame->hdr.color_space_name);// NOLINT
-  result->writable()["colorTrc"] = new IECore::StringData(frame->hdr.color_trc_name);// NOLINT
-  result->writable()["colorPrimaries"] = new IECore::StringData(frame->hdr.color_primaries_name);// NOLINT
+  result->writable()["pixelFormat"] = new IECore::StringData(hdr.pix_fmt_name);// NOLINT
+  result->writable()["colorRange"] = new IECore::StringData(hdr.color_range_name);// NOLINT
+  result->writable()["colorSpace"] = new IECore::StringData(hdr.color_space_name);// NOLINT
+  result->writable()["colorTrc"] = new IECore::StringData(hdr.color_trc_name);// NOLINT
+  result->writable()["colorPrimaries"] = new IECore::StringData(hdr.color_primaries_name);// NOLINT
   // clang-format on
 
   return result;
@@ -386,11 +730,7 @@ void AvReader::hashSampleOffsets(const GafferImage::ImagePlug *parent,
 
   {
     ImagePlug::GlobalScope c(context);
-    fileNamePlug()->hash(/*out*/ h);
-    h.append(context->getFrame());
-    refreshCountPlug()->hash(/*out*/ h);
-    missingFrameModePlug()->hash(/*out*/ h);
-    videoStreamPlug()->hash(/*out*/ h);
+    frameIdentityPlug()->hash(/*out*/ h);
   }
 }
 
@@ -408,11 +748,7 @@ void AvReader::hashChannelNames(const GafferImage::ImagePlug *parent,
   IECore::MurmurHash &h) const
 {
   GafferImage::ImageNode::hashChannelNames(parent, context, /*out*/ h);
-  fileNamePlug()->hash(/*out*/ h);
-  h.append(context->getFrame());
-  refreshCountPlug()->hash(/*out*/ h);
-  missingFrameModePlug()->hash(/*out*/ h);
-  videoStreamPlug()->hash(/*out*/ h);
+  frameIdentityPlug()->hash(/*out*/ h);
   h.append(context->get<std::string>(
     GafferImage::ImagePlug::viewNameContextName, GafferImage::ImagePlug::defaultViewName));
 }
@@ -420,30 +756,28 @@ void AvReader::hashChannelNames(const GafferImage::ImagePlug *parent,
 IECore::ConstStringVectorDataPtr AvReader::computeChannelNames(const Gaffer::Context *context,
   const GafferImage::ImagePlug *parent) const
 {
-  auto frame = std::static_pointer_cast<ilp_movie::Frame>(_retrieveFrame(context));
-  if (frame == nullptr) { return parent->channelNamesPlug()->defaultValue(); }
+  ilp_movie::InputVideoStreamHeader hdr{};
+  if (!_retrieveStreamHeader(context, /*out*/ hdr)) {
+    return parent->channelNamesPlug()->defaultValue();
+  }
 
-  // Check if we can access channel data for the frame to determine which
-  // channels to request later.
+  // Check if we can access channel data for frames with the decoded pixel format to determine
+  // which channels to request later.
 
   std::vector<std::string> channelNames;
 
-  using ilp_movie::CompPixelData;
+  using ilp_movie::HasCompPixelData;
   namespace Comp = ilp_movie::Comp;
-  if (!Empty(CompPixelData<const float>(
-        frame->data, frame->linesize, Comp::kR, frame->hdr.height, frame->hdr.pix_fmt_name))) {
+  if (HasCompPixelData(Comp::kR, hdr.pix_fmt_name)) {
     channelNames.push_back(GafferImage::ImageAlgo::channelNameR);
   }
-  if (!Empty(CompPixelData<const float>(
-        frame->data, frame->linesize, Comp::kG, frame->hdr.height, frame->hdr.pix_fmt_name))) {
+  if (HasCompPixelData(Comp::kG, hdr.pix_fmt_name)) {
     channelNames.push_back(GafferImage::ImageAlgo::channelNameG);
   }
-  if (!Empty(CompPixelData<const float>(
-        frame->data, frame->linesize, Comp::kB, frame->hdr.height, frame->hdr.pix_fmt_name))) {
+  if (HasCompPixelData(Comp::kB, hdr.pix_fmt_name)) {
     channelNames.push_back(GafferImage::ImageAlgo::channelNameB);
   }
-  if (!Empty(CompPixelData<const float>(
-        frame->data, frame->linesize, Comp::kA, frame->hdr.height, frame->hdr.pix_fmt_name))) {
+  if (HasCompPixelData(Comp::kA, hdr.pix_fmt_name)) {
     channelNames.push_back(GafferImage::ImageAlgo::channelNameA);
   }
 
@@ -463,12 +797,14 @@ void AvReader::hashChannelData(const GafferImage::ImagePlug *parent,
 
   {
     GafferImage::ImagePlug::GlobalScope c(context);
-    fileNamePlug()->hash(/*out*/ h);
-    h.append(context->getFrame());
-    refreshCountPlug()->hash(/*out*/ h);
-    missingFrameModePlug()->hash(/*out*/ h);
-    videoStreamPlug()->hash(/*out*/ h);
-    filterGraphPlug()->hash(/*out*/ h);
+    if (readsTilesFromFrame()) {
+      // See _computeTile.
+      framePlug()->hash(/*out*/ h);
+      orientationPlug()->hash(/*out*/ h);
+      outPlug()->dataWindowPlug()->hash(/*out*/ h);
+    } else {
+      tileBatchPlug()->hash(/*out*/ h);
+    }
   }
 }
 
@@ -477,63 +813,114 @@ IECore::ConstFloatVectorDataPtr AvReader::computeChannelData(const std::string &
   const Gaffer::Context *context,
   const GafferImage::ImagePlug *parent) const
 {
-  // IECore::msg(IECore::Msg::Info,
-  //   "AvReader",
-  //   boost::format("computeChannelData - channelName = %1%, tileOrigin = (%2%, %3%)") %
-  //   channelName
-  //     % tileOrigin.x % tileOrigin.y);
+  if (readsTilesFromFrame()) {
+    return _computeTile(channelName, tileOrigin, context, parent);
+  }
 
   GafferImage::ImagePlug::GlobalScope globalScope(context);
-  auto frame = std::static_pointer_cast<ilp_movie::Frame>(_retrieveFrame(context));
-  if (frame == nullptr) { return parent->channelDataPlug()->defaultValue(); }
+  const IECore::ConstObjectVectorPtr tileBatch = tileBatchPlug()->getValue();
+  if (tileBatch->members().empty()) { return parent->channelDataPlug()->defaultValue(); }
 
-  // Determine which component/channel we want to access.
-  namespace Comp = ilp_movie::Comp;
-  Comp::ValueType c = Comp::kUnknown;
-  if (channelName == GafferImage::ImageAlgo::channelNameR) {
-    c = ilp_movie::Comp::kR;
-  } else if (channelName == GafferImage::ImageAlgo::channelNameG) {
-    c = ilp_movie::Comp::kG;
-  } else if (channelName == GafferImage::ImageAlgo::channelNameB) {
-    c = ilp_movie::Comp::kB;
-  } else if (channelName == GafferImage::ImageAlgo::channelNameA) {
-    c = ilp_movie::Comp::kA;
-  } else {
-    throw IECore::Exception("Unexpected channel name");
-  }
-
-  using ilp_movie::CompPixelData;
-  const auto pix = CompPixelData<const float>(
-    frame->data, frame->linesize, c, frame->hdr.height, frame->hdr.pix_fmt_name);
-  if (Empty(pix)) { throw IECore::Exception("Empty pixel data"); }
+  // Find the tile in the batch.
+  const IECore::ConstStringVectorDataPtr channelNamesData =
+    outPlug()->channelNamesPlug()->getValue();
+  const auto &channelNames = channelNamesData->readable();
+  const auto channelIt = std::find(channelNames.begin(), channelNames.end(), channelName);
+  if (channelIt == channelNames.end()) { throw IECore::Exception("Unexpected channel name"); }
 
   const Imath::Box2i dataWindow = outPlug()->dataWindowPlug()->getValue();
-  const Imath::Box2i tileBound(
-    /*minT=*/tileOrigin,
-    /*maxT=*/tileOrigin + Imath::V2i(GafferImage::ImagePlug::tileSize()));
-  if (!GafferImage::BufferAlgo::intersects(dataWindow, tileBound)) {
-    throw IECore::Exception(
-      boost::str(boost::format("AvReader : Invalid tile (%i,%i) -> (%i,%i) not within "
-                               "data window (%i,%i) -> (%i,%i).")
-                 % tileBound.min.x % tileBound.min.y % tileBound.max.x % tileBound.max.y
-                 % dataWindow.min.x % dataWindow.min.y % dataWindow.max.x % dataWindow.max.y));
+  checkTileBound(dataWindow,
+    Imath::Box2i(/*minT=*/tileOrigin,
+      /*maxT=*/tileOrigin + Imath::V2i(GafferImage::ImagePlug::tileSize())));
+
+  const TileBatchLayout layout{ dataWindow };
+  const auto channelIndex =
+    static_cast<std::size_t>(std::distance(channelNames.begin(), channelIt));
+  const std::size_t i = layout.index(channelIndex, tileOrigin);
+  if (!(i < tileBatch->members().size())) { throw IECore::Exception("Tile not in tile batch"); }
+  return IECore::runTimeCast<const IECore::FloatVectorData>(tileBatch->members()[i]);
+}
+
+IECore::ConstObjectVectorPtr AvReader::_computeTileBatch(const Gaffer::Context *context) const
+{
+  IECore::ObjectVectorPtr result = new IECore::ObjectVector;
+
+  const auto frame =
+    std::static_pointer_cast<const cached_frame_internal::CachedFrame>(_retrieveFrame(context));
+  if (frame == nullptr) { return result; }
+  const bool flipVertical =
+    orientationPlug()->getValue() == static_cast<int>(Orientation::FlipVertical);
+
+  const IECore::ConstStringVectorDataPtr channelNamesData =
+    outPlug()->channelNamesPlug()->getValue();
+  const auto &channelNames = channelNamesData->readable();
+
+  // Determine which components/channels to access.
+  std::vector<ilp_movie::Comp::ValueType> comps;
+  comps.reserve(channelNames.size());
+  for (auto &&channelName : channelNames) {
+    const ilp_movie::Comp::ValueType c = channelComp(channelName);
+    if (c == ilp_movie::Comp::kUnknown) { throw IECore::Exception("Unexpected channel name"); }
+    if (!frame->hasComp(c)) { throw IECore::Exception("Empty pixel data"); }
+    comps.push_back(c);
   }
 
-  IECore::FloatVectorDataPtr tileData = new IECore::FloatVectorData(
-    std::vector<float>(static_cast<size_t>(GafferImage::ImagePlug::tilePixels())));
-  auto &tile = tileData->writable();
+  const Imath::Box2i dataWindow = outPlug()->dataWindowPlug()->getValue();
+  const TileBatchLayout layout{ dataWindow };
+  auto &members = result->members();
+  members.resize(channelNames.size() * layout.tilesPerChannel());
+
+  // Copy regions into tiles, one row of tiles per task. Each task writes to its own tiles.
+  tbb::task_group_context taskGroupContext(tbb::task_group_context::isolated);
+  tbb::parallel_for(
+    tbb::blocked_range<int>(0, layout.numTiles.y),
+    [&](const tbb::blocked_range<int> &range) {
+      for (int tileY = range.begin(); tileY != range.end(); ++tileY) {
+        for (int tileX = 0; tileX < layout.numTiles.x; ++tileX) {
+          const Imath::V2i tileOrigin = layout.tileOrigin(tileX, tileY);
+          for (std::size_t ch = 0U; ch < comps.size(); ++ch) {
+            IECore::FloatVectorDataPtr tileData = new IECore::FloatVectorData(
+              std::vector<float>(static_cast<size_t>(GafferImage::ImagePlug::tilePixels())));
+            readTile(*frame, comps[ch], tileOrigin, dataWindow, flipVertical, tileData->writable());
+            members[layout.index(ch, tileOrigin)] = std::move(tileData);
+          }
+        }
+      }
+    },
+    taskGroupContext);
 
-  const Imath::Box2i tileRegion = GafferImage::BufferAlgo::intersection(tileBound, dataWindow);
+  return result;
+}
 
-  constexpr auto kTileSize = static_cast<size_t>(GafferImage::ImagePlug::tileSize());
-  for (int y = tileRegion.min.y; y < tileRegion.max.y; ++y) {
-    float *dst = &tile[static_cast<size_t>(y - tileRegion.min.y) * kTileSize];
-    const float *src =
-      &(pix.data[static_cast<size_t>(y) * static_cast<size_t>(frame->hdr.width)// NOLINT
-                 + static_cast<size_t>(tileRegion.min.x)]);
-    std::memcpy(dst, src, sizeof(float) * static_cast<size_t>(tileRegion.max.x - tileRegion.min.x));
-  }
+IECore::ConstFloatVectorDataPtr AvReader::_computeTile(const std::string &channelName,
+  const Imath::V2i &tileOrigin,
+  const Gaffer::Context *context,
+  const GafferImage::ImagePlug *parent) const
+{
+  // The frame is looked up once per frame, only the pixels of the tile are read per tile.
+  GafferImage::ImagePlug::GlobalScope globalScope(context);
+  const auto frameObject =
+    IECore::runTimeCast<const cached_frame_internal::CachedFrameObject>(framePlug()->getValue());
+  if (frameObject == nullptr) { throw IECore::Exception("Unexpected cached frame"); }
+  const auto &frame = frameObject->frame();
+  if (frame == nullptr) { return parent->channelDataPlug()->defaultValue(); }
+
+  const ilp_movie::Comp::ValueType c = channelComp(channelName);
+  if (c == ilp_movie::Comp::kUnknown) { throw IECore::Exception("Unexpected channel name"); }
+  if (!frame->hasComp(c)) { throw IECore::Exception("Empty pixel data"); }
 
+  const Imath::Box2i dataWindow = outPlug()->dataWindowPlug()->getValue();
+  checkTileBound(dataWindow,
+    Imath::Box2i(/*minT=*/tileOrigin,
+      /*maxT=*/tileOrigin + Imath::V2i(GafferImage::ImagePlug::tileSize())));
+
+  // Frames cached in their native pixel format or with half precision only convert the pixels
+  // of this tile and channel.
+  IECore::FloatVectorDataPtr tileData = new IECore::FloatVectorData(
+    std::vector<float>(static_cast<size_t>(GafferImage::ImagePlug::tilePixels())));
+  const bool flipVertical =
+    orientationPlug()->getValue() == static_cast<int>(Orientation::FlipVertical);
+  readTile(*frame, c, tileOrigin, dataWindow, flipVertical, tileData->writable());
   return tileData;
 }
 
@@ -569,23 +956,10 @@ std::shared_ptr<void> AvReader::_retrieveDecoder(const Gaffer::Context *context)
 {
   const std::string fileName = fileNamePlug()->getValue();
   if (fileName.empty()) { return nullptr; }
-  std::string resolvedFileName = context->substitute(fileName);
 
-  // TODO(tohi): We are never including alpha values here. We 
-  //             would need a way to check if this is needed.
-
-  static const std::string kPixFmtName = "gbrpf32le";
-
-  // clang-format off
+  // Decoders return raw frames, which are shared by all filter graphs.
   const auto decoderEntry = shared_decoders_internal::SharedDecoders::get(
-    /*key=*/shared_decoders_internal::DecoderCacheKey{ 
-      /*.fileName=*/std::move(resolvedFileName),
-      /*.filterGraphDescr=*/{ 
-        /*.filter_descr=*/_filterGraph(context),
-        /*.out_pix_fmt_name=*/kPixFmtName
-      } 
-    });
-  // clang-format on
+    /*key=*/shared_decoders_internal::rawDecoderKey(context->substitute(fileName)));
 
   if (decoderEntry.decoder == nullptr) {
     throw IECore::Exception(decoderEntry.error != nullptr ? decoderEntry.error->c_str() : "");
@@ -594,31 +968,104 @@ std::shared_ptr<void> AvReader::_retrieveDecoder(const Gaffer::Context *context)
   return decoderEntry.decoder;
 }// namespace IlpGafferMovie
 
-std::shared_ptr<void> AvReader::_retrieveFrame(const Gaffer::Context *context,
+bool AvReader::_retrieveStreamHeader(const Gaffer::Context *context,
+  ilp_movie::InputVideoStreamHeader &hdr,
   const bool holdForBlack) const
 {
-  const std::string fileName = fileNamePlug()->getValue();
-  if (fileName.empty()) { return nullptr; }
+  const auto idx = _videoStreamIndex(context);
+  if (!idx.has_value()) { return false; }
+
+  const int decoderHandle = decoderHandlePlug()->getValue();
+  if (decoderHandle == shared_decoders_internal::kInvalidDecoderHandle) { return false; }
+
+  const auto filterEntry = shared_filters_internal::SharedFilters::get(
+    /*key=*/shared_filters_internal::FilterCacheKey{
+      /*.decoder_handle=*/decoderHandle, /*.video_stream_index=*/*idx });
+  if (filterEntry.filter == nullptr) {
+    throw IECore::Exception(filterEntry.error != nullptr ? filterEntry.error->c_str() : "");
+  }
+
+  const auto filteredHdr = filterEntry.filter->OutputHeader();
+  const auto frameNb = static_cast<int64_t>(context->getFrame());
+  if (filteredHdr.has_value() && filteredHdr->first_frame_nb <= frameNb
+      && frameNb < filteredHdr->first_frame_nb + filteredHdr->frame_count) {
+    hdr = *filteredHdr;
+    return true;
+  }
+
+  // Missing frame, same logic as in _retrieveFrame. All frames in a stream share the same
+  // header, so holding simply means using the stream header.
+  auto mode = static_cast<AvReader::MissingFrameMode>(missingFrameModePlug()->getValue());
+  if (holdForBlack && mode == AvReader::MissingFrameMode::Black) {
+    mode = AvReader::MissingFrameMode::Hold;
+  }
+
+  if (mode == AvReader::MissingFrameMode::Black) { return false; }
+  if (mode == AvReader::MissingFrameMode::Hold && filteredHdr.has_value()
+      && filteredHdr->frame_count > 0) {
+    hdr = *filteredHdr;
+    return true;
+  }
+  throw IECore::Exception(boost::str(
+    boost::format("AvReader : Frame %i not available in video stream") % frameNb));
+}
+
+std::optional<int> AvReader::_resolveFrameNb(const Gaffer::Context *context) const
+{
+  const int frameNb = static_cast<int>(context->getFrame());
+  const auto mode = static_cast<AvReader::MissingFrameMode>(missingFrameModePlug()->getValue());
+  if (mode == AvReader::MissingFrameMode::Error) {
+    // Missing frames are errors, no need to check which frames are available.
+    return frameNb;
+  }
+
+  IECore::ConstIntVectorDataPtr frameData = availableFramesPlug()->getValue();
+  auto &&frames = frameData->readable();
+  auto fIt = std::lower_bound(frames.begin(), frames.end(), frameNb);
+  if (fIt != frames.end() && *fIt == frameNb) { return frameNb; }
+
+  if (mode == AvReader::MissingFrameMode::Black) { return std::nullopt; }
+  if (frames.empty()) { return frameNb; }
+
+  // Hold the previous frame, unless this is before the first frame, in which case we hold to
+  // the beginning of the sequence.
+  if (fIt != frames.begin()) { fIt = std::prev(fIt); }
+  return *fIt;
+}
+
+std::shared_ptr<const void> AvReader::_retrieveFrame(const Gaffer::Context *context,
+  const bool holdForBlack) const
+{
+  const int decoderHandle = decoderHandlePlug()->getValue();
+  if (decoderHandle == shared_decoders_internal::kInvalidDecoderHandle) { return nullptr; }
 
   const auto idx = _videoStreamIndex(context);
   if (!idx.has_value()) { return nullptr; }
 
   const int frameNb = static_cast<int>(context->getFrame());
+  const int colorProcessorHandle = colorProcessorHandlePlug()->getValue();
 
   // clang-format off
-  auto frameEntry = shared_frames_internal::SharedFrames::get(
-    /*key=*/shared_frames_internal::FrameCacheKey{
-      /*.decoder_key=*/shared_decoders_internal::DecoderCacheKey{ 
-        /*.fileName=*/context->substitute(fileName),
-        /*.filterGraphDescr=*/{ 
-          /*.filter_descr=*/_filterGraph(context),
-          /*.out_pix_fmt_name=*/"gbrpf32le" 
-        } 
-      },
-      /*.video_stream_index=*/*idx,
-      /*.frame_nb=*/frameNb
-    });
+  const shared_frames_internal::FrameCacheKey frameKey{
+    /*.decoder_handle=*/decoderHandle,
+    /*.video_stream_index=*/*idx,
+    /*.frame_nb=*/frameNb,
+    /*.color_processor_handle=*/colorProcessorHandle
+  };
   // clang-format on
+  auto frameEntry = shared_frames_internal::SharedFrames::get(frameKey, context->canceller());
+
+  // Decode the next frames in the background during playback. Prefetching is only a hint, so
+  // it doesn't affect the output.
+  if (const int window = prefetchFramesPlug()->getValue();
+      window > 0 && frameEntry.frame != nullptr) {
+    IECore::ConstIntVectorDataPtr frameData = availableFramesPlug()->getValue();
+    auto &&frames = frameData->readable();
+    if (!frames.empty()) {
+      frame_prefetcher_internal::FramePrefetcher::request(
+        frameKey, window, frames.front(), frames.back());
+    }
+  }
 
   if (frameEntry.frame == nullptr) {
     auto mode = static_cast<AvReader::MissingFrameMode>(missingFrameModePlug()->getValue());
@@ -646,19 +1093,16 @@ std::shared_ptr<void> AvReader::_retrieveFrame(const Gaffer::Context *context,
         Gaffer::Context::EditableScope holdScope(context);
         holdScope.setFrame(static_cast<float>(*fIt));
 
+        // The file name, filter graph and color space may depend on the frame.
         // clang-format off
         frameEntry = shared_frames_internal::SharedFrames::get(
           /*key=*/shared_frames_internal::FrameCacheKey{
-            /*.decoder_key=*/shared_decoders_internal::DecoderCacheKey{ 
-              /*.fileName=*/holdScope.context()->substitute(fileName),
-              /*.filterGraphDescr=*/{ 
-                /*.filter_descr=*/_filterGraph(holdScope.context()),
-                /*.out_pix_fmt_name=*/"gbrpf32le" 
-              } 
-            },
+            /*.decoder_handle=*/decoderHandlePlug()->getValue(),
             /*.video_stream_index=*/*idx,
-            /*.frame_nb=*/static_cast<int>(holdScope.context()->getFrame())
-          });
+            /*.frame_nb=*/static_cast<int>(holdScope.context()->getFrame()),
+            /*.color_processor_handle=*/colorProcessorHandlePlug()->getValue()
+          },
+          context->canceller());
         // clang-format on
       }
 
@@ -677,22 +1121,20 @@ std::shared_ptr<void> AvReader::_retrieveFrame(const Gaffer::Context *context,
 
 void AvReader::_plugSet(Gaffer::Plug *plug)
 {
-  // NOTE(tohi):
-  // Potentially clears decoders and frames for ALL AvReader nodes...
-
   if (plug == refreshCountPlug()) {
-    // This clears the cache every time the refresh count is updated, so we don't have
-    // entries from old files hanging around.
-    shared_frames_internal::SharedFrames::clear();
-    shared_decoders_internal::SharedDecoders::clear();
+    // Only drop decoders and frames for files that have changed on disk since they were opened,
+    // so that refreshing one node doesn't throw away valid frames cached for other nodes. Frames
+    // are erased last, so that frames requested concurrently are not decoded or filtered using a
+    // stale decoder or filter.
+    for (auto &&fileName : shared_decoders_internal::SharedDecoders::staleFiles()) {
+      shared_decoders_internal::SharedDecoders::eraseFile(fileName);
+      shared_filters_internal::SharedFilters::eraseFile(fileName);
+      shared_frames_internal::SharedFrames::eraseFile(fileName);
+    }
   }
 
-  if (plug == filterGraphPlug()) {
-    // This clears the frame cache every time the filter graph is updated, since
-    // this may cause frames to be rescaled, i.e. alter the pixel dimensions.
-    // Opened decoders are still valid.
-    shared_frames_internal::SharedFrames::clear();
-  }
+  // Note that there is no need to clear anything when the filter graph is updated. Filtered
+  // frames are cached per filter graph, and raw frames don't depend on the filter graph.
 }
 
 }// namespace IlpGafferMovie
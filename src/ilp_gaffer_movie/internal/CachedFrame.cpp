@@ -0,0 +1,243 @@
+#include "internal/CachedFrame.h"
+
+#include <cstring>// std::memcpy
+#include <utility>// std::move
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include "ilp_movie/convert.hpp"// ilp_movie::FloatToHalf, ilp_movie::ConvertFrameRegion, etc
+#include "ilp_movie/trace.hpp"// ILP_MOVIE_TRACE_SPAN_ARG
+
+namespace {
+
+// Rows converted per task.
+constexpr int kRowsPerBand = 32;
+
+constexpr std::array<ilp_movie::Comp::ValueType, 4> kComps = {
+  ilp_movie::Comp::kR,
+  ilp_movie::Comp::kG,
+  ilp_movie::Comp::kB,
+  ilp_movie::Comp::kA,
+};
+
+}// namespace
+
+namespace IlpGafferMovie::cached_frame_internal {
+
+CachedFrame::CachedFrame(std::unique_ptr<ilp_movie::Frame> frame) noexcept
+  : _decoded{ std::move(frame) }
+{
+  _initFloatPlanes();
+}
+
+void CachedFrame::_initFloatPlanes() noexcept
+{
+  // Looking up the planes requires parsing the pixel format name, so do it once.
+  for (auto &&c : kComps) {
+    _floatPlanes.at(static_cast<std::size_t>(c)) =
+      ilp_movie::CompPixelData<const float>(*_decoded, c).data;
+  }
+}
+
+std::shared_ptr<CachedFrame> CachedFrame::makeHalf(const ilp_movie::Frame &frame)
+{
+  std::array<ilp_movie::PixelData<const float>, 4> src = {};
+  std::size_t planeCount = 0U;
+  for (auto &&c : kComps) {
+    src.at(static_cast<std::size_t>(c)) = ilp_movie::CompPixelData<const float>(frame, c);
+    if (!Empty(src.at(static_cast<std::size_t>(c)))) {
+      ++planeCount;
+    } else if (c != ilp_movie::Comp::kA) {
+      return nullptr;
+    }
+  }
+
+  ILP_MOVIE_TRACE_SPAN_ARG("frame cache", "store half", "height", frame.hdr.height);
+  const auto width = static_cast<std::size_t>(frame.hdr.width);
+  const auto planeSize = width * static_cast<std::size_t>(frame.hdr.height);
+
+  // Not using make_shared, the constructor is private.
+  std::shared_ptr<CachedFrame> result{ new CachedFrame };
+  result->_storage = FrameStorage::Half;
+  result->_hdr = frame.hdr;
+  result->_halfBuf = std::make_unique<uint16_t[]>(planeCount * planeSize);// NOLINT
+  std::array<uint16_t *, 4> dst = {};
+  std::size_t plane = 0U;
+  for (auto &&c : kComps) {
+    const auto i = static_cast<std::size_t>(c);
+    if (Empty(src.at(i))) { continue; }
+    dst.at(i) = result->_halfBuf.get() + plane * planeSize;// NOLINT
+    result->_halfPlanes.at(i) = dst.at(i);
+    ++plane;
+  }
+
+  // Rows are contiguous within each plane, so a band of rows is converted in a single call.
+  tbb::task_group_context taskGroupContext(tbb::task_group_context::isolated);
+  tbb::parallel_for(
+    tbb::blocked_range<int>(0, frame.hdr.height, static_cast<size_t>(kRowsPerBand)),
+    [&](const tbb::blocked_range<int> &range) {
+      const std::size_t offset = static_cast<std::size_t>(range.begin()) * width;
+      const auto n = static_cast<int>(static_cast<std::size_t>(range.size()) * width);
+      for (std::size_t i = 0U; i < dst.size(); ++i) {
+        if (dst.at(i) == nullptr) { continue; }
+        ilp_movie::FloatToHalf(src.at(i).data + offset, dst.at(i) + offset, n);// NOLINT
+      }
+    },
+    tbb::simple_partitioner(),
+    taskGroupContext);
+  return result;
+}
+
+std::shared_ptr<CachedFrame> CachedFrame::makeNativeYuv(std::shared_ptr<const CachedFrame> raw,
+  const ilp_movie::ConvertOptions &opts)
+{
+  const ilp_movie::Frame *frame = raw != nullptr ? raw->decoded() : nullptr;
+  if (frame == nullptr) { return nullptr; }
+
+  ilp_movie::FrameView view{};
+  view.hdr = frame->hdr;
+  view.data = frame->data;
+  view.linesize = frame->linesize;
+  view.buf = frame->buf.get();
+
+  // Converting a single pixel also rejects color matrices that are not supported natively, for
+  // which the frame filter falls back to the filter graph.
+  float pixel = 0.F;
+  if (!ilp_movie::CanConvertFrame(frame->hdr.pix_fmt_name, ilp_movie::PixFmt::kRGB_P_F32)
+      || !ilp_movie::ConvertFrameRegion(view,
+        ilp_movie::Comp::kR,
+        /*x=*/0,
+        /*y=*/0,
+        /*w=*/1,
+        /*h=*/1,
+        &pixel,
+        /*dst_stride=*/1,
+        opts)) {
+    return nullptr;
+  }
+
+  // Not using make_shared, the constructor is private.
+  std::shared_ptr<CachedFrame> result{ new CachedFrame };
+  result->_storage = FrameStorage::NativeYuv;
+  result->_hdr = frame->hdr;
+  result->_hdr.pix_fmt_name = ilp_movie::PixFmt::kRGB_P_F32;
+  result->_hdr.color_range_name = ilp_movie::ColorRange::kPc;
+  result->_hdr.color_space_name = "gbr";
+  result->_raw = std::move(raw);
+  result->_rawView = view;
+  result->_convertOptions = opts;
+  return result;
+}
+
+std::shared_ptr<CachedFrame> CachedFrame::makeMapped(const ilp_movie::FrameHeader &hdr,
+  std::shared_ptr<const uint8_t> pixels)
+{
+  if (pixels == nullptr) { return nullptr; }
+  auto frame = std::make_unique<ilp_movie::Frame>();
+  frame->hdr = hdr;
+  // The planes are never written to, the frame is only exposed as const.
+  if (!ilp_movie::FillArrays(/*out*/ frame->data,
+        /*out*/ frame->linesize,
+        pixels.get(),
+        hdr.pix_fmt_name,
+        hdr.width,
+        hdr.height)) {
+    return nullptr;
+  }
+
+  // Not using make_shared, the constructor is private.
+  std::shared_ptr<CachedFrame> result{ new CachedFrame };
+  result->_storage = FrameStorage::Mapped;
+  result->_decoded = std::move(frame);
+  result->_mapped = std::move(pixels);
+  result->_initFloatPlanes();
+  return result;
+}
+
+FrameStorage CachedFrame::storage() const noexcept { return _storage; }
+
+const ilp_movie::FrameHeader &CachedFrame::header() const noexcept
+{
+  return _decoded != nullptr ? _decoded->hdr : _hdr;
+}
+
+const ilp_movie::Frame *CachedFrame::decoded() const noexcept { return _decoded.get(); }
+
+std::shared_ptr<const CachedFrame> CachedFrame::rawFrame() const noexcept { return _raw; }
+
+size_t CachedFrame::memoryCost() const noexcept
+{
+  const auto &hdr = header();
+  switch (_storage) {
+  case FrameStorage::Decoded:
+  case FrameStorage::Mapped: {
+    // Mapped pages can be reclaimed by the OS, but are counted so that the memory limit also
+    // bounds the pages touched while reading frames back from disk.
+    const auto bufSize = ilp_movie::GetBufferSize(hdr.pix_fmt_name, hdr.width, hdr.height);
+    return sizeof(CachedFrame) + sizeof(ilp_movie::Frame) + bufSize.value_or(0U);
+  }
+  case FrameStorage::Half: {
+    std::size_t planeCount = 0U;
+    for (auto &&p : _halfPlanes) { planeCount += p != nullptr ? 1U : 0U; }
+    return sizeof(CachedFrame)
+           + planeCount * static_cast<std::size_t>(hdr.width)
+               * static_cast<std::size_t>(hdr.height) * sizeof(uint16_t);
+  }
+  case FrameStorage::NativeYuv:
+    // The raw frame is counted here, the frame cache drops its own entry for it.
+    return sizeof(CachedFrame) + _raw->memoryCost();
+  }
+  return sizeof(CachedFrame);
+}
+
+bool CachedFrame::hasComp(const ilp_movie::Comp::ValueType c) const noexcept
+{
+  if (c < 0 || static_cast<std::size_t>(c) >= _halfPlanes.size()) { return false; }
+  const auto i = static_cast<std::size_t>(c);
+  switch (_storage) {
+  case FrameStorage::Decoded:
+  case FrameStorage::Mapped:
+    return _floatPlanes.at(i) != nullptr;
+  case FrameStorage::Half:
+    return _halfPlanes.at(i) != nullptr;
+  case FrameStorage::NativeYuv:
+    return c != ilp_movie::Comp::kA;
+  }
+  return false;
+}
+
+bool CachedFrame::readRegion(const ilp_movie::Comp::ValueType c,
+  const int x,
+  const int y,
+  const int w,
+  const int h,
+  const bool flipVertical,
+  float *dst,
+  const std::ptrdiff_t dstStride) const noexcept
+{
+  if (_storage == FrameStorage::NativeYuv) {
+    // Only the rows and columns of the raw frame needed for the region are converted.
+    ilp_movie::ConvertOptions opts = _convertOptions;
+    opts.vflip = opts.vflip != flipVertical;
+    return ilp_movie::ConvertFrameRegion(_rawView, c, x, y, w, h, dst, dstStride, opts);
+  }
+
+  const auto &hdr = header();
+  const auto i = static_cast<std::size_t>(c);
+  for (int j = 0; j < h; ++j) {
+    const int srcY = flipVertical ? hdr.height - 1 - (y + j) : y + j;
+    const std::size_t offset = static_cast<std::size_t>(srcY) * static_cast<std::size_t>(hdr.width)
+                               + static_cast<std::size_t>(x);
+    float *row = dst + j * dstStride;// NOLINT
+    if (_storage != FrameStorage::Half) {
+      std::memcpy(// NOLINT
+        row, _floatPlanes.at(i) + offset, sizeof(float) * static_cast<std::size_t>(w));
+    } else {
+      ilp_movie::HalfToFloat(_halfPlanes.at(i) + offset, row, w);// NOLINT
+    }
+  }
+  return true;
+}
+
+}// namespace IlpGafferMovie::cached_frame_internal
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>// std::array
+#include <cstddef>// size_t, std::ptrdiff_t
+#include <cstdint>// uint16_t
+#include <memory>// std::unique_ptr, std::shared_ptr
+
+#include "ilp_gaffer_movie/ilp_gaffer_movie_export.hpp"
+
+#include "ilp_movie/convert.hpp"// ilp_movie::ConvertOptions
+#include "ilp_movie/frame.hpp"// ilp_movie::Frame, ilp_movie::Comp
+
+namespace IlpGafferMovie {
+namespace cached_frame_internal {
+
+  // How the pixels of a cached frame are stored.
+  enum class FrameStorage {
+    // As decoded (or filtered), i.e. an ilp_movie::Frame.
+    Decoded = 0,
+
+    // Planar float frames stored with half precision planes, which halves the memory used by
+    // the frame. Expanded to float when rows are read.
+    Half = 1,
+
+    // Frames that are a native pixel format conversion of a raw frame, e.g. yuv422p10le to
+    // gbrpf32le, are not converted up front. The pixels of the raw frame are shared and regions
+    // are converted to float when read, so the frame costs as much memory as the raw frame.
+    NativeYuv = 2,
+
+    // Decoded frames read back from the disk cache, with planes pointing into a memory-mapped
+    // file. Behaves as decoded, except that the pixels are paged in from the file when touched.
+    Mapped = 3,
+  };
+
+  // A frame in the frame cache. Regions of components are read as floats regardless of how the
+  // frame is stored, so that the storage is transparent to the code extracting tiles.
+  class ILPGAFFERMOVIE_NO_EXPORT CachedFrame
+  {
+  public:
+    // Stores the frame as is.
+    explicit CachedFrame(std::unique_ptr<ilp_movie::Frame> frame) noexcept;
+
+    // Returns a copy of a planar float frame, e.g. gbrpf32le, with half precision planes.
+    // Rows are converted in parallel. Returns null if the frame is not planar float.
+    [[nodiscard]] static std::shared_ptr<CachedFrame> makeHalf(const ilp_movie::Frame &frame);
+
+    // Returns a frame that reads as the raw frame converted to gbrpf32le with the given options,
+    // e.g. from FrameFilter::NativeConvert, while sharing the pixels of the raw frame. Returns
+    // null if the raw frame is not stored as decoded or the conversion is not supported.
+    [[nodiscard]] static std::shared_ptr<CachedFrame> makeNativeYuv(
+      std::shared_ptr<const CachedFrame> raw,
+      const ilp_movie::ConvertOptions &opts);
+
+    // Returns a frame whose planes point into pixels laid out as by ilp_movie::FillArrays, e.g.
+    // a memory-mapped file, without copying them. The pixels are released, e.g. unmapped, when
+    // the last reference to them is dropped. Returns null if the header is not valid.
+    [[nodiscard]] static std::shared_ptr<CachedFrame> makeMapped(const ilp_movie::FrameHeader &hdr,
+      std::shared_ptr<const uint8_t> pixels);
+
+    // Not copyable or movable.
+    CachedFrame(const CachedFrame &rhs) = delete;
+    CachedFrame &operator=(const CachedFrame &rhs) = delete;
+    CachedFrame(CachedFrame &&rhs) = delete;
+    CachedFrame &operator=(CachedFrame &&rhs) = delete;
+    ~CachedFrame() = default;
+
+    [[nodiscard]] FrameStorage storage() const noexcept;
+
+    // The header of the frame as decoded (or filtered), i.e. the pixel format is the float format
+    // for frames stored as half or native YUV.
+    [[nodiscard]] const ilp_movie::FrameHeader &header() const noexcept;
+
+    // The decoded frame, null for frames not stored as decoded or mapped. The buffer of mapped
+    // frames is null, the planes are owned by the mapping.
+    [[nodiscard]] const ilp_movie::Frame *decoded() const noexcept;
+
+    // The raw frame that frames stored as native YUV share pixels with, null otherwise.
+    [[nodiscard]] std::shared_ptr<const CachedFrame> rawFrame() const noexcept;
+
+    // Memory, in [bytes], used by the frame.
+    [[nodiscard]] size_t memoryCost() const noexcept;
+
+    // Returns true if the component can be read as floats.
+    [[nodiscard]] bool hasComp(ilp_movie::Comp::ValueType c) const noexcept;
+
+    // Copies a region of the component, w values wide and h rows high, to dst with dstStride
+    // floats between rows. Row j of the region is row y + j of the frame, or of the vertically
+    // flipped frame if flipVertical is set. The component must be readable, see hasComp, and the
+    // region must be within the frame. Returns false if the region cannot be converted.
+    [[nodiscard]] bool readRegion(ilp_movie::Comp::ValueType c,
+      int x,
+      int y,
+      int w,
+      int h,
+      bool flipVertical,
+      float *dst,
+      std::ptrdiff_t dstStride) const noexcept;
+
+  private:
+    CachedFrame() noexcept = default;
+
+    // Looks up the float planes of the decoded frame.
+    void _initFloatPlanes() noexcept;
+
+    FrameStorage _storage = FrameStorage::Decoded;
+    std::unique_ptr<ilp_movie::Frame> _decoded;
+
+    // Mapped storage, the pixels referenced by the planes of the decoded frame.
+    std::shared_ptr<const uint8_t> _mapped;
+
+    // Float planes of the decoded frame, indexed by component, null if not planar float.
+    std::array<const float *, 4> _floatPlanes = {};
+
+    // Header of frames not stored as decoded.
+    ilp_movie::FrameHeader _hdr = {};
+
+    // Half storage, planes (of width * height values) indexed by component, null if missing.
+    std::unique_ptr<uint16_t[]> _halfBuf;// NOLINT
+    std::array<const uint16_t *, 4> _halfPlanes = {};
+
+    // Native YUV storage, a view of the shared raw frame.
+    std::shared_ptr<const CachedFrame> _raw;
+    ilp_movie::FrameView _rawView = {};
+    ilp_movie::ConvertOptions _convertOptions = {};
+  };
+
+}// namespace cached_frame_internal
+}// namespace IlpGafferMovie
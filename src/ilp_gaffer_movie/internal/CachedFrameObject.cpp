@@ -0,0 +1,59 @@
+#include "internal/CachedFrameObject.h"
+
+#include <cstdint>// uint64_t, uintptr_t
+#include <utility>// std::move
+
+#include <IECore/Exception.h>
+#include <IECore/MurmurHash.h>
+
+namespace IlpGafferMovie::cached_frame_internal {
+
+IE_CORE_DEFINEOBJECTTYPEDESCRIPTION(CachedFrameObject);
+
+CachedFrameObject::CachedFrameObject(std::shared_ptr<const CachedFrame> frame) noexcept
+  : _frame{ std::move(frame) }
+{}
+
+const std::shared_ptr<const CachedFrame> &CachedFrameObject::frame() const noexcept
+{
+  return _frame;
+}
+
+bool CachedFrameObject::isEqualTo(const IECore::Object *other) const
+{
+  if (!IECore::Object::isEqualTo(other)) { return false; }
+  return static_cast<const CachedFrameObject *>(other)->_frame == _frame;// NOLINT
+}
+
+void CachedFrameObject::hash(IECore::MurmurHash &h) const
+{
+  IECore::Object::hash(h);
+  h.append(static_cast<uint64_t>(reinterpret_cast<std::uintptr_t>(_frame.get())));// NOLINT
+}
+
+void CachedFrameObject::copyFrom(const IECore::Object *other, IECore::Object::CopyContext *context)
+{
+  IECore::Object::copyFrom(other, context);
+  _frame = static_cast<const CachedFrameObject *>(other)->_frame;// NOLINT
+}
+
+void CachedFrameObject::save(IECore::Object::SaveContext * /*context*/) const
+{
+  throw IECore::Exception("CachedFrameObject : Cannot save cached frames");
+}
+
+void CachedFrameObject::load(IECore::Object::LoadContextPtr /*context*/)
+{
+  throw IECore::Exception("CachedFrameObject : Cannot load cached frames");
+}
+
+void CachedFrameObject::memoryUsage(IECore::Object::MemoryAccumulator &a) const
+{
+  IECore::Object::memoryUsage(a);
+
+  // The frame is shared with the frame cache, but it is kept alive for as long as this object
+  // is held, so it counts towards the memory used by Gaffer's cache too.
+  if (_frame != nullptr) { a.accumulate(_frame.get(), _frame->memoryCost()); }
+}
+
+}// namespace IlpGafferMovie::cached_frame_internal
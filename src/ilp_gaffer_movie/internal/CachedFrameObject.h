@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>// std::shared_ptr
+
+#include <IECore/Object.h>
+
+#include "ilp_gaffer_movie/ilp_gaffer_movie_export.hpp"
+#include "ilp_gaffer_movie/type_id.hpp"
+
+#include "internal/CachedFrame.h"
+
+namespace IlpGafferMovie {
+namespace cached_frame_internal {
+
+  // Wraps a cached frame so that it can be the value of a plug, and thereby be held by Gaffer's
+  // compute cache. The frame is shared, not copied, and objects are equal if they share the same
+  // frame. Cannot be saved or loaded.
+  class ILPGAFFERMOVIE_NO_EXPORT CachedFrameObject : public IECore::Object
+  {
+  public:
+    explicit CachedFrameObject(std::shared_ptr<const CachedFrame> frame = nullptr) noexcept;
+
+    IE_CORE_DECLAREEXTENSIONOBJECT(IlpGafferMovie::cached_frame_internal::CachedFrameObject,
+      IlpGafferMovie::TypeId::kCachedFrameObjectTypeId,
+      IECore::Object);
+
+    // The frame, null if there is no frame, e.g. for missing frames returned as black.
+    [[nodiscard]] const std::shared_ptr<const CachedFrame> &frame() const noexcept;
+
+  private:
+    std::shared_ptr<const CachedFrame> _frame;
+  };
+
+  IE_CORE_DECLAREPTR(CachedFrameObject)
+
+}// namespace cached_frame_internal
+}// namespace IlpGafferMovie
@@ -0,0 +1,251 @@
+#include "internal/DecodeScheduler.h"
+
+#include <array>// std::array
+#include <condition_variable>// std::condition_variable
+#include <cstdint>// uint64_t
+#include <mutex>// std::mutex, std::lock_guard, std::unique_lock
+#include <queue>// std::priority_queue
+#include <unordered_map>// std::unordered_map
+#include <utility>// std::move
+#include <vector>// std::vector
+
+#include <IECore/Canceller.h>// IECore::Cancelled
+
+#include <tbb/task_arena.h>
+
+#include "ilp_movie/trace.hpp"// ILP_MOVIE_TRACE_SPAN
+
+namespace {
+
+using IlpGafferMovie::decode_scheduler_internal::CancellationTokenPtr;
+using IlpGafferMovie::decode_scheduler_internal::DecodePriority;
+
+// Speculative work only uses a few threads, to avoid competing with the threads computing the
+// images that are actually requested.
+constexpr int kMaxThreads = 2;
+
+constexpr std::size_t kNumPriorities = 3U;
+
+thread_local DecodePriority t_priority = DecodePriority::kInteractive;
+thread_local CancellationTokenPtr t_token;
+
+[[nodiscard]] bool isCancelled(const CancellationTokenPtr &token)
+{
+  return token != nullptr && token->cancelled();
+}
+
+class Scheduler
+{
+public:
+  void submit(const DecodePriority priority,
+    CancellationTokenPtr token,
+    std::function<void()> work)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _jobs.push(Job{ priority, _nextSeq++, std::move(token), std::move(work) });
+    startRunners();
+  }
+
+  bool runWithDecoder(const void *decoder, const std::function<bool()> &decode)
+  {
+    const DecodePriority priority = t_priority;
+    const CancellationTokenPtr token = t_token;
+    const auto p = static_cast<std::size_t>(priority);
+    const bool interactive = priority == DecodePriority::kInteractive;
+
+    std::unique_lock<std::mutex> lock{ _mutex };
+    Gate &gate = _gates[decoder];
+    ++gate.waiting.at(p);
+    if (interactive) { ++_interactive; }
+    {
+      ILP_MOVIE_TRACE_SPAN_ARG("scheduler", "wait for decoder", "priority", p);
+      _cv.wait(lock, [&] { return isCancelled(token) || (!gate.busy && !gate.moreUrgent(p)); });
+    }
+    --gate.waiting.at(p);
+    if (isCancelled(token)) {
+      leave(decoder, gate, interactive);
+      throw IECore::Cancelled();
+    }
+    gate.busy = true;
+    lock.unlock();
+
+    bool result = false;
+    try {
+      result = decode();
+    } catch (...) {
+      lock.lock();
+      gate.busy = false;
+      leave(decoder, gate, interactive);
+      throw;
+    }
+
+    lock.lock();
+    gate.busy = false;
+    leave(decoder, gate, interactive);
+    return result;
+  }
+
+  void notifyAll()
+  {
+    // Lock to avoid missed wake-ups between checking the predicate and waiting.
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _cv.notify_all();
+  }
+
+  [[nodiscard]] std::size_t numQueued()
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    return _jobs.size();
+  }
+
+private:
+  struct Job
+  {
+    DecodePriority priority = DecodePriority::kBackground;
+    uint64_t seq = 0U;
+    CancellationTokenPtr token;
+    std::function<void()> work;
+  };
+
+  // Most urgent first, first in first out for equal priority.
+  struct JobOrder
+  {
+    bool operator()(const Job &a, const Job &b) const
+    {
+      return a.priority != b.priority ? a.priority > b.priority : a.seq > b.seq;
+    }
+  };
+
+  struct Gate
+  {
+    bool busy = false;
+    std::array<int, kNumPriorities> waiting = {};
+
+    [[nodiscard]] bool moreUrgent(const std::size_t p) const
+    {
+      for (std::size_t i = 0U; i < p; ++i) {
+        if (waiting.at(i) > 0) { return true; }
+      }
+      return false;
+    }
+
+    [[nodiscard]] bool idle() const
+    {
+      if (busy) { return false; }
+      for (auto &&w : waiting) {
+        if (w > 0) { return false; }
+      }
+      return true;
+    }
+  };
+
+  // Called with the lock held, when a thread is done with a decoder.
+  void leave(const void *decoder, const Gate &gate, const bool interactive)
+  {
+    if (interactive) { --_interactive; }
+    if (gate.idle()) { _gates.erase(decoder); }
+    _cv.notify_all();
+    startRunners();
+  }
+
+  // Called with the lock held. Speculative work is not started while interactive decodes are
+  // in progress, runners are started again once these have finished.
+  void startRunners()
+  {
+    while (_runners < kMaxThreads && !_jobs.empty() && _interactive == 0) {
+      ++_runners;
+      arena().enqueue([this]() { run(); });
+    }
+  }
+
+  void run()
+  {
+    for (;;) {
+      Job job;
+      {
+        std::lock_guard<std::mutex> lock{ _mutex };
+        if (_jobs.empty() || _interactive > 0) {
+          --_runners;
+          return;
+        }
+        job = _jobs.top();
+        _jobs.pop();
+      }
+      if (isCancelled(job.token)) { continue; }
+
+      IlpGafferMovie::decode_scheduler_internal::DecodeScheduler::Scope scope{ job.priority,
+        job.token };
+      try {
+        job.work();
+      } catch (...) {// NOLINT
+        // Speculative work has no one to report errors to.
+      }
+    }
+  }
+
+  static tbb::task_arena &arena()
+  {
+    // No threads are reserved for the caller, enqueued work runs on worker threads only. Never
+    // destroyed, since work may still be running when static objects are destroyed.
+    static auto *arena = new tbb::task_arena(kMaxThreads, /*reserved_for_masters=*/0);// NOLINT
+    return *arena;
+  }
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::priority_queue<Job, std::vector<Job>, JobOrder> _jobs;
+  uint64_t _nextSeq = 0U;
+  int _runners = 0;
+
+  // Interactive decodes in progress, including those waiting for a decoder.
+  int _interactive = 0;
+
+  std::unordered_map<const void *, Gate> _gates;
+};
+
+Scheduler &scheduler()
+{
+  static Scheduler scheduler;
+  return scheduler;
+}
+
+}// namespace
+
+namespace IlpGafferMovie::decode_scheduler_internal {
+
+void CancellationToken::cancel()
+{
+  _cancelled.store(true, std::memory_order_release);
+  scheduler().notifyAll();
+}
+
+DecodeScheduler::Scope::Scope(const DecodePriority priority, CancellationTokenPtr token)
+  : _prevPriority{ t_priority }, _prevToken{ std::move(t_token) }
+{
+  t_priority = priority;
+  t_token = std::move(token);
+}
+
+DecodeScheduler::Scope::~Scope()
+{
+  t_priority = _prevPriority;
+  t_token = std::move(_prevToken);
+}
+
+void DecodeScheduler::submit(const DecodePriority priority,
+  CancellationTokenPtr token,
+  std::function<void()> work)
+{
+  scheduler().submit(priority, std::move(token), std::move(work));
+}
+
+bool DecodeScheduler::runWithDecoder(const void *decoder, const std::function<bool()> &decode)
+{
+  return scheduler().runWithDecoder(decoder, decode);
+}
+
+CancellationTokenPtr DecodeScheduler::currentToken() { return t_token; }
+
+size_t DecodeScheduler::numQueued() { return scheduler().numQueued(); }
+
+}// namespace IlpGafferMovie::decode_scheduler_internal
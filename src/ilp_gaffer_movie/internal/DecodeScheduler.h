@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>// std::atomic
+#include <cstddef>// size_t
+#include <functional>// std::function
+#include <memory>// std::shared_ptr
+
+#include "ilp_gaffer_movie/ilp_gaffer_movie_export.hpp"
+
+namespace IlpGafferMovie {
+namespace decode_scheduler_internal {
+
+  // Lower values are more urgent.
+  enum class DecodePriority {
+    // Frames that someone is waiting for, e.g. the frame under the playhead.
+    kInteractive = 0,
+    // Speculative work that is likely to be needed soon, e.g. the next frame during playback.
+    kNormal,
+    // Speculative work that may never be needed.
+    kBackground,
+  };
+
+  // Shared by speculative work that becomes stale together, e.g. prefetching along a playback
+  // pattern that is abandoned when the playhead jumps.
+  class ILPGAFFERMOVIE_NO_EXPORT CancellationToken
+  {
+  public:
+    // Also wakes up work waiting for a decoder, so that it can give up.
+    void cancel();
+    [[nodiscard]] bool cancelled() const { return _cancelled.load(std::memory_order_acquire); }
+
+  private:
+    std::atomic<bool> _cancelled{ false };
+  };
+
+  using CancellationTokenPtr = std::shared_ptr<CancellationToken>;
+
+  // Schedules decoding so that interactive requests don't wait behind speculative work. Each
+  // decoder is used by one thread at a time, and when a decoder becomes available it is given
+  // to the most urgent waiting thread. Speculative work is queued and run in priority order on a
+  // small pool of threads, and is not started while interactive decodes are in progress.
+  class ILPGAFFERMOVIE_NO_EXPORT DecodeScheduler
+  {
+  public:
+    // Sets the priority, and cancellation token, of decodes on the current thread for the
+    // lifetime of the scope. Decodes outside any scope are interactive and cannot be cancelled.
+    class Scope
+    {
+    public:
+      explicit Scope(DecodePriority priority, CancellationTokenPtr token = nullptr);
+      ~Scope();
+
+      Scope(const Scope &) = delete;
+      Scope &operator=(const Scope &) = delete;
+      Scope(Scope &&) = delete;
+      Scope &operator=(Scope &&) = delete;
+
+    private:
+      DecodePriority _prevPriority;
+      CancellationTokenPtr _prevToken;
+    };
+
+    // Queues speculative work. Work is dropped without running if the token has been cancelled
+    // by the time it would start.
+    static void submit(DecodePriority priority,
+      CancellationTokenPtr token,
+      std::function<void()> work);
+
+    // Runs decode with exclusive use of the decoder, with the priority of the current thread.
+    // Throws IECore::Cancelled if the token of the current thread is cancelled, either before or
+    // while waiting for the decoder.
+    static bool runWithDecoder(const void *decoder, const std::function<bool()> &decode);
+
+    // Returns the cancellation token of the current thread, null outside any scope.
+    static CancellationTokenPtr currentToken();
+
+    // Returns the number of queued speculative jobs.
+    static size_t numQueued();
+  };
+
+}// namespace decode_scheduler_internal
+}// namespace IlpGafferMovie
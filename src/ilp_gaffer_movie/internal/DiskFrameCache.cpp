@@ -0,0 +1,542 @@
+#include "internal/DiskFrameCache.h"
+
+#include <atomic>// std::atomic
+#include <cerrno>// errno, EINTR, EEXIST
+#include <condition_variable>// std::condition_variable
+#include <cstdint>// uint8_t, uint64_t
+#include <cstdlib>// std::getenv, std::strtoull
+#include <deque>// std::deque
+#include <list>// std::list
+#include <mutex>// std::mutex, std::lock_guard, std::unique_lock
+#include <optional>// std::optional
+#include <thread>// std::thread
+#include <unordered_map>// std::unordered_map
+#include <utility>// std::move
+
+#include <fcntl.h>// ::open
+#include <sys/mman.h>// ::mmap, ::munmap, ::madvise
+#include <sys/stat.h>// ::mkdir, ::fstat
+#include <unistd.h>// ::write, ::close, ::unlink, ::rename, ::rmdir, ::getpid
+
+#include <boost/format.hpp>
+#include <boost/functional/hash.hpp>// boost::hash
+
+#include <IECore/MessageHandler.h>// IECore::msg
+
+#include "ilp_movie/frame.hpp"// ilp_movie::GetBufferSize
+#include "ilp_movie/trace.hpp"// ILP_MOVIE_TRACE_SPAN_ARG
+
+namespace {
+
+using CacheKey = IlpGafferMovie::shared_frames_internal::FrameCacheKey;
+using IlpGafferMovie::cached_frame_internal::CachedFrame;
+using IlpGafferMovie::disk_frame_cache_internal::DiskFrameCacheStatistics;
+
+constexpr size_t kBytesPerMb = 1024U * 1024U;
+
+// Default size limit, used unless overridden by the environment.
+constexpr size_t kDefaultSizeLimitMb = 16384U;
+
+// Frames waiting to be written are held in memory, on top of the memory limit of the frame
+// cache, so only a few are queued. Frames evicted while the queue is full are not written, which
+// only happens if frames are evicted faster than the disk can write them.
+constexpr size_t kMaxPendingWrites = 4U;
+
+[[nodiscard]] std::string initialDirectory()
+{
+  const char *env = std::getenv("ILP_GAFFER_MOVIE_DISK_CACHE_DIR");// NOLINT
+  return env != nullptr ? std::string{ env } : std::string{};
+}
+
+[[nodiscard]] size_t initialSizeLimit()
+{
+  size_t mb = kDefaultSizeLimitMb;
+  if (const char *env = std::getenv("ILP_GAFFER_MOVIE_DISK_CACHE_MB"); env != nullptr) {// NOLINT
+    char *end = nullptr;
+    const auto value = std::strtoull(env, &end, /*base=*/10);
+    if (end != env && *end == '\0') { mb = static_cast<size_t>(value); }
+  }
+  return mb * kBytesPerMb;
+}
+
+// Writes all bytes, retrying interrupted and partial writes.
+[[nodiscard]] bool writeAll(const int fd, const uint8_t *data, size_t size)
+{
+  while (size > 0U) {
+    const ssize_t n = ::write(fd, data, size);
+    if (n < 0) {
+      if (errno == EINTR) { continue; }
+      return false;
+    }
+    data += n;// NOLINT
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// The file is written under a temporary name and then renamed, so that a file is either
+// complete or missing.
+[[nodiscard]] bool writeFile(const std::string &path, const uint8_t *data, const size_t size)
+{
+  const std::string tmpPath = path + ".tmp";
+  const int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);// NOLINT
+  if (fd < 0) { return false; }
+  const bool written = writeAll(fd, data, size);
+  const bool closed = ::close(fd) == 0;
+  if (!(written && closed && ::rename(tmpPath.c_str(), path.c_str()) == 0)) {
+    ::unlink(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Maps a file read-only. The file is unmapped when the last reference is dropped, and stays
+// readable until then even if the file is removed.
+[[nodiscard]] std::shared_ptr<const uint8_t> mapFile(const std::string &path, const size_t size)
+{
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);// NOLINT
+  if (fd < 0) { return nullptr; }
+
+  // Touching pages past the end of a truncated file would raise SIGBUS.
+  struct stat st = {};
+  if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != size) {
+    ::close(fd);
+    return nullptr;
+  }
+  void *addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, /*offset=*/0);
+  ::close(fd);
+  if (addr == MAP_FAILED) { return nullptr; }// NOLINT
+
+  // Frames are typically read in full right away, e.g. when filtering, so start reading ahead.
+  ::madvise(addr, size, MADV_WILLNEED);
+  try {
+    return std::shared_ptr<const uint8_t>(
+      static_cast<const uint8_t *>(addr), [size](const uint8_t *p) {
+        ::munmap(const_cast<uint8_t *>(p), size);// NOLINT
+      });
+  } catch (...) {
+    ::munmap(addr, size);
+    throw;
+  }
+}
+
+class DiskCache
+{
+public:
+  // Never destroyed, since frames may still be evicted when static objects are destroyed. Files
+  // are removed, and the writer thread stopped, on exit by close, see RemoveFilesOnExit.
+  [[nodiscard]] static DiskCache &instance()
+  {
+    static auto *cache = new DiskCache;// NOLINT
+    return *cache;
+  }
+
+  // Not copyable or movable.
+  DiskCache(const DiskCache &rhs) = delete;
+  DiskCache &operator=(const DiskCache &rhs) = delete;
+  DiskCache(DiskCache &&rhs) = delete;
+  DiskCache &operator=(DiskCache &&rhs) = delete;
+
+  void setDirectory(const std::string &directory)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    if (directory == _directory) { return; }
+    _removeAllLocked();
+    _directory = directory;
+    _warned = false;
+    _enabled.store(!_directory.empty() && !_closed, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::string directory()
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    return _directory;
+  }
+
+  void setSizeLimit(const size_t bytes)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _sizeLimit = bytes;
+    _trimLocked();
+  }
+
+  [[nodiscard]] size_t sizeLimit()
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    return _sizeLimit;
+  }
+
+  // Checked without locking, e.g. when frames are evicted from memory.
+  [[nodiscard]] bool enabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+  void store(const CacheKey &key, std::shared_ptr<const CachedFrame> frame)
+  {
+    if (!enabled() || frame == nullptr || frame->decoded() == nullptr
+        || frame->decoded()->buf == nullptr) {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock{ _mutex };
+      if (_directory.empty() || _closed || _entries.count(key) > 0U || _pending.count(key) > 0U
+          || _queue.size() >= kMaxPendingWrites) {
+        return;
+      }
+
+      // Frames are written on a thread of their own, rather than as decode work, so that writes
+      // neither wait for nor hold up decodes, and the queue keeps draining during playback.
+      if (!_writer.joinable()) {
+        try {
+          _writer = std::thread{ [this]() { _run(); } };
+        } catch (...) {
+          _warnLocked("Cannot start disk cache writer");
+          return;
+        }
+      }
+      const uint64_t ticket = ++_ticketCount;
+      _queue.push_back(PendingWrite{ key, std::move(frame), ticket });
+      _pending.emplace(key, ticket);
+    }
+    _wakeCv.notify_one();
+  }
+
+  [[nodiscard]] std::shared_ptr<const CachedFrame> load(const CacheKey &key)
+  {
+    if (!enabled()) { return nullptr; }
+
+    Entry entry{};
+    {
+      std::lock_guard<std::mutex> lock{ _mutex };
+      const auto it = _entries.find(key);
+      if (it == _entries.end()) { return nullptr; }
+      _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+      entry = it->second;
+    }
+
+    ILP_MOVIE_TRACE_SPAN_ARG("frame cache", "load frame", "frame", key.frame_nb);
+    std::shared_ptr<const CachedFrame> frame;
+    if (auto pixels = mapFile(entry.path, entry.size); pixels != nullptr) {
+      frame = CachedFrame::makeMapped(entry.hdr, std::move(pixels));
+    }
+    if (frame == nullptr) {
+      // E.g. the file was removed from the scratch directory, forget about it.
+      erase(key);
+      return nullptr;
+    }
+    {
+      std::lock_guard<std::mutex> lock{ _mutex };
+      ++_hits;
+    }
+    return frame;
+  }
+
+  void erase(const CacheKey &key)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _pending.erase(key);
+    if (const auto it = _entries.find(key); it != _entries.end()) { _removeLocked(it); }
+  }
+
+  void eraseDecoder(const IlpGafferMovie::shared_decoders_internal::DecoderHandle decoderHandle)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    for (auto it = _pending.begin(); it != _pending.end();) {
+      if (it->first.decoder_handle == decoderHandle) {
+        it = _pending.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    for (auto it = _entries.begin(); it != _entries.end();) {
+      if (it->first.decoder_handle == decoderHandle) {
+        it = _removeLocked(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _removeAllLocked();
+  }
+
+  // Stops the writer, removes all files and disables the cache, called on exit.
+  void close()
+  {
+    {
+      std::lock_guard<std::mutex> lock{ _mutex };
+      _closed = true;
+      _enabled.store(false, std::memory_order_relaxed);
+    }
+    _wakeCv.notify_one();
+
+    // A write in progress is finished, and its file removed, before the files are removed.
+    if (_writer.joinable()) { _writer.join(); }
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _removeAllLocked();
+  }
+
+  [[nodiscard]] DiskFrameCacheStatistics statistics()
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    DiskFrameCacheStatistics stats{};
+    stats.sizeLimit = _sizeLimit;
+    stats.usage = _usage;
+    stats.hits = _hits;
+    stats.writes = _writes;
+    return stats;
+  }
+
+  void resetStatistics()
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _hits = 0U;
+    _writes = 0U;
+  }
+
+private:
+  // The header is kept in memory, the file only holds the pixel buffer. The strings of the
+  // header are static libav strings, which is fine since the files never outlive the process.
+  struct Entry
+  {
+    ilp_movie::FrameHeader hdr = {};
+    size_t size = 0U;
+    std::string path;
+    std::list<CacheKey>::iterator lruIt;
+  };
+
+  // A frame waiting to be written. The ticket identifies the write, see _pending.
+  struct PendingWrite
+  {
+    CacheKey key = {};
+    std::shared_ptr<const CachedFrame> frame;
+    uint64_t ticket = 0U;
+  };
+
+  using EntryMap = std::unordered_map<CacheKey, Entry, boost::hash<CacheKey>>;
+
+  DiskCache() = default;
+  ~DiskCache() = default;
+
+  // Runs on the writer thread, until the cache is closed.
+  void _run()
+  {
+    std::unique_lock<std::mutex> lock{ _mutex };
+    while (true) {
+      _wakeCv.wait(lock, [this]() { return _closed || !_queue.empty(); });
+      if (_closed) { return; }
+      {
+        const PendingWrite w = std::move(_queue.front());
+        _queue.pop_front();
+        lock.unlock();
+        _write(w.key, *w.frame, w.ticket);
+      }
+      lock.lock();
+    }
+  }
+
+  // Returns true if the write is still wanted, i.e. the frame has not been erased since it was
+  // queued.
+  [[nodiscard]] bool _currentLocked(const CacheKey &key, const uint64_t ticket) const
+  {
+    const auto it = _pending.find(key);
+    return !_closed && it != _pending.end() && it->second == ticket;
+  }
+
+  void _donePendingLocked(const CacheKey &key, const uint64_t ticket)
+  {
+    if (const auto it = _pending.find(key); it != _pending.end() && it->second == ticket) {
+      _pending.erase(it);
+    }
+  }
+
+  void _write(const CacheKey &key, const CachedFrame &frame, const uint64_t ticket)
+  {
+    ILP_MOVIE_TRACE_SPAN_ARG("frame cache", "write frame", "frame", key.frame_nb);
+    const ilp_movie::Frame &f = *frame.decoded();
+    const auto size = ilp_movie::GetBufferSize(f.hdr.pix_fmt_name, f.hdr.width, f.hdr.height);
+
+    std::string path;
+    {
+      std::lock_guard<std::mutex> lock{ _mutex };
+      if (!_currentLocked(key, ticket) || !size.has_value() || *size > _sizeLimit) {
+        _donePendingLocked(key, ticket);
+        return;
+      }
+      path = _newPathLocked(key);
+    }
+
+    // Written without holding the lock, the file is not in the index until it is complete.
+    const bool written = !path.empty() && writeFile(path, f.buf.get(), *size);
+
+    std::lock_guard<std::mutex> lock{ _mutex };
+    const bool current = _currentLocked(key, ticket);
+    _donePendingLocked(key, ticket);
+    if (!written) {
+      _warnLocked("Cannot write frame to disk cache directory");
+      return;
+    }
+    if (!current || _entries.count(key) > 0U) {
+      // Erased while being written.
+      ::unlink(path.c_str());
+      return;
+    }
+    _lru.push_front(key);
+    _entries.emplace(key, Entry{ f.hdr, *size, std::move(path), _lru.begin() });
+    _usage += *size;
+    ++_writes;
+    _trimLocked();
+  }
+
+  // Returns the path of a new file for the frame, creating the directory of the process if
+  // needed. Files are never overwritten, so that a file that is being mapped is never replaced.
+  // Returns an empty string if the directory cannot be created.
+  [[nodiscard]] std::string _newPathLocked(const CacheKey &key)
+  {
+    if (_processDirectory.empty()) {
+      std::string dir =
+        boost::str(boost::format("%s/ilp_gaffer_movie.%d") % _directory % ::getpid());
+      if (::mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {// NOLINT
+        _warnLocked("Cannot create disk cache directory");
+        return std::string{};
+      }
+      _processDirectory = std::move(dir);
+    }
+    return boost::str(boost::format("%s/%d_%d_%d_%d.frame") % _processDirectory
+                      % key.decoder_handle % key.video_stream_index % key.frame_nb
+                      % ++_fileCount);
+  }
+
+  EntryMap::iterator _removeLocked(const EntryMap::iterator it)
+  {
+    ::unlink(it->second.path.c_str());
+    _usage -= it->second.size;
+    _lru.erase(it->second.lruIt);
+    return _entries.erase(it);
+  }
+
+  void _removeAllLocked()
+  {
+    _queue.clear();
+    _pending.clear();
+    for (auto &&[key, entry] : _entries) { ::unlink(entry.path.c_str()); }
+    _entries.clear();
+    _lru.clear();
+    _usage = 0U;
+    if (!_processDirectory.empty()) {
+      // Fails if writes are still in progress, in which case the directory is left behind.
+      ::rmdir(_processDirectory.c_str());
+      _processDirectory.clear();
+    }
+  }
+
+  // Removes the least recently used files until the size limit is met.
+  void _trimLocked()
+  {
+    while (_usage > _sizeLimit && !_lru.empty()) { _removeLocked(_entries.find(_lru.back())); }
+  }
+
+  // Warns once per directory, the disk cache is an optimization so errors are not fatal.
+  void _warnLocked(const char *message)
+  {
+    if (_warned) { return; }
+    _warned = true;
+    IECore::msg(IECore::Msg::Warning,
+      "DiskFrameCache",
+      boost::format("%s \"%s\" (errno %d)") % message % _directory % errno);
+  }
+
+  std::mutex _mutex;
+  std::atomic<bool> _enabled{ !initialDirectory().empty() };
+  std::string _directory = initialDirectory();
+  std::string _processDirectory;
+  size_t _sizeLimit = initialSizeLimit();
+  bool _closed = false;
+  bool _warned = false;
+
+  uint64_t _fileCount = 0U;
+
+  EntryMap _entries;
+  std::list<CacheKey> _lru;// Most recently used first.
+  size_t _usage = 0U;
+
+  // Frames queued for, or being written by, the writer thread, mapped to the ticket of the
+  // write. Erasing a frame removes it here, so that only the writes of erased frames are
+  // dropped, and a frame stored again after being erased gets a new ticket.
+  std::unordered_map<CacheKey, uint64_t, boost::hash<CacheKey>> _pending;
+  std::deque<PendingWrite> _queue;
+  uint64_t _ticketCount = 0U;
+  std::condition_variable _wakeCv;
+  std::thread _writer;
+
+  size_t _hits = 0U;
+  size_t _writes = 0U;
+};
+
+// Removes the files of the process on exit.
+class RemoveFilesOnExit
+{
+public:
+  RemoveFilesOnExit() = default;
+  ~RemoveFilesOnExit() { DiskCache::instance().close(); }
+
+  // Not copyable or movable.
+  RemoveFilesOnExit(const RemoveFilesOnExit &rhs) = delete;
+  RemoveFilesOnExit &operator=(const RemoveFilesOnExit &rhs) = delete;
+  RemoveFilesOnExit(RemoveFilesOnExit &&rhs) = delete;
+  RemoveFilesOnExit &operator=(RemoveFilesOnExit &&rhs) = delete;
+};
+
+const RemoveFilesOnExit removeFilesOnExit;
+
+}// namespace
+
+namespace IlpGafferMovie::disk_frame_cache_internal {
+
+void DiskFrameCache::setDirectory(const std::string &directory)
+{
+  DiskCache::instance().setDirectory(directory);
+}
+
+std::string DiskFrameCache::getDirectory() { return DiskCache::instance().directory(); }
+
+void DiskFrameCache::setSizeLimit(const size_t bytes) { DiskCache::instance().setSizeLimit(bytes); }
+
+size_t DiskFrameCache::getSizeLimit() { return DiskCache::instance().sizeLimit(); }
+
+bool DiskFrameCache::enabled() { return DiskCache::instance().enabled(); }
+
+void DiskFrameCache::store(const shared_frames_internal::FrameCacheKey &key,
+  std::shared_ptr<const cached_frame_internal::CachedFrame> frame)
+{
+  DiskCache::instance().store(key, std::move(frame));
+}
+
+std::shared_ptr<const cached_frame_internal::CachedFrame> DiskFrameCache::load(
+  const shared_frames_internal::FrameCacheKey &key)
+{
+  return DiskCache::instance().load(key);
+}
+
+void DiskFrameCache::erase(const shared_frames_internal::FrameCacheKey &key)
+{
+  DiskCache::instance().erase(key);
+}
+
+void DiskFrameCache::eraseDecoder(const shared_decoders_internal::DecoderHandle decoderHandle)
+{
+  DiskCache::instance().eraseDecoder(decoderHandle);
+}
+
+void DiskFrameCache::clear() { DiskCache::instance().clear(); }
+
+DiskFrameCacheStatistics DiskFrameCache::statistics()
+{
+  return DiskCache::instance().statistics();
+}
+
+void DiskFrameCache::resetStatistics() { DiskCache::instance().resetStatistics(); }
+
+}// namespace IlpGafferMovie::disk_frame_cache_internal
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>// size_t
+#include <memory>// std::shared_ptr
+#include <string>// std::string
+
+#include "ilp_gaffer_movie/ilp_gaffer_movie_export.hpp"
+
+#include "internal/CachedFrame.h"
+#include "internal/SharedDecoders.h"
+#include "internal/SharedFrames.h"
+
+namespace IlpGafferMovie {
+namespace disk_frame_cache_internal {
+
+  struct DiskFrameCacheStatistics
+  {
+    // [bytes]
+    size_t sizeLimit = 0U;
+    size_t usage = 0U;
+
+    // Frames read back from disk instead of being decoded, and frames written to disk.
+    size_t hits = 0U;
+    size_t writes = 0U;
+  };
+
+  // Second tier of the frame cache, see SharedFrames. Raw frames evicted from memory are written
+  // to a local scratch directory, one file per frame, and mapped back into memory when they are
+  // needed again, which is much faster than decoding them again, in particular from network
+  // storage. Files hold the pixel buffer of the frame as is, so frames are read back without
+  // copying and pages are only read from disk when touched.
+  //
+  // The index is keyed on the interned decoder handle, which is only valid for the lifetime of
+  // the process, so files are written to a directory private to the process and are removed when
+  // erased, when the least recently used files are trimmed to meet the size limit, and on exit.
+  class ILPGAFFERMOVIE_NO_EXPORT DiskFrameCache
+  {
+  public:
+    // Sets the scratch directory, an empty string disables the disk cache. Files are written to
+    // a sub-directory, which is created when needed. Changing the directory erases all files.
+    // Defaults to the ILP_GAFFER_MOVIE_DISK_CACHE_DIR environment variable.
+    static void setDirectory(const std::string &directory);
+    static std::string getDirectory();
+
+    // Sets the limit, in [bytes], for the size of the files on disk. Least recently used files
+    // are removed when the limit is exceeded. Defaults to 16384 MB, or to
+    // ILP_GAFFER_MOVIE_DISK_CACHE_MB megabytes if that environment variable is set.
+    static void setSizeLimit(size_t bytes);
+    static size_t getSizeLimit();
+
+    // Returns true if a scratch directory is set.
+    static bool enabled();
+
+    // Queues a raw frame, stored as decoded, to be written to disk by a writer thread of the
+    // disk cache. Does nothing if the frame is already on disk or being written, or if too many
+    // frames are waiting to be written, which bounds the memory held by the queue.
+    static void store(const shared_frames_internal::FrameCacheKey &key,
+      std::shared_ptr<const cached_frame_internal::CachedFrame> frame);
+
+    // Returns the frame mapped from disk, or null if the frame is not on disk or cannot be
+    // mapped. The frame is marked as the most recently used.
+    static std::shared_ptr<const cached_frame_internal::CachedFrame> load(
+      const shared_frames_internal::FrameCacheKey &key);
+
+    // Erase a single frame, all frames decoded using the given (raw) decoder handle, or all
+    // frames, including those waiting to be written. Writes of other frames are not affected.
+    // Frames that are currently mapped stay valid until they are released.
+    static void erase(const shared_frames_internal::FrameCacheKey &key);
+    static void eraseDecoder(shared_decoders_internal::DecoderHandle decoderHandle);
+    static void clear();
+
+    // Returns usage and counters accumulated since the last call to resetStatistics.
+    static DiskFrameCacheStatistics statistics();
+    static void resetStatistics();
+  };
+
+}// namespace disk_frame_cache_internal
+}// namespace IlpGafferMovie
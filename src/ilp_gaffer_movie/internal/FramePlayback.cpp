@@ -0,0 +1,189 @@
+#include "internal/FramePlayback.h"
+
+#include <algorithm>// std::sort, std::min, std::max
+#include <cstdlib>// std::abs
+#include <limits>// std::numeric_limits
+
+#include "internal/SharedDecoders.h"
+
+namespace {
+
+using Key = IlpGafferMovie::frame_playback_internal::FramePlayback::Key;
+using IlpGafferMovie::frame_playback_internal::Playhead;
+
+// Requests that move the playhead at most this many frames are considered to be playback,
+// larger moves start a new playback range. Allows for some dropped frames.
+constexpr int kMaxPlaybackStep = 2;
+
+void movePlayhead(Playhead &ph, const int frame)
+{
+  if (ph.frame < 0) {
+    ph = Playhead{ frame, /*direction=*/0, /*first=*/frame, /*last=*/frame };
+    return;
+  }
+
+  const int step = frame - ph.frame;
+  if (step == 0) { return; }
+
+  if (std::abs(step) <= kMaxPlaybackStep) {
+    // Continued playback.
+    ph.direction = step > 0 ? 1 : -1;
+    ph.first = std::min(ph.first, frame);
+    ph.last = std::max(ph.last, frame);
+  } else if (ph.direction > 0 && std::abs(frame - ph.first) < kMaxPlaybackStep
+             && ph.last - ph.frame < kMaxPlaybackStep) {
+    // Wrapped around to the start of the range, keep looping forward.
+  } else if (ph.direction < 0 && std::abs(ph.last - frame) < kMaxPlaybackStep
+             && ph.frame - ph.first < kMaxPlaybackStep) {
+    // Wrapped around to the end of the range, keep looping backward.
+  } else {
+    // Jumped somewhere else, start a new playback range.
+    ph = Playhead{ frame, /*direction=*/0, /*first=*/frame, /*last=*/frame };
+    return;
+  }
+  ph.frame = frame;
+}
+
+// Returns the (estimated) number of frames until the given frame is requested again. Larger is
+// a better candidate for eviction.
+[[nodiscard]] int64_t nextUseDistance(const Playhead &ph, const int frame)
+{
+  // Frames outside the playback range are not expected to be needed at all, evict these first.
+  constexpr int64_t kOutsideRange = int64_t{ 1 } << 32;
+
+  const auto f = static_cast<int64_t>(frame);
+  const auto p = static_cast<int64_t>(ph.frame);
+  const auto first = static_cast<int64_t>(ph.first);
+  const auto last = static_cast<int64_t>(ph.last);
+  if (ph.direction == 0) {
+    // Not playing, keep frames close to the playhead.
+    return std::abs(f - p);
+  }
+  if (f < first || last < f) { return kOutsideRange + std::abs(f - p); }
+  if (ph.direction > 0) { return f > p ? f - p : (last - p) + (f - first) + 1; }
+  return f < p ? p - f : (p - first) + (last - f) + 1;
+}
+
+// Frames from the same video stream share a playhead.
+[[nodiscard]] Key streamKey(const Key &key)
+{
+  Key k = key;
+  k.frame_nb = -1;
+  return k;
+}
+
+}// namespace
+
+namespace IlpGafferMovie::frame_playback_internal {
+
+void FramePlayback::request(const Key &key)
+{
+  std::lock_guard<std::mutex> lock{ _mutex };
+  movePlayhead(_playheads[streamKey(key)], key.frame_nb);
+  if (auto it = _entries.find(key); it != _entries.end()) { it->second.lastRequest = ++_clock; }
+}
+
+void FramePlayback::insert(const Key &key, const size_t cost)
+{
+  std::lock_guard<std::mutex> lock{ _mutex };
+  _entries[key] = Entry{ cost, ++_clock };
+}
+
+void FramePlayback::remove(const Key &key)
+{
+  std::lock_guard<std::mutex> lock{ _mutex };
+  _entries.erase(key);
+}
+
+void FramePlayback::clear()
+{
+  std::lock_guard<std::mutex> lock{ _mutex };
+  _playheads.clear();
+}
+
+bool FramePlayback::wouldKeep(const Key &key, const size_t cost, const size_t available)
+{
+  if (cost <= available) { return true; }
+
+  std::lock_guard<std::mutex> lock{ _mutex };
+  const auto ph = _playheads.find(streamKey(key));
+  if (ph == _playheads.end()) { return false; }
+  const int64_t distance = nextUseDistance(ph->second, key.frame_nb);
+  size_t releasable = 0U;
+  for (auto &&[k, entry] : _entries) {
+    if (k == key) { continue; }
+    const auto kph = _playheads.find(streamKey(k));
+    if (kph == _playheads.end() || nextUseDistance(kph->second, k.frame_nb) > distance) {
+      releasable += entry.cost;
+      if (available + releasable >= cost) { return true; }
+    }
+  }
+  return false;
+}
+
+size_t FramePlayback::streamFrameCost(const Key &key)
+{
+  std::lock_guard<std::mutex> lock{ _mutex };
+  const Key s = streamKey(key);
+  for (auto &&[k, entry] : _entries) {
+    if (streamKey(k) == s && entry.cost > 1U) { return entry.cost; }
+  }
+  return 0U;
+}
+
+std::vector<Key> FramePlayback::keysForFile(const std::string &fileName)
+{
+  using IlpGafferMovie::shared_decoders_internal::SharedDecoders;
+
+  std::vector<Key> result;
+  std::lock_guard<std::mutex> lock{ _mutex };
+  for (auto &&[key, entry] : _entries) {
+    if (SharedDecoders::resolve(key.decoder_handle).fileName == fileName) {
+      result.push_back(key);
+    }
+  }
+  return result;
+}
+
+std::vector<Key> FramePlayback::victims(const size_t bytes, const Key *keep)
+{
+  struct Candidate
+  {
+    int64_t distance = 0;
+    uint64_t lastRequest = 0U;
+    size_t cost = 0U;
+    const Key *key = nullptr;
+  };
+
+  std::vector<Key> result;
+  std::lock_guard<std::mutex> lock{ _mutex };
+  std::vector<Candidate> candidates;
+  candidates.reserve(_entries.size());
+  for (auto &&[key, entry] : _entries) {
+    if (keep != nullptr && key == *keep) { continue; }
+    Candidate c{};
+    c.lastRequest = entry.lastRequest;
+    c.cost = entry.cost;
+    c.key = &key;
+    if (const auto ph = _playheads.find(streamKey(key)); ph != _playheads.end()) {
+      c.distance = nextUseDistance(ph->second, key.frame_nb);
+    } else {
+      c.distance = std::numeric_limits<int64_t>::max();
+    }
+    candidates.push_back(c);
+  }
+
+  // Furthest next use first, least recently requested first for ties.
+  std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+    return a.distance != b.distance ? a.distance > b.distance : a.lastRequest < b.lastRequest;
+  });
+  size_t released = 0U;
+  for (auto &&c : candidates) {
+    if (released >= bytes) { break; }
+    result.push_back(*c.key);
+    released += c.cost;
+  }
+  return result;
+}
+
+}// namespace IlpGafferMovie::frame_playback_internal
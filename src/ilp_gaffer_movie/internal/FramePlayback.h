@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>// size_t
+#include <cstdint>// uint64_t
+#include <mutex>// std::mutex
+#include <string>// std::string
+#include <unordered_map>// std::unordered_map
+#include <vector>// std::vector
+
+#include <boost/functional/hash.hpp>// boost::hash
+
+#include "ilp_gaffer_movie/ilp_gaffer_movie_export.hpp"
+
+#include "internal/SharedFrames.h"
+
+namespace IlpGafferMovie {
+namespace frame_playback_internal {
+
+  // The playhead of a video stream, estimated from the sequence of requested frames.
+  struct Playhead
+  {
+    int frame = -1;
+
+    // 1 for forward playback, -1 for backward playback, 0 if unknown.
+    int direction = 0;
+
+    // The (inclusive) range of frames visited since playback started, which is assumed to be
+    // the range being looped over.
+    int first = -1;
+    int last = -1;
+  };
+
+  // Bookkeeping required by the shared frame cache to choose which frames to evict. Frames that
+  // are expected to be requested last, given the playhead of their video stream, are evicted
+  // first. Frames outside the range being played back are evicted before any others.
+  class ILPGAFFERMOVIE_NO_EXPORT FramePlayback
+  {
+  public:
+    using Key = shared_frames_internal::FrameCacheKey;
+
+    // Called for every frame request.
+    void request(const Key &key);
+
+    // Called when a frame has been inserted in the cache.
+    void insert(const Key &key, size_t cost);
+
+    // Called when a frame has been removed from the cache, for whatever reason.
+    void remove(const Key &key);
+
+    // Forgets the playheads, cached frames are still tracked.
+    void clear();
+
+    // Returns true if inserting a frame of the given cost fits within the limit, possibly by
+    // evicting frames that will be needed later than the frame itself.
+    [[nodiscard]] bool wouldKeep(const Key &key, size_t cost, size_t available);
+
+    // Returns the cost of a cached frame from the same video stream as the given key, which is
+    // a good estimate for the cost of the frame. Returns zero if no such frame is cached.
+    [[nodiscard]] size_t streamFrameCost(const Key &key);
+
+    // Returns the cached frames, raw and filtered, decoded from the given file.
+    [[nodiscard]] std::vector<Key> keysForFile(const std::string &fileName);
+
+    // Returns frames that should be evicted, in order, to release at least the given number of
+    // bytes. Never returns the key to keep, typically the frame that was just requested.
+    [[nodiscard]] std::vector<Key> victims(size_t bytes, const Key *keep);
+
+  private:
+    struct Entry
+    {
+      size_t cost = 0U;
+      uint64_t lastRequest = 0U;
+    };
+
+    std::mutex _mutex;
+    uint64_t _clock = 0U;
+    std::unordered_map<Key, Playhead, boost::hash<Key>> _playheads;
+    std::unordered_map<Key, Entry, boost::hash<Key>> _entries;
+  };
+
+}// namespace frame_playback_internal
+}// namespace IlpGafferMovie
@@ -0,0 +1,147 @@
+#include "internal/FramePrefetcher.h"
+
+#include <cstdlib>// std::abs
+#include <iterator>// std::next
+#include <memory>// std::make_shared
+#include <mutex>// std::mutex, std::lock_guard
+#include <unordered_map>// std::unordered_map
+#include <vector>// std::vector
+
+#include <boost/functional/hash.hpp>// boost::hash
+
+#include "internal/DecodeScheduler.h"
+
+namespace {
+
+using FrameCacheKey = IlpGafferMovie::shared_frames_internal::FrameCacheKey;
+using IlpGafferMovie::decode_scheduler_internal::CancellationToken;
+using IlpGafferMovie::decode_scheduler_internal::CancellationTokenPtr;
+
+// Steps larger than this are considered jumps, rather than stepping through frames.
+constexpr int kMaxStep = 8;
+
+// The access pattern of a video stream.
+struct Pattern
+{
+  int frame = -1;
+  int step = 0;
+
+  // Cancelled when the pattern is broken, so that prefetching along the previous pattern stops.
+  CancellationTokenPtr token = std::make_shared<CancellationToken>();
+};
+
+// Frames from the same video stream share an access pattern.
+[[nodiscard]] FrameCacheKey streamKey(const FrameCacheKey &key)
+{
+  FrameCacheKey k = key;
+  k.frame_nb = -1;
+  return k;
+}
+
+class Prefetcher
+{
+public:
+  void request(const FrameCacheKey &key,
+    const int window,
+    const int firstFrame,
+    const int lastFrame)
+  {
+    std::vector<FrameCacheKey> keys;
+    CancellationTokenPtr token;
+    int step = 0;
+    {
+      std::lock_guard<std::mutex> lock{ _mutex };
+      Pattern &p = _patterns[streamKey(key)];
+      if (p.frame < 0) {
+        // First request for the video stream, there is no step yet.
+        p.frame = key.frame_nb;
+        p.step = 0;
+        return;
+      }
+      step = key.frame_nb - p.frame;
+      if (step == 0) { return; }
+      if (!(step == p.step && std::abs(step) <= kMaxStep)) {
+        // New pattern, wait for it to be confirmed. Cancelled work is dropped by the scheduler
+        // without running, so forget about the frames that were pending.
+        p.frame = key.frame_nb;
+        p.step = step;
+        p.token->cancel();
+        for (auto iter = _pending.begin(); iter != _pending.end();) {
+          iter = iter->second == p.token ? _pending.erase(iter) : std::next(iter);
+        }
+        p.token = std::make_shared<CancellationToken>();
+        return;
+      }
+      p.frame = key.frame_nb;
+
+      for (int i = 1; i <= window; ++i) {
+        FrameCacheKey k = key;
+        k.frame_nb = key.frame_nb + i * step;
+        if (k.frame_nb < firstFrame || lastFrame < k.frame_nb) { break; }
+        if (_pending.try_emplace(k, p.token).second) { keys.push_back(k); }
+      }
+      token = p.token;
+    }
+
+    // The next frame is likely to be requested soon, frames further ahead may never be.
+    using IlpGafferMovie::decode_scheduler_internal::DecodePriority;
+    using IlpGafferMovie::decode_scheduler_internal::DecodeScheduler;
+    for (auto &&k : keys) {
+      const DecodePriority priority = k.frame_nb == key.frame_nb + step
+                                        ? DecodePriority::kNormal
+                                        : DecodePriority::kBackground;
+      DecodeScheduler::submit(priority, token, [this, k]() {
+        using IlpGafferMovie::shared_frames_internal::SharedFrames;
+        try {
+          SharedFrames::prefetch(k);
+        } catch (...) {
+          done(k);
+          throw;
+        }
+        done(k);
+      });
+    }
+  }
+
+  [[nodiscard]] std::size_t numPending()
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    return _pending.size();
+  }
+
+private:
+  void done(const FrameCacheKey &key)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _pending.erase(key);
+  }
+
+  std::mutex _mutex;
+  std::unordered_map<FrameCacheKey, Pattern, boost::hash<FrameCacheKey>> _patterns;
+
+  // Frames queued or being prefetched, and the token of the pattern they were queued for.
+  std::unordered_map<FrameCacheKey, CancellationTokenPtr, boost::hash<FrameCacheKey>> _pending;
+};
+
+Prefetcher &prefetcher()
+{
+  static Prefetcher prefetcher;
+  return prefetcher;
+}
+
+}// namespace
+
+namespace IlpGafferMovie::frame_prefetcher_internal {
+
+void FramePrefetcher::request(const shared_frames_internal::FrameCacheKey &key,
+  const int window,
+  const int firstFrame,
+  const int lastFrame)
+{
+  if (window <= 0) { return; }
+  prefetcher().request(key, window, firstFrame, lastFrame);
+}
+
+size_t FramePrefetcher::numPending() { return prefetcher().numPending(); }
+
+}// namespace IlpGafferMovie::frame_prefetcher_internal
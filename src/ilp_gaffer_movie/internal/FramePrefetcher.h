@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>// size_t
+
+#include "ilp_gaffer_movie/ilp_gaffer_movie_export.hpp"
+
+#include "internal/SharedFrames.h"
+
+namespace IlpGafferMovie {
+namespace frame_prefetcher_internal {
+
+  // Decodes frames into the shared frame cache ahead of them being requested, so that decoding
+  // is hidden from playback. Prefetching is speculative work, scheduled by DecodeScheduler, so it
+  // yields to frames that are actually requested.
+  class ILPGAFFERMOVIE_NO_EXPORT FramePrefetcher
+  {
+  public:
+    // Called after a frame has been requested. When the requests for the video stream follow a
+    // pattern, i.e. the same step (forward, backward or stepping over frames) twice in a row,
+    // the next frames along the pattern, at most window frames and within the range
+    // [firstFrame, lastFrame], are prefetched. The next frame has normal priority, frames
+    // further ahead have background priority. Breaking the pattern, e.g. by jumping to another
+    // frame, cancels prefetching of the remaining frames along the previous pattern.
+    static void request(const shared_frames_internal::FrameCacheKey &key,
+      int window,
+      int firstFrame,
+      int lastFrame);
+
+    // Returns the number of frames waiting to be, or currently being, prefetched.
+    static size_t numPending();
+  };
+
+}// namespace frame_prefetcher_internal
+}// namespace IlpGafferMovie
@@ -0,0 +1,122 @@
+#include "internal/SharedColorProcessors.h"
+
+#include <cstddef>// std::size_t
+#include <map>// std::map
+#include <mutex>// std::mutex, std::lock_guard
+#include <string>// std::string
+#include <vector>// std::vector
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <GafferImage/OpenColorIOAlgo.h>
+
+#include <IECore/Exception.h>// IECore::Exception
+#include <IECore/MurmurHash.h>// IECore::MurmurHash
+
+#include <OpenColorIO/OpenColorIO.h>
+
+#include "ilp_movie/trace.hpp"// ILP_MOVIE_TRACE_SPAN_ARG
+
+namespace {
+
+using IlpGafferMovie::shared_color_processors_internal::ColorProcessorHandle;
+using IlpGafferMovie::shared_color_processors_internal::kNoColorProcessor;
+
+// Rows converted by a single call to the processor. Large enough to amortize the per-call
+// overhead of the processor, small enough to balance the work across threads.
+constexpr int kRowsPerBand = 32;
+
+class Processors
+{
+public:
+  [[nodiscard]] ColorProcessorHandle intern(const std::string &inputSpace,
+    const std::string &outputSpace)
+  {
+    IECore::MurmurHash h = GafferImage::OpenColorIOAlgo::currentConfigHash();
+    h.append(inputSpace);
+    h.append(outputSpace);
+
+    std::lock_guard<std::mutex> lock{ _mutex };
+    if (const auto it = _handles.find(h); it != _handles.end()) { return it->second; }
+
+    // Created once per combination, so this is not worth doing outside the lock.
+    const auto config = GafferImage::OpenColorIOAlgo::currentConfig();
+    const auto processor = config->getProcessor(inputSpace.c_str(), outputSpace.c_str());
+    ColorProcessorHandle handle = kNoColorProcessor;
+    if (!processor->isNoOp()) {
+      handle = static_cast<ColorProcessorHandle>(_processors.size());
+      _processors.push_back(processor->getDefaultCPUProcessor());
+    }
+    _handles.emplace(h, handle);
+    return handle;
+  }
+
+  [[nodiscard]] OCIO_NAMESPACE::ConstCPUProcessorRcPtr resolve(const ColorProcessorHandle handle)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    if (handle < 0 || static_cast<std::size_t>(handle) >= _processors.size()) {
+      throw IECore::Exception("Invalid color processor handle");
+    }
+    return _processors[static_cast<std::size_t>(handle)];
+  }
+
+private:
+  std::mutex _mutex;
+  std::map<IECore::MurmurHash, ColorProcessorHandle> _handles;
+  std::vector<OCIO_NAMESPACE::ConstCPUProcessorRcPtr> _processors;
+};
+
+Processors &processors()
+{
+  static Processors processors;
+  return processors;
+}
+
+}// namespace
+
+namespace IlpGafferMovie::shared_color_processors_internal {
+
+ColorProcessorHandle SharedColorProcessors::intern(const std::string &inputSpace,
+  const std::string &outputSpace)
+{
+  return processors().intern(inputSpace, outputSpace);
+}
+
+void SharedColorProcessors::convertFrame(const ColorProcessorHandle handle,
+  ilp_movie::Frame &frame)
+{
+  namespace Comp = ilp_movie::Comp;
+
+  const auto cpu = processors().resolve(handle);
+  const auto r = ilp_movie::CompPixelData<float>(frame, Comp::kR);
+  const auto g = ilp_movie::CompPixelData<float>(frame, Comp::kG);
+  const auto b = ilp_movie::CompPixelData<float>(frame, Comp::kB);
+  if (Empty(r) || Empty(g) || Empty(b)) {
+    throw IECore::Exception("Color conversion requires planar float pixel data");
+  }
+
+  ILP_MOVIE_TRACE_SPAN_ARG("frame cache", "convert frame", "height", frame.hdr.height);
+
+  // Rows are contiguous within each plane, so a band of rows is itself a planar image. Alpha,
+  // if any, is left as is, which matches converting unpremultiplied pixels.
+  const auto width = static_cast<std::size_t>(frame.hdr.width);
+  tbb::task_group_context taskGroupContext(tbb::task_group_context::isolated);
+  tbb::parallel_for(
+    tbb::blocked_range<int>(0, frame.hdr.height, static_cast<size_t>(kRowsPerBand)),
+    [&](const tbb::blocked_range<int> &range) {
+      const std::size_t offset = static_cast<std::size_t>(range.begin()) * width;
+      OCIO_NAMESPACE::PlanarImageDesc band(
+        /*rData=*/r.data + offset,// NOLINT
+        /*gData=*/g.data + offset,// NOLINT
+        /*bData=*/b.data + offset,// NOLINT
+        /*aData=*/nullptr,
+        /*width=*/static_cast<long>(width),
+        /*height=*/static_cast<long>(range.end() - range.begin()));
+      cpu->apply(band);
+    },
+    tbb::simple_partitioner(),
+    taskGroupContext);
+}
+
+}// namespace IlpGafferMovie::shared_color_processors_internal
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>// std::string
+
+#include "ilp_gaffer_movie/ilp_gaffer_movie_export.hpp"
+
+#include "ilp_movie/frame.hpp"// ilp_movie::Frame
+
+namespace IlpGafferMovie {
+namespace shared_color_processors_internal {
+
+  // Compact identifier for an interned color processor, see SharedColorProcessors::intern.
+  // Valid handles are non-negative.
+  using ColorProcessorHandle = int;
+  constexpr ColorProcessorHandle kNoColorProcessor = -1;
+
+  class ILPGAFFERMOVIE_NO_EXPORT SharedColorProcessors
+  {
+  public:
+    // Returns a handle to an OCIO processor, from the current config, converting pixels from
+    // the input space to the output space. The processor is created the first time a config,
+    // input space and output space combination is interned and then kept for the lifetime of
+    // the process, handles are never re-used. Returns kNoColorProcessor if the conversion does
+    // not change the pixels. Throws if the processor cannot be created, e.g. for an unknown
+    // color space.
+    //
+    // Must be called from a compute, since the current config depends on the context.
+    static ColorProcessorHandle intern(const std::string &inputSpace,
+      const std::string &outputSpace);
+
+    // Converts the R, G and B planes of a planar float frame in place, in parallel row bands.
+    // Throws if the handle is not valid or the frame is not in a planar float pixel format.
+    static void convertFrame(ColorProcessorHandle handle, ilp_movie::Frame &frame);
+  };
+
+}// namespace shared_color_processors_internal
+}// namespace IlpGafferMovie
@@ -1,7 +1,30 @@
 #include "internal/SharedDecoders.h"
 
+#include <algorithm>// std::find
+#include <atomic>// std::atomic
+#include <cstdint>// uint64_t, int64_t
+#include <deque>// std::deque
+#include <iterator>// std::prev
+#include <list>// std::list
+#include <mutex>// std::mutex, std::lock_guard
+#include <optional>// std::optional
+#include <shared_mutex>// std::shared_mutex, std::shared_lock
+#include <stdexcept>// std::out_of_range
+#include <unordered_map>// std::unordered_map
+#include <vector>// std::vector
+
+#include <sys/stat.h>// ::stat
+
 #include <boost/functional/hash.hpp>// boost::hash_combine
 
+#include <IECore/Canceller.h>// IECore::Canceller, IECore::Cancelled
+
+#include "ilp_gaffer_movie/startup.hpp"// IlpGafferMovie::Startup
+
+#include "ilp_movie/frame.hpp"// ilp_movie::GetBufferSize
+#include "ilp_movie/trace.hpp"// ILP_MOVIE_TRACE_SPAN
+
+#include "internal/DecodeScheduler.h"
 #include "internal/LRUCache.h"// IECorePreview::LRUCache
 
 namespace {
@@ -10,15 +33,387 @@ using CacheKey = IlpGafferMovie::shared_decoders_internal::DecoderCacheKey;
 using CacheEntry = IlpGafferMovie::shared_decoders_internal::DecoderCacheEntry;
 using DecoderLRUCache = IECorePreview::LRUCache<CacheKey, CacheEntry>;
 
+constexpr size_t kBytesPerMb = 1024U * 1024U;
+
+// Default limits for awake decoders.
+constexpr size_t kDefaultOpenFilesLimit = 100U;
+constexpr size_t kDefaultMemoryLimit = 1024U * kBytesPerMb;
+
+// Rough estimate of the memory held by an open file, i.e. I/O buffers and format context,
+// regardless of the video streams in the file.
+constexpr size_t kFileMemoryCost = kBytesPerMb;
+
+// Rough estimate of the number of decoded frames, per video stream, held by the codec for
+// reference and in its frame pool.
+constexpr size_t kCodecFramesPerStream = 4U;
+
+std::atomic<size_t> g_openFilesLimit{ kDefaultOpenFilesLimit };
+std::atomic<size_t> g_memoryLimit{ kDefaultMemoryLimit };
+
+// Estimates the memory held by an awake decoder from the stream headers. Each video stream holds
+// a number of decoded frames, in the input pixel format, and a filtered frame, in the output
+// pixel format.
+[[nodiscard]] size_t memoryCost(const ilp_movie::Decoder &decoder)
+{
+  size_t cost = kFileMemoryCost;
+  for (auto &&hdr : decoder.VideoStreamHeaders()) {
+    const auto inSize = ilp_movie::GetBufferSize(hdr.pix_fmt_name, hdr.width, hdr.height);
+    cost += kCodecFramesPerStream * inSize.value_or(0U);
+
+    if (const auto filtHdr = decoder.FilteredVideoStreamHeader(hdr.stream_index);
+        filtHdr.has_value()) {
+      const auto outSize =
+        ilp_movie::GetBufferSize(filtHdr->pix_fmt_name, filtHdr->width, filtHdr->height);
+      cost += outSize.value_or(0U);
+    }
+  }
+  return cost;
+}
+
+// Keeps track of awake decoders, in least recently used order.
+//
+// Note that the bookkeeping is approximate, since a decoder may be used by another thread
+// while it is being hibernated. Such a decoder simply wakes up again the next time it is used.
+class AwakeDecoders
+{
+public:
+  using DecoderPtr = std::shared_ptr<ilp_movie::Decoder>;
+
+  struct Victim
+  {
+    const ilp_movie::Decoder *key = nullptr;
+    DecoderPtr decoder;
+    size_t cost = 0U;
+  };
+
+  // Marks the decoder as most recently used and returns the decoders that should be hibernated
+  // to respect the limits.
+  [[nodiscard]] std::vector<Victim> touch(const CacheEntry &entry)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    const ilp_movie::Decoder *key = entry.decoder.get();
+    if (const auto iter = _index.find(key); iter != _index.end()) {
+      _usage -= iter->second->cost;
+      _lru.erase(iter->second);
+    }
+    _lru.push_front(Awake{ key, entry.decoder, entry.memoryCost });
+    _index[key] = _lru.begin();
+    _usage += entry.memoryCost;
+    return _victims();
+  }
+
+  // Returns the decoders that should be hibernated to respect the (possibly changed) limits.
+  [[nodiscard]] std::vector<Victim> victims()
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    return _victims();
+  }
+
+  // Puts back a victim that could not be hibernated as the least recently used decoder, so that
+  // hibernating it is retried when the limits are next enforced. Does nothing if the decoder
+  // has been used again in the meantime.
+  void restore(const Victim &victim)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    if (_index.find(victim.key) != _index.end()) { return; }
+    _lru.push_back(Awake{ victim.key, victim.decoder, victim.cost });
+    _index[victim.key] = std::prev(_lru.end());
+    _usage += victim.cost;
+  }
+
+  // Called when a decoder is removed from the cache.
+  void remove(const ilp_movie::Decoder *key)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    if (const auto iter = _index.find(key); iter != _index.end()) {
+      _usage -= iter->second->cost;
+      _lru.erase(iter->second);
+      _index.erase(iter);
+    }
+  }
+
+  [[nodiscard]] size_t size()
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    return _lru.size();
+  }
+
+  [[nodiscard]] size_t usage()
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    return _usage;
+  }
+
+private:
+  struct Awake
+  {
+    const ilp_movie::Decoder *key = nullptr;
+    std::weak_ptr<ilp_movie::Decoder> decoder;
+    size_t cost = 0U;
+  };
+
+  // Must be called with the mutex locked. The most recently used decoder is always kept awake.
+  [[nodiscard]] std::vector<Victim> _victims()
+  {
+    const size_t openFilesLimit = g_openFilesLimit.load(std::memory_order_relaxed);
+    const size_t memoryLimit = g_memoryLimit.load(std::memory_order_relaxed);
+    std::vector<Victim> result;
+    while (_lru.size() > 1U && (_lru.size() > openFilesLimit || _usage > memoryLimit)) {
+      const Awake &awake = _lru.back();
+      // Decoders that no longer exist have already released their resources.
+      if (auto decoder = awake.decoder.lock(); decoder != nullptr) {
+        result.push_back(Victim{ awake.key, std::move(decoder), awake.cost });
+      }
+      _usage -= awake.cost;
+      _index.erase(awake.key);
+      _lru.pop_back();
+    }
+    return result;
+  }
+
+  std::mutex _mutex;
+  std::list<Awake> _lru;
+  std::unordered_map<const ilp_movie::Decoder *, std::list<Awake>::iterator> _index;
+  size_t _usage = 0U;
+};
+
+AwakeDecoders &awakeDecoders()
+{
+  static AwakeDecoders awakeDecoders;
+  return awakeDecoders;
+}
+
+using Handle = IlpGafferMovie::shared_decoders_internal::DecoderHandle;
+
+// Decoder keys are interned once and never removed, so handles stay valid, and resolve to the
+// same key, even after the decoder has been evicted from the cache.
+class InternedKeys
+{
+public:
+  [[nodiscard]] Handle intern(const CacheKey &key)
+  {
+    {
+      std::shared_lock<std::shared_mutex> lock{ _mutex };
+      if (const auto iter = _handles.find(key); iter != _handles.end()) { return iter->second; }
+    }
+
+    // Intern the raw key first, so that each entry can refer to the handle of its raw key.
+    using IlpGafferMovie::shared_decoders_internal::isRawDecoderKey;
+    using IlpGafferMovie::shared_decoders_internal::kInvalidDecoderHandle;
+    using IlpGafferMovie::shared_decoders_internal::rawDecoderKey;
+    const Handle raw = isRawDecoderKey(key) ? kInvalidDecoderHandle
+                                             : intern(rawDecoderKey(key.fileName));
+
+    std::unique_lock<std::shared_mutex> lock{ _mutex };
+    const auto [iter, inserted] = _handles.try_emplace(key, static_cast<Handle>(_entries.size()));
+    if (inserted) {
+      // Raw keys refer to themselves.
+      _entries.push_back(Entry{ key, raw == kInvalidDecoderHandle ? iter->second : raw });
+    }
+    return iter->second;
+  }
+
+  // Elements of a deque are not moved when appending, so references remain valid after the
+  // lock is released.
+  [[nodiscard]] const CacheKey &resolve(const Handle handle) { return entry(handle).key; }
+
+  [[nodiscard]] Handle rawHandle(const Handle handle) { return entry(handle).raw; }
+
+private:
+  struct Entry
+  {
+    CacheKey key;
+    Handle raw;
+  };
+
+  [[nodiscard]] const Entry &entry(const Handle handle)
+  {
+    std::shared_lock<std::shared_mutex> lock{ _mutex };
+    if (!(0 <= handle && static_cast<size_t>(handle) < _entries.size())) {
+      throw std::out_of_range("Invalid decoder handle");
+    }
+    return _entries[static_cast<size_t>(handle)];
+  }
+
+  std::shared_mutex _mutex;
+  std::unordered_map<CacheKey, Handle, boost::hash<CacheKey>> _handles;
+  std::deque<Entry> _entries;
+};
+
+InternedKeys &internedKeys()
+{
+  static InternedKeys internedKeys;
+  return internedKeys;
+}
+
+// Identifies the contents of a file on disk, without reading the file.
+struct FileSignature
+{
+  uint64_t size = 0U;
+  int64_t mtimeNs = 0;
+  uint64_t inode = 0U;
+  uint64_t device = 0U;
+};
+
+[[nodiscard]] bool operator==(const FileSignature &lhs, const FileSignature &rhs) noexcept
+{
+  // clang-format off
+  return 
+    lhs.size == rhs.size && 
+    lhs.mtimeNs == rhs.mtimeNs && 
+    lhs.inode == rhs.inode && 
+    lhs.device == rhs.device;
+  // clang-format on
+}
+
+// Returns null if the file doesn't exist, or cannot be accessed.
+[[nodiscard]] std::optional<FileSignature> fileSignature(const std::string &fileName)
+{
+  struct stat st = {};
+  if (::stat(fileName.c_str(), &st) != 0) { return std::nullopt; }
+
+  constexpr int64_t kNsPerSecond = 1000000000;
+  FileSignature sig{};
+  sig.size = static_cast<uint64_t>(st.st_size);
+  sig.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * kNsPerSecond
+                + static_cast<int64_t>(st.st_mtim.tv_nsec);
+  sig.inode = static_cast<uint64_t>(st.st_ino);
+  sig.device = static_cast<uint64_t>(st.st_dev);
+  return sig;
+}
+
+// Keeps track of the cached decoders for each file, and the signature of each file when the
+// first decoder was opened for it. The signature is kept when decoders are evicted, since frames
+// decoded from the file may still be cached elsewhere.
+class CachedFiles
+{
+public:
+  void insert(const CacheKey &key)
+  {
+    // Don't hold the lock while accessing the file system.
+    std::optional<std::optional<FileSignature>> sig;
+    if (!contains(key.fileName)) { sig = fileSignature(key.fileName); }
+
+    std::lock_guard<std::mutex> lock{ _mutex };
+    auto &file = _files[key.fileName];
+    if (!file.recorded && sig.has_value()) {
+      file.signature = *sig;
+      file.recorded = true;
+    }
+    file.keys.push_back(key);
+  }
+
+  void remove(const CacheKey &key)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    if (const auto iter = _files.find(key.fileName); iter != _files.end()) {
+      auto &keys = iter->second.keys;
+      if (const auto k = std::find(keys.begin(), keys.end(), key); k != keys.end()) {
+        keys.erase(k);
+      }
+    }
+  }
+
+  // Returns the keys of the decoders currently cached for the file, and forgets its signature.
+  [[nodiscard]] std::vector<CacheKey> forget(const std::string &fileName)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    std::vector<CacheKey> result;
+    if (const auto iter = _files.find(fileName); iter != _files.end()) {
+      result = std::move(iter->second.keys);
+      _files.erase(iter);
+    }
+    return result;
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _files.clear();
+  }
+
+  [[nodiscard]] std::vector<std::string> stale()
+  {
+    std::vector<std::pair<std::string, std::optional<FileSignature>>> recorded;
+    {
+      std::lock_guard<std::mutex> lock{ _mutex };
+      recorded.reserve(_files.size());
+      for (auto &&[fileName, file] : _files) {
+        if (file.recorded) { recorded.emplace_back(fileName, file.signature); }
+      }
+    }
+
+    std::vector<std::string> result;
+    for (auto &&[fileName, sig] : recorded) {
+      if (fileSignature(fileName) != sig) { result.push_back(fileName); }
+    }
+    return result;
+  }
+
+private:
+  [[nodiscard]] bool contains(const std::string &fileName)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    const auto iter = _files.find(fileName);
+    return iter != _files.end() && iter->second.recorded;
+  }
+
+  struct File
+  {
+    bool recorded = false;
+    std::optional<FileSignature> signature;
+    std::vector<CacheKey> keys;
+  };
+
+  std::mutex _mutex;
+  std::unordered_map<std::string, File> _files;
+};
+
+CachedFiles &cachedFiles()
+{
+  static CachedFiles cachedFiles;
+  return cachedFiles;
+}
+
+// Hibernation waits for an ongoing decode to finish, so it must not be done while
+// holding any locks.
+void hibernate(const std::vector<AwakeDecoders::Victim> &victims)
+{
+  for (auto &&victim : victims) {
+    ILP_MOVIE_TRACE_SPAN("decoder cache", "hibernate");
+    victim.decoder->Hibernate();
+  }
+}
+
+// Used when serving requests, which must not wait for another decoder's decode to finish.
+// Busy victims are skipped and hibernated on a later attempt.
+void hibernateIdle(const std::vector<AwakeDecoders::Victim> &victims)
+{
+  for (auto &&victim : victims) {
+    ILP_MOVIE_TRACE_SPAN("decoder cache", "hibernate");
+    if (!victim.decoder->TryHibernate()) { awakeDecoders().restore(victim); }
+  }
+}
+
 DecoderLRUCache &cache()
 {
   static DecoderLRUCache cache{
     [](const CacheKey &key, size_t &cost, const IECore::Canceller * /*canceller*/) {
-      // Each decoder costs exactly one unit.
+      ILP_MOVIE_TRACE_SPAN("decoder cache", "open decoder");
+
+      // Decoders are opened with as many slice threads as there are threads to decode slices.
+      IlpGafferMovie::Startup::initParallelFor();
+
+      // Each decoder costs exactly one unit. Hibernating decoders hold very few resources, so
+      // memory is only accounted for while decoders are awake.
       cost = 1U;
 
       CacheEntry result;
 
+      // Record the file signature before opening the file, so that changes made while the file
+      // is being opened are detected.
+      cachedFiles().insert(key);
+
       auto decoder = std::make_shared<ilp_movie::Decoder>();
       if (!decoder->Open(key.fileName, key.filterGraphDescr)) {
         result.error = std::make_shared<std::string>("Cannot open decoder");
@@ -39,10 +434,20 @@ DecoderLRUCache &cache()
       // Note that it might still be the case that the decoder cannot find any
       // input video streams in the file.
       result.decoder = decoder;
+      result.memoryCost = memoryCost(*decoder);
+
+      // A newly opened decoder is awake.
+      hibernateIdle(awakeDecoders().touch(result));
 
       return result;
     },
-    /*maxCost=*/200
+    /*maxCost=*/200,
+    /*removalCallback=*/
+    [](const CacheKey &key, const CacheEntry &entry) {
+      ILP_MOVIE_TRACE_INSTANT("decoder cache", "evict");
+      awakeDecoders().remove(entry.decoder.get());
+      cachedFiles().remove(key);
+    }
   };
   return cache;
 }
@@ -70,11 +475,82 @@ std::size_t hash_value(const DecoderCacheKey &k)
   return seed;
 }
 
+DecoderCacheKey rawDecoderKey(const std::string &fileName)
+{
+  // clang-format off
+  return DecoderCacheKey{
+    /*.fileName=*/fileName,
+    /*.filterGraphDescr=*/{
+      /*.filter_descr=*/"null",
+      /*.out_pix_fmt_name=*/""
+    }
+  };
+  // clang-format on
+}
+
+bool isRawDecoderKey(const DecoderCacheKey &key) noexcept
+{
+  return key.filterGraphDescr.out_pix_fmt_name.empty();
+}
+
 DecoderCacheEntry SharedDecoders::get(const DecoderCacheKey &key) { return cache().get(key); }
 
+DecoderHandle SharedDecoders::intern(const DecoderCacheKey &key)
+{
+  return internedKeys().intern(key);
+}
+
+const DecoderCacheKey &SharedDecoders::resolve(const DecoderHandle handle)
+{
+  return internedKeys().resolve(handle);
+}
+
+DecoderHandle SharedDecoders::rawHandle(const DecoderHandle handle)
+{
+  return internedKeys().rawHandle(handle);
+}
+
+bool SharedDecoders::isRawHandle(const DecoderHandle handle) { return rawHandle(handle) == handle; }
+
+bool SharedDecoders::decodeVideoFrame(const DecoderCacheEntry &entry,
+  const int videoStreamIndex,
+  const int frameNb,
+  ilp_movie::Frame &frame,
+  const IECore::Canceller *canceller)
+{
+  using decode_scheduler_internal::DecodeScheduler;
+
+  if (entry.decoder == nullptr) { return false; }
+  hibernateIdle(awakeDecoders().touch(entry));
+  const auto token = DecodeScheduler::currentToken();
+  const auto cancelled = [&]() {
+    return (canceller != nullptr && canceller->cancelled())
+           || (token != nullptr && token->cancelled());
+  };
+  return DecodeScheduler::runWithDecoder(entry.decoder.get(), [&]() {
+    if (entry.decoder->DecodeVideoFrame(videoStreamIndex, frameNb, frame, cancelled)) {
+      return true;
+    }
+    // Abandoned frames must not be cached as errors.
+    if (cancelled()) { throw IECore::Cancelled(); }
+    return false;
+  });
+}
+
 void SharedDecoders::erase(const DecoderCacheKey &key) { cache().erase(key); }
 
-void SharedDecoders::clear() { cache().clear(); }
+void SharedDecoders::eraseFile(const std::string &fileName)
+{
+  for (auto &&key : cachedFiles().forget(fileName)) { cache().erase(key); }
+}
+
+std::vector<std::string> SharedDecoders::staleFiles() { return cachedFiles().stale(); }
+
+void SharedDecoders::clear()
+{
+  cache().clear();
+  cachedFiles().clear();
+}
 
 void SharedDecoders::setMaxDecoders(const size_t numDecoders) { cache().setMaxCost(numDecoders); }
 
@@ -82,4 +558,27 @@ size_t SharedDecoders::getMaxDecoders() { return cache().getMaxCost(); }
 
 size_t SharedDecoders::numDecoders() { return cache().currentCost(); }
 
-}// namespace IlpGafferMovie::shared_decoders_internal
\ No newline at end of file
+void SharedDecoders::setOpenFilesLimit(const size_t maxOpenFiles)
+{
+  g_openFilesLimit.store(maxOpenFiles, std::memory_order_relaxed);
+  hibernate(awakeDecoders().victims());
+}
+
+size_t SharedDecoders::getOpenFilesLimit()
+{
+  return g_openFilesLimit.load(std::memory_order_relaxed);
+}
+
+size_t SharedDecoders::numOpenFiles() { return awakeDecoders().size(); }
+
+void SharedDecoders::setMemoryLimit(const size_t bytes)
+{
+  g_memoryLimit.store(bytes, std::memory_order_relaxed);
+  hibernate(awakeDecoders().victims());
+}
+
+size_t SharedDecoders::getMemoryLimit() { return g_memoryLimit.load(std::memory_order_relaxed); }
+
+size_t SharedDecoders::memoryUsage() { return awakeDecoders().usage(); }
+
+}// namespace IlpGafferMovie::shared_decoders_internal
@@ -3,6 +3,9 @@
 #include <cstddef>// std::size_t, size_t
 #include <memory>// std::shared_ptr
 #include <string>// std::string
+#include <vector>// std::vector
+
+#include <IECore/Canceller.h>// IECore::Canceller
 
 #include "ilp_gaffer_movie/ilp_gaffer_movie_export.hpp"
 
@@ -17,12 +20,33 @@ namespace shared_decoders_internal {
     ilp_movie::DecoderFilterGraphDescription filterGraphDescr;
   };
 
+  bool operator==(const DecoderCacheKey &lhs, const DecoderCacheKey &rhs) noexcept;
+  std::size_t hash_value(const DecoderCacheKey &k);
+
+  // Compact identifier for an interned decoder key, see SharedDecoders::intern. Valid handles
+  // are non-negative.
+  using DecoderHandle = int;
+  constexpr DecoderHandle kInvalidDecoderHandle = -1;
+
+  // Decoders opened without an output pixel format return raw frames, i.e. in the native pixel
+  // format of the video stream, that can be shared by any number of filter graphs.
+  [[nodiscard]] DecoderCacheKey rawDecoderKey(const std::string &fileName);
+  [[nodiscard]] bool isRawDecoderKey(const DecoderCacheKey &key) noexcept;
+
   struct DecoderCacheEntry
   {
     std::shared_ptr<ilp_movie::Decoder> decoder;
     std::shared_ptr<std::string> error;
+
+    // Estimated memory, in [bytes], held by the decoder while it is awake, i.e. not hibernating.
+    size_t memoryCost = 0U;
   };
 
+  // Cached decoders are either awake, holding an open file and the memory used for decoding,
+  // or hibernating, in which case only the stream headers are kept. The number of awake decoders
+  // is limited by the open files limit and by a memory limit. When either limit is exceeded the
+  // least recently used decoders are hibernated. A hibernating decoder is woken up when it is
+  // used for decoding again.
   class ILPGAFFERMOVIE_NO_EXPORT SharedDecoders
   {
   public:
@@ -30,9 +54,41 @@ namespace shared_decoders_internal {
     // file multiple times.
     static DecoderCacheEntry get(const DecoderCacheKey &key);
 
+    // Returns a handle that identifies the key for the lifetime of the process, so that other
+    // caches can use the handle instead of the key strings. The strings are only hashed when
+    // interning, handles are never re-used.
+    static DecoderHandle intern(const DecoderCacheKey &key);
+
+    // Returns the key for a handle returned by intern. Throws if the handle is not valid.
+    static const DecoderCacheKey &resolve(DecoderHandle handle);
+
+    // Returns the handle of the raw decoder key for the same file as the given handle, and
+    // whether the given handle refers to a raw decoder key, without resolving the key.
+    static DecoderHandle rawHandle(DecoderHandle handle);
+    static bool isRawHandle(DecoderHandle handle);
+
+    // Decodes a frame using a decoder from the cache. Other decoders may be hibernated to
+    // make room for this decoder to be awake. Decodes are scheduled by priority, see
+    // DecodeScheduler. Throws IECore::Cancelled if the canceller, or the token of speculative
+    // work, is cancelled, in which case decoding stops within one packet.
+    [[nodiscard]] static bool decodeVideoFrame(const DecoderCacheEntry &entry,
+      int videoStreamIndex,
+      int frameNb,
+      ilp_movie::Frame &frame,
+      const IECore::Canceller *canceller = nullptr);
+
     // Erase a single decoder from the cache.
     static void erase(const DecoderCacheKey &key);
 
+    // Erase all decoders for the given file from the cache.
+    static void eraseFile(const std::string &fileName);
+
+    // Returns the files that have changed on disk, i.e. their size, modification time or inode,
+    // since decoders were first opened for them. Files that could not be opened before but now
+    // exist, and vice versa, are also considered to have changed. Only checks file metadata, no
+    // files are read.
+    static std::vector<std::string> staleFiles();
+
     // Clear the entire cache.
     static void clear();
 
@@ -44,8 +100,22 @@ namespace shared_decoders_internal {
     // be cached internally.
     static size_t getMaxDecoders();
 
-    // Returns the number of decoders currently in the cache.
+    // Returns the number of decoders currently in the cache, including hibernating decoders.
     static size_t numDecoders();
+
+    // Sets the limit for the number of awake decoders, each holding an open file.
+    static void setOpenFilesLimit(size_t maxOpenFiles);
+    static size_t getOpenFilesLimit();
+
+    // Returns the number of awake decoders.
+    static size_t numOpenFiles();
+
+    // Sets the limit for the (estimated) memory, in [bytes], held by awake decoders.
+    static void setMemoryLimit(size_t bytes);
+    static size_t getMemoryLimit();
+
+    // Returns the (estimated) memory, in [bytes], currently held by awake decoders.
+    static size_t memoryUsage();
   };
 
 }// namespace shared_decoders_internal
@@ -0,0 +1,129 @@
+#include "internal/SharedFilters.h"
+
+#include <mutex>// std::mutex, std::lock_guard
+#include <unordered_set>// std::unordered_set
+#include <vector>// std::vector
+
+#include <boost/functional/hash.hpp>// boost::hash_combine
+
+#include "internal/LRUCache.h"// IECorePreview::LRUCache
+
+namespace {
+
+using CacheKey = IlpGafferMovie::shared_filters_internal::FilterCacheKey;
+using CacheEntry = IlpGafferMovie::shared_filters_internal::FilterCacheEntry;
+using FilterLRUCache = IECorePreview::LRUCache<CacheKey, CacheEntry>;
+
+// Keys of the filters currently in the cache, so that the filters for a single file can be
+// erased without clearing the entire cache.
+class CachedKeys
+{
+public:
+  void insert(const CacheKey &key)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _keys.insert(key);
+  }
+
+  void remove(const CacheKey &key)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _keys.erase(key);
+  }
+
+  [[nodiscard]] std::vector<CacheKey> forFile(const std::string &fileName)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    std::vector<CacheKey> result;
+    for (auto &&key : _keys) {
+      using IlpGafferMovie::shared_decoders_internal::SharedDecoders;
+      if (SharedDecoders::resolve(key.decoder_handle).fileName == fileName) {
+        result.push_back(key);
+      }
+    }
+    return result;
+  }
+
+private:
+  std::mutex _mutex;
+  std::unordered_set<CacheKey, boost::hash<CacheKey>> _keys;
+};
+
+CachedKeys &cachedKeys()
+{
+  static CachedKeys cachedKeys;
+  return cachedKeys;
+}
+
+FilterLRUCache &cache()
+{
+  static FilterLRUCache cache{
+    [](const CacheKey &key, size_t &cost, const IECore::Canceller * /*canceller*/) {
+      // Each filter costs exactly one unit.
+      cost = 1U;
+
+      CacheEntry result;
+      cachedKeys().insert(key);
+
+      // Filters are configured for the raw frames of the video stream.
+      using IlpGafferMovie::shared_decoders_internal::SharedDecoders;
+      const auto &decoderKey = SharedDecoders::resolve(key.decoder_handle);
+      const auto &rawKey = SharedDecoders::resolve(SharedDecoders::rawHandle(key.decoder_handle));
+      const auto decoderEntry = SharedDecoders::get(rawKey);
+      if (decoderEntry.decoder == nullptr) {
+        result.error = std::make_shared<std::string>("Bad decoder");
+        return result;
+      }
+
+      const auto hdr = decoderEntry.decoder->VideoStreamHeader(key.video_stream_index);
+      if (!hdr.has_value()) {
+        result.error = std::make_shared<std::string>("Bad video stream");
+        return result;
+      }
+
+      auto filter = std::make_shared<ilp_movie::FrameFilter>();
+      if (!filter->SetDescription(decoderKey.filterGraphDescr, *hdr)) {
+        result.error = std::make_shared<std::string>("Cannot configure filter graph");
+        return result;
+      }
+
+      result.filter = filter;
+      return result;
+    },
+    /*maxCost=*/200,
+    [](const CacheKey &key, const CacheEntry & /*entry*/) { cachedKeys().remove(key); }
+  };
+  return cache;
+}
+
+}// namespace
+
+namespace IlpGafferMovie::shared_filters_internal {
+
+bool operator==(const FilterCacheKey &lhs, const FilterCacheKey &rhs) noexcept
+{
+  // clang-format off
+  return
+    lhs.decoder_handle == rhs.decoder_handle &&
+    lhs.video_stream_index == rhs.video_stream_index;
+  // clang-format on
+}
+
+std::size_t hash_value(const FilterCacheKey &k)
+{
+  std::size_t seed = 0;
+  boost::hash_combine(/*out*/ seed, k.decoder_handle);
+  boost::hash_combine(/*out*/ seed, k.video_stream_index);
+  return seed;
+}
+
+FilterCacheEntry SharedFilters::get(const FilterCacheKey &key) { return cache().get(key); }
+
+void SharedFilters::eraseFile(const std::string &fileName)
+{
+  for (auto &&key : cachedKeys().forFile(fileName)) { cache().erase(key); }
+}
+
+void SharedFilters::clear() { cache().clear(); }
+
+}// namespace IlpGafferMovie::shared_filters_internal
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>// std::size_t, size_t
+#include <memory>// std::shared_ptr
+#include <string>// std::string
+
+#include "ilp_gaffer_movie/ilp_gaffer_movie_export.hpp"
+
+#include "ilp_movie/frame_filter.hpp"// ilp_movie::FrameFilter
+
+#include "internal/SharedDecoders.h"
+
+namespace IlpGafferMovie {
+namespace shared_filters_internal {
+
+  // The filter graph description, including the output pixel format, is given by the interned
+  // decoder key, which must not be a raw decoder key.
+  struct FilterCacheKey
+  {
+    shared_decoders_internal::DecoderHandle decoder_handle =
+      shared_decoders_internal::kInvalidDecoderHandle;
+    int video_stream_index = -1;
+  };
+
+  bool operator==(const FilterCacheKey &lhs, const FilterCacheKey &rhs) noexcept;
+  std::size_t hash_value(const FilterCacheKey &k);
+
+  struct FilterCacheEntry
+  {
+    std::shared_ptr<ilp_movie::FrameFilter> filter;
+    std::shared_ptr<std::string> error;
+  };
+
+  class ILPGAFFERMOVIE_NO_EXPORT SharedFilters
+  {
+  public:
+    // Creates a filter for the raw frames of a video stream using a cache, so that filter graphs
+    // are not re-configured for every frame.
+    static FilterCacheEntry get(const FilterCacheKey &key);
+
+    // Erase all filters for the given file from the cache.
+    static void eraseFile(const std::string &fileName);
+
+    // Clear the entire cache.
+    static void clear();
+  };
+
+}// namespace shared_filters_internal
+}// namespace IlpGafferMovie
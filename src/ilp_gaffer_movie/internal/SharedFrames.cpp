@@ -1,51 +1,387 @@
 #include "internal/SharedFrames.h"
 
+#include <algorithm>// std::max
+#include <atomic>// std::atomic
 #include <cassert>// assert
+#include <cstdlib>// std::getenv, std::strtoull
+#include <iterator>// std::next
+#include <limits>// std::numeric_limits
+#include <memory>// std::shared_ptr, std::weak_ptr, std::make_shared
+#include <mutex>// std::mutex, std::lock_guard
+#include <string_view>// std::string_view
+#include <unordered_map>// std::unordered_map
+#include <utility>// std::move
+#include <vector>// std::vector
 
 #include <boost/functional/hash.hpp>// boost::hash_combine
 
+#include <IECore/Canceller.h>// IECore::Canceller, IECore::Cancelled
+
+#include "ilp_gaffer_movie/startup.hpp"// IlpGafferMovie::Startup
+
+#include "ilp_movie/trace.hpp"// ILP_MOVIE_TRACE_SPAN
+
+#include "internal/DiskFrameCache.h"
+#include "internal/FramePlayback.h"
 #include "internal/LRUCache.h"// IECorePreview::LRUCache
+#include "internal/SharedColorProcessors.h"
 #include "internal/SharedDecoders.h"
+#include "internal/SharedFilters.h"
 
 namespace {
 
 using CacheKey = IlpGafferMovie::shared_frames_internal::FrameCacheKey;
 using CacheEntry = IlpGafferMovie::shared_frames_internal::FrameCacheEntry;
-using FrameLRUCache = IECorePreview::LRUCache<CacheKey, CacheEntry>;
+using IlpGafferMovie::cached_frame_internal::CachedFrame;
+using IlpGafferMovie::cached_frame_internal::FrameStorage;
+using IlpGafferMovie::disk_frame_cache_internal::DiskFrameCache;
+using IlpGafferMovie::frame_playback_internal::FramePlayback;
+// Threads requesting a frame that is being decoded help decoding it, instead of blocking until
+// it is done, see Startup::initParallelFor.
+using FrameLRUCache =
+  IECorePreview::LRUCache<CacheKey, CacheEntry, IECorePreview::LRUCachePolicy::TaskParallel>;
 
-FrameLRUCache &cache()
+// Default memory limit, used unless overridden by the environment.
+constexpr size_t kDefaultMemoryLimitMb = 2048U;
+constexpr size_t kBytesPerMb = 1024U * 1024U;
+
+[[nodiscard]] size_t initialMemoryLimit()
 {
-  static FrameLRUCache cache{
-    [](const CacheKey &key, size_t &cost, const IECore::Canceller * /*canceller*/) {
-      cost = 1U;
-      CacheEntry result = {};
+  size_t mb = kDefaultMemoryLimitMb;
+  if (const char *env = std::getenv("ILP_GAFFER_MOVIE_FRAME_CACHE_MB"); env != nullptr) {// NOLINT
+    char *end = nullptr;
+    const auto value = std::strtoull(env, &end, /*base=*/10);
+    if (end != env && *end == '\0') { mb = static_cast<size_t>(value); }
+  }
+  return mb * kBytesPerMb;
+}
+
+std::atomic<size_t> g_memoryLimit{ initialMemoryLimit() };
+
+[[nodiscard]] bool initialHalfStorage()
+{
+  const char *env = std::getenv("ILP_GAFFER_MOVIE_FRAME_CACHE_HALF");// NOLINT
+  return env != nullptr && std::string_view{ env } == "1";
+}
+
+std::atomic<bool> g_halfStorage{ initialHalfStorage() };
 
-      const auto decoderEntry =
-        IlpGafferMovie::shared_decoders_internal::SharedDecoders::get(key.decoder_key);
-      if (decoderEntry.decoder == nullptr) {
-        result.error = std::make_shared<std::string>("Bad decoder");
+[[nodiscard]] bool initialNativeStorage()
+{
+  const char *env = std::getenv("ILP_GAFFER_MOVIE_FRAME_CACHE_NATIVE");// NOLINT
+  return env != nullptr && std::string_view{ env } == "1";
+}
+
+std::atomic<bool> g_nativeStorage{ initialNativeStorage() };
+
+// Counters are only used for statistics, so relaxed ordering is sufficient.
+std::atomic<size_t> g_misses{ 0U };
+std::atomic<size_t> g_requests{ 0U };
+std::atomic<size_t> g_evictions{ 0U };
+std::atomic<size_t> g_decodes{ 0U };
+std::atomic<size_t> g_prefetches{ 0U };
+
+// Set while explicitly erasing entries on the current thread, so that these are not counted
+// as evictions.
+thread_local bool t_explicitRemoval = false;
+
+// Set while prefetching on the current thread, so that prefetched frames are not counted as
+// misses.
+thread_local bool t_prefetching = false;
+
+FramePlayback &playback()
+{
+  static FramePlayback playback;
+  return playback;
+}
+
+// Key for the raw frame that a filtered frame is derived from.
+[[nodiscard]] CacheKey rawFrameKey(const CacheKey &key)
+{
+  CacheKey k = key;
+  k.decoder_handle =
+    IlpGafferMovie::shared_decoders_internal::SharedDecoders::rawHandle(key.decoder_handle);
+  k.color_processor_handle = IlpGafferMovie::shared_color_processors_internal::kNoColorProcessor;
+  return k;
+}
+
+// Raw frames held by frames stored as native YUV, by raw frame key. These raw frames are dropped
+// from the cache, see releaseRawFrame, but other filtered frames of the same raw frame, e.g. for
+// another filter graph or color space, are still derived from them rather than decoded again.
+// Only weak references are kept, a raw frame is released with the last native YUV frame using it.
+class NativeRawFrames
+{
+public:
+  void insert(const CacheKey &rawKey, const std::shared_ptr<const CachedFrame> &frame)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _frames[rawKey] = frame;
+
+    // Expired references are removed once the number of references has doubled.
+    if (_frames.size() < _pruneSize) { return; }
+    for (auto it = _frames.begin(); it != _frames.end();) {
+      it = it->second.expired() ? _frames.erase(it) : std::next(it);
+    }
+    _pruneSize = std::max(kMinPruneSize, 2U * _frames.size());
+  }
+
+  // Returns null if no native YUV frame holds the raw frame.
+  [[nodiscard]] std::shared_ptr<const CachedFrame> find(const CacheKey &rawKey)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    const auto it = _frames.find(rawKey);
+    if (it == _frames.end()) { return nullptr; }
+    auto frame = it->second.lock();
+    if (frame == nullptr) { _frames.erase(it); }
+    return frame;
+  }
+
+  void erase(const CacheKey &rawKey)
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _frames.erase(rawKey);
+  }
+
+  void eraseFile(const std::string &fileName)
+  {
+    using IlpGafferMovie::shared_decoders_internal::SharedDecoders;
+    std::lock_guard<std::mutex> lock{ _mutex };
+    for (auto it = _frames.begin(); it != _frames.end();) {
+      it = SharedDecoders::resolve(it->first.decoder_handle).fileName == fileName
+             ? _frames.erase(it)
+             : std::next(it);
+    }
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _frames.clear();
+    _pruneSize = kMinPruneSize;
+  }
+
+private:
+  static constexpr size_t kMinPruneSize = 64U;
+
+  std::mutex _mutex;
+  size_t _pruneSize = kMinPruneSize;
+  std::unordered_map<CacheKey, std::weak_ptr<const CachedFrame>, boost::hash<CacheKey>> _frames;
+};
+
+NativeRawFrames &nativeRawFrames()
+{
+  static NativeRawFrames nativeRawFrames;
+  return nativeRawFrames;
+}
+
+FrameLRUCache &cache();
+
+
+// Raw frames are decoded in the native pixel format of the video stream, unless they were
+// evicted to the disk cache, from which they are mapped back without decoding.
+[[nodiscard]] CacheEntry decodeFrame(const CacheKey &key,
+  size_t &cost,
+  const IECore::Canceller *canceller)
+{
+  using IlpGafferMovie::shared_decoders_internal::SharedDecoders;
+
+  CacheEntry result = {};
+  if (auto mappedFrame = DiskFrameCache::load(key)) {
+    cost = mappedFrame->memoryCost();
+    result.frame = std::move(mappedFrame);
+    return result;
+  }
+
+  ILP_MOVIE_TRACE_SPAN_ARG("frame cache", "decode frame", "frame", key.frame_nb);
+  g_decodes.fetch_add(1U, std::memory_order_relaxed);
+  const auto decoderEntry = SharedDecoders::get(SharedDecoders::resolve(key.decoder_handle));
+  if (decoderEntry.decoder == nullptr) {
+    result.error = std::make_shared<std::string>("Bad decoder");
+    return result;
+  }
+
+  auto frame = std::make_unique<ilp_movie::Frame>();
+  if (!SharedDecoders::decodeVideoFrame(
+        decoderEntry, key.video_stream_index, key.frame_nb, /*out*/ *frame, canceller)) {
+    result.error = std::make_shared<std::string>("Cannot seek to frame");
+    return result;
+  }
+  const auto cachedFrame = std::make_shared<CachedFrame>(std::move(frame));
+  cost = cachedFrame->memoryCost();
+  result.frame = cachedFrame;
+  return result;
+}
+
+// Filtered frames are derived from the cached raw frames, so that changing the filter graph
+// does not require decoding frames again. Color conversion, if any, is fused with filtering.
+[[nodiscard]] CacheEntry filterFrame(const CacheKey &key,
+  size_t &cost,
+  const IECore::Canceller *canceller)
+{
+  using IlpGafferMovie::shared_filters_internal::FilterCacheKey;
+  using IlpGafferMovie::shared_filters_internal::SharedFilters;
+
+  CacheEntry result = {};
+  const CacheKey rawKey = rawFrameKey(key);
+  CacheEntry rawEntry = {};
+  if (!cache().cached(rawKey)) {
+    // The raw frame may only be held by a frame stored as native YUV.
+    rawEntry.frame = nativeRawFrames().find(rawKey);
+  }
+  if (rawEntry.frame == nullptr) { rawEntry = cache().get(rawKey, canceller); }
+  if (rawEntry.frame == nullptr) {
+    result.error = rawEntry.error;
+    return result;
+  }
+
+  const auto filterEntry = SharedFilters::get(FilterCacheKey{
+    /*.decoder_handle=*/key.decoder_handle, /*.video_stream_index=*/key.video_stream_index });
+  if (filterEntry.filter == nullptr) {
+    result.error = filterEntry.error != nullptr ? filterEntry.error
+                                                : std::make_shared<std::string>("Bad filter");
+    return result;
+  }
+
+  // Pure pixel format conversions are deferred until tiles are read, sharing the raw frame.
+  if (g_nativeStorage.load(std::memory_order_relaxed)
+      && key.color_processor_handle
+           == IlpGafferMovie::shared_color_processors_internal::kNoColorProcessor) {
+    if (const auto opts = filterEntry.filter->NativeConvert(); opts.has_value()) {
+      if (auto nativeFrame = CachedFrame::makeNativeYuv(rawEntry.frame, *opts)) {
+        cost = nativeFrame->memoryCost();
+        result.frame = std::move(nativeFrame);
         return result;
       }
+    }
+  }
+
+  IECore::Canceller::check(canceller);
+  ILP_MOVIE_TRACE_SPAN_ARG("frame cache", "filter frame", "frame", key.frame_nb);
+  auto frame = std::make_unique<ilp_movie::Frame>();
+  if (!filterEntry.filter->FilterFrame(*rawEntry.frame->decoded(), /*out*/ *frame)) {
+    result.error = std::make_shared<std::string>("Cannot filter frame");
+    return result;
+  }
+  if (key.color_processor_handle
+      != IlpGafferMovie::shared_color_processors_internal::kNoColorProcessor) {
+    // Converted in place, the unconverted frame is never cached.
+    IlpGafferMovie::shared_color_processors_internal::SharedColorProcessors::convertFrame(
+      key.color_processor_handle, /*out*/ *frame);
+  }
+
+  // Falls back to storing the frame as is if the pixel format is not planar float.
+  std::shared_ptr<const CachedFrame> cachedFrame;
+  if (g_halfStorage.load(std::memory_order_relaxed)) {
+    cachedFrame = CachedFrame::makeHalf(*frame);
+  }
+  if (cachedFrame == nullptr) { cachedFrame = std::make_shared<CachedFrame>(std::move(frame)); }
+  cost = cachedFrame->memoryCost();
+  result.frame = cachedFrame;
+  return result;
+}
+
+// Raw frames evicted from memory are written to the disk cache, if enabled. Frames stored as
+// native YUV hold on to their raw frame, which is written instead. Other filtered frames are
+// cheap to derive from raw frames, and would be stale as soon as the filter graph changes.
+void spillFrame(const CacheKey &key, const CacheEntry &entry)
+{
+  using IlpGafferMovie::shared_decoders_internal::SharedDecoders;
+
+  if (entry.frame == nullptr || !DiskFrameCache::enabled()) { return; }
+  if (entry.frame->storage() == FrameStorage::Decoded
+      && SharedDecoders::isRawHandle(key.decoder_handle)) {
+    DiskFrameCache::store(key, entry.frame);
+  } else if (entry.frame->storage() == FrameStorage::NativeYuv) {
+    DiskFrameCache::store(rawFrameKey(key), entry.frame->rawFrame());
+  }
+}
+
+FrameLRUCache &cache()
+{
+  static FrameLRUCache cache{
+    [](const CacheKey &key, size_t &cost, const IECore::Canceller *canceller) {
+      using IlpGafferMovie::shared_decoders_internal::SharedDecoders;
 
+      ILP_MOVIE_TRACE_INSTANT_ARG("frame cache", "miss", "frame", key.frame_nb);
+
+      // The getter runs inside the task arena of a TaskMutex, so threads waiting for the same
+      // frame join the decoding and conversion tasks.
+      IlpGafferMovie::Startup::initParallelFor();
+
+      // Errors are cheap to keep around, but must have a non-zero cost.
+      cost = 1U;
+      CacheEntry result = {};
       try {
-        auto frame = std::make_unique<ilp_movie::Frame>();
-        if (!decoderEntry.decoder->DecodeVideoFrame(
-              key.video_stream_index, key.frame_nb, /*out*/ *frame)) {
-          result.error = std::make_shared<std::string>("Cannot seek to frame");
-          return result;
+        if (SharedDecoders::isRawHandle(key.decoder_handle)) {
+          result = decodeFrame(key, cost, canceller);
+        } else {
+          if (!t_prefetching) { g_misses.fetch_add(1U, std::memory_order_relaxed); }
+          result = filterFrame(key, cost, canceller);
         }
-        result.frame.reset(frame.release());// NOLINT
+      } catch (IECore::Cancelled &) {
+        // Not cached, the frame is decoded again when requested.
+        throw;
       } catch (std::exception &ex) {
+        result = CacheEntry{};
         result.error = std::make_shared<std::string>(ex.what());
-        return result;
       }
+      playback().insert(key, cost);
       return result;
     },
-    /*maxCost=*/200
+    // The memory limit is enforced by evicting frames explicitly, see limitMemory.
+    /*maxCost=*/std::numeric_limits<size_t>::max(),
+    /*removalCallback=*/
+    [](const CacheKey &key, const CacheEntry &entry) {
+      playback().remove(key);
+      if (!t_explicitRemoval) {
+        ILP_MOVIE_TRACE_INSTANT_ARG("frame cache", "evict", "frame", key.frame_nb);
+        g_evictions.fetch_add(1U, std::memory_order_relaxed);
+        spillFrame(key, entry);
+      }
+    }
   };
   return cache;
 }
 
+// Frames stored as native YUV share the pixels of the raw frame and account for them, so the
+// raw frame is dropped from the cache to avoid counting the pixels twice. It remains available
+// to other filtered frames through the native YUV frame, see NativeRawFrames. Done once the
+// getter has returned, since the raw frame is requested from within the getter.
+void releaseRawFrame(const CacheKey &key, const CacheEntry &entry)
+{
+  if (entry.frame == nullptr || entry.frame->storage() != FrameStorage::NativeYuv) {
+    return;
+  }
+  const CacheKey rawKey = rawFrameKey(key);
+  nativeRawFrames().insert(rawKey, entry.frame->rawFrame());
+  if (!cache().cached(rawKey)) { return; }
+  t_explicitRemoval = true;
+  cache().erase(rawKey);
+  t_explicitRemoval = false;
+}
+
+// Removes all frames from memory, leaving the disk cache as is.
+void clearMemory()
+{
+  t_explicitRemoval = true;
+  cache().clear();
+  t_explicitRemoval = false;
+  playback().clear();
+  nativeRawFrames().clear();
+}
+
+// Evict frames until the memory limit is met.
+void limitMemory(const CacheKey *keep)
+{
+  const size_t limit = g_memoryLimit.load(std::memory_order_relaxed);
+  const size_t usage = cache().currentCost();
+  if (usage <= limit) { return; }
+
+  // Note that other threads may be evicting concurrently, in which case erase simply
+  // returns false for frames that have already been removed.
+  for (auto &&key : playback().victims(usage - limit, keep)) { cache().erase(key); }
+}
+
 }// namespace
 
 namespace IlpGafferMovie::shared_frames_internal {
@@ -54,37 +390,154 @@ bool operator==(const FrameCacheKey &lhs, const FrameCacheKey &rhs) noexcept
 {
   // clang-format off
   return 
-    lhs.decoder_key.fileName == rhs.decoder_key.fileName && 
-    lhs.decoder_key.filterGraphDescr.filter_descr == 
-        rhs.decoder_key.filterGraphDescr.filter_descr && 
-    lhs.decoder_key.filterGraphDescr.out_pix_fmt_name == 
-        rhs.decoder_key.filterGraphDescr.out_pix_fmt_name &&
+    lhs.decoder_handle == rhs.decoder_handle && 
     lhs.video_stream_index == rhs.video_stream_index && 
-    lhs.frame_nb == rhs.frame_nb;
+    lhs.frame_nb == rhs.frame_nb &&
+    lhs.color_processor_handle == rhs.color_processor_handle;
   // clang-format on
 }
 
 std::size_t hash_value(const FrameCacheKey &k)
 {
   std::size_t seed = 0;
-  boost::hash_combine(/*out*/ seed, k.decoder_key.fileName);
-  boost::hash_combine(/*out*/ seed, k.decoder_key.filterGraphDescr.filter_descr);
-  boost::hash_combine(/*out*/ seed, k.decoder_key.filterGraphDescr.out_pix_fmt_name);
+  boost::hash_combine(/*out*/ seed, k.decoder_handle);
   boost::hash_combine(/*out*/ seed, k.video_stream_index);
   boost::hash_combine(/*out*/ seed, k.frame_nb);
+  boost::hash_combine(/*out*/ seed, k.color_processor_handle);
   return seed;
 }
 
-FrameCacheEntry SharedFrames::get(const FrameCacheKey &key) { return cache().get(key); }
+FrameCacheEntry SharedFrames::get(const FrameCacheKey &key, const IECore::Canceller *canceller)
+{
+  // Requests that are neither hits nor misses are waiting for another thread to decode the frame.
+  ILP_MOVIE_TRACE_SPAN_ARG("frame cache", "get frame", "frame", key.frame_nb);
+#if ILP_MOVIE_ENABLE_TRACE
+  if (ilp_movie::IsTraceEnabled() && cache().cached(key)) {
+    ilp_movie::TraceInstant("frame cache", "hit", "frame", key.frame_nb);
+  }
+#endif
+  g_requests.fetch_add(1U, std::memory_order_relaxed);
+  playback().request(key);
+  if (!shared_decoders_internal::SharedDecoders::isRawHandle(key.decoder_handle)) {
+    // The raw frame follows the same playhead as the filtered frame, even if the filtered frame
+    // is cached.
+    playback().request(rawFrameKey(key));
+  }
+  auto entry = cache().get(key, canceller);
+  releaseRawFrame(key, entry);
+  limitMemory(&key);
+  return entry;
+}
 
-void SharedFrames::erase(const FrameCacheKey &key) { cache().erase(key); }
+bool SharedFrames::prefetch(const FrameCacheKey &key)
+{
+  ILP_MOVIE_TRACE_SPAN_ARG("frame cache", "prefetch frame", "frame", key.frame_nb);
+  if (cache().cached(key)) { return true; }
 
-void SharedFrames::clear() { cache().clear(); }
+  // Don't decode frames that would be evicted right away, e.g. when looping over a range
+  // that doesn't fit in the cache.
+  const size_t limit = g_memoryLimit.load(std::memory_order_relaxed);
+  const size_t usage = cache().currentCost();
+  const size_t available = usage < limit ? limit - usage : 0U;
+  if (!playback().wouldKeep(key, playback().streamFrameCost(key), available)) { return false; }
 
-void SharedFrames::setMaxFrames(const size_t numFrames) { cache().setMaxCost(numFrames); }
+  t_prefetching = true;
+  CacheEntry entry;
+  try {
+    entry = cache().get(key);
+  } catch (...) {
+    t_prefetching = false;
+    throw;
+  }
+  t_prefetching = false;
+  releaseRawFrame(key, entry);
+  g_prefetches.fetch_add(1U, std::memory_order_relaxed);
+  limitMemory(&key);
+  return true;
+}
 
-size_t SharedFrames::getMaxFrames() { return cache().getMaxCost(); }
+void SharedFrames::erase(const FrameCacheKey &key)
+{
+  t_explicitRemoval = true;
+  cache().erase(key);
+  t_explicitRemoval = false;
+  nativeRawFrames().erase(key);
+  DiskFrameCache::erase(key);
+}
+
+void SharedFrames::eraseFile(const std::string &fileName)
+{
+  using shared_decoders_internal::SharedDecoders;
+
+  t_explicitRemoval = true;
+  for (auto &&key : playback().keysForFile(fileName)) { cache().erase(key); }
+  t_explicitRemoval = false;
+  nativeRawFrames().eraseFile(fileName);
+
+  // Only raw frames are written to disk, and these share the raw decoder handle of the file.
+  DiskFrameCache::eraseDecoder(
+    SharedDecoders::intern(shared_decoders_internal::rawDecoderKey(fileName)));
+}
+
+void SharedFrames::clear()
+{
+  clearMemory();
+  DiskFrameCache::clear();
+}
 
-size_t SharedFrames::numFrames() { return cache().currentCost(); }
+void SharedFrames::setMemoryLimit(const size_t bytes)
+{
+  g_memoryLimit.store(bytes, std::memory_order_relaxed);
+  limitMemory(/*keep=*/nullptr);
+}
+
+size_t SharedFrames::getMemoryLimit() { return g_memoryLimit.load(std::memory_order_relaxed); }
+
+void SharedFrames::setHalfStorage(const bool enabled)
+{
+  if (g_halfStorage.exchange(enabled, std::memory_order_relaxed) != enabled) { clearMemory(); }
+}
+
+bool SharedFrames::getHalfStorage() { return g_halfStorage.load(std::memory_order_relaxed); }
+
+void SharedFrames::setNativeStorage(const bool enabled)
+{
+  if (g_nativeStorage.exchange(enabled, std::memory_order_relaxed) != enabled) {
+    clearMemory();
+  }
+}
+
+bool SharedFrames::getNativeStorage() { return g_nativeStorage.load(std::memory_order_relaxed); }
+
+size_t SharedFrames::memoryUsage() { return cache().currentCost(); }
+
+FrameCacheStatistics SharedFrames::statistics()
+{
+  FrameCacheStatistics stats{};
+  stats.memoryLimit = getMemoryLimit();
+  stats.memoryUsage = memoryUsage();
+  const size_t requests = g_requests.load(std::memory_order_relaxed);
+  stats.misses = g_misses.load(std::memory_order_relaxed);
+  stats.hits = requests > stats.misses ? requests - stats.misses : 0U;
+  stats.evictions = g_evictions.load(std::memory_order_relaxed);
+  stats.decodes = g_decodes.load(std::memory_order_relaxed);
+  stats.prefetches = g_prefetches.load(std::memory_order_relaxed);
+  const auto diskStats = DiskFrameCache::statistics();
+  stats.diskLimit = diskStats.sizeLimit;
+  stats.diskUsage = diskStats.usage;
+  stats.diskHits = diskStats.hits;
+  stats.diskWrites = diskStats.writes;
+  return stats;
+}
+
+void SharedFrames::resetStatistics()
+{
+  g_misses.store(0U, std::memory_order_relaxed);
+  g_requests.store(0U, std::memory_order_relaxed);
+  g_evictions.store(0U, std::memory_order_relaxed);
+  g_decodes.store(0U, std::memory_order_relaxed);
+  g_prefetches.store(0U, std::memory_order_relaxed);
+  DiskFrameCache::resetStatistics();
+}
 
-}// namespace IlpGafferMovie::shared_frames_internal
\ No newline at end of file
+}// namespace IlpGafferMovie::shared_frames_internal
@@ -6,52 +6,144 @@
 
 #include "ilp_gaffer_movie/ilp_gaffer_movie_export.hpp"
 
-#include "ilp_movie/frame.hpp"// ilp_movie::Frame
-
+#include "internal/CachedFrame.h"
+#include "internal/SharedColorProcessors.h"
 #include "internal/SharedDecoders.h"
 
 namespace IlpGafferMovie {
 namespace shared_frames_internal {
 
+  // The decoder key, including the filter graph, is interned so that looking up frames doesn't
+  // require hashing or comparing strings. The same goes for the (optional) color conversion
+  // applied to filtered frames.
   struct FrameCacheKey
   {
-    //ilp_movie::Decoder *decoder = nullptr;
-    shared_decoders_internal::DecoderCacheKey decoder_key;
+    shared_decoders_internal::DecoderHandle decoder_handle =
+      shared_decoders_internal::kInvalidDecoderHandle;
     int video_stream_index = -1;
     int frame_nb = -1;
+    shared_color_processors_internal::ColorProcessorHandle color_processor_handle =
+      shared_color_processors_internal::kNoColorProcessor;
   };
 
+  bool operator==(const FrameCacheKey &lhs, const FrameCacheKey &rhs) noexcept;
+  std::size_t hash_value(const FrameCacheKey &k);
+
   // For success, frame should be set, and error left null.
   // For failure, frame should be left null, and error should be set.
   struct FrameCacheEntry
   {
-    std::shared_ptr<ilp_movie::Frame> frame;
+    std::shared_ptr<const cached_frame_internal::CachedFrame> frame;
     std::shared_ptr<std::string> error;
   };
 
+  struct FrameCacheStatistics
+  {
+    // [bytes]
+    size_t memoryLimit = 0U;
+    size_t memoryUsage = 0U;
+
+    // Requests for frames that were already cached (hits), and that had to be decoded (misses).
+    size_t hits = 0U;
+    size_t misses = 0U;
+
+    // Frames removed to make room for other frames, not counting explicit erase/clear.
+    size_t evictions = 0U;
+
+    // Raw frames that had to be decoded. Filtered frames are derived from cached raw frames, so
+    // a miss does not necessarily require decoding.
+    size_t decodes = 0U;
+
+    // Frames decoded (or filtered) ahead of being requested. Prefetching does not count as
+    // requests, so a prefetched frame that is later requested counts as a hit.
+    size_t prefetches = 0U;
+
+    // Second tier, see DiskFrameCache. Raw frames mapped back from disk (hits) do not count as
+    // decodes, and frames written to disk (writes) are a subset of the evictions.
+    size_t diskLimit = 0U;
+    size_t diskUsage = 0U;
+    size_t diskHits = 0U;
+    size_t diskWrites = 0U;
+  };
+
   class ILPGAFFERMOVIE_NO_EXPORT SharedFrames
   {
   public:
     // Creates a frame using a cache, so you don't end up decoding the same
     // frame multiple times.
-    static FrameCacheEntry get(const FrameCacheKey &key);
+    //
+    // The cache has two levels. Raw frames, in the native pixel format of the video stream, are
+    // decoded once per file, regardless of the filter graph. Filtered frames are derived from
+    // the raw frames, so changing the filter graph only requires filtering frames again. Filtered
+    // frames with a color processor are converted once, right after filtering, and only the
+    // converted frame is cached. Filtered frames stored in the native pixel format replace the
+    // raw frame they share pixels with, see setNativeStorage. Raw frames evicted from memory
+    // are kept on disk, if enabled, and mapped back instead of being decoded, see DiskFrameCache.
+    //
+    // Throws IECore::Cancelled if the canceller is cancelled while decoding, in which case
+    // nothing is cached and decoding stops within one packet.
+    static FrameCacheEntry get(const FrameCacheKey &key,
+      const IECore::Canceller *canceller = nullptr);
+
+    // Decodes a frame into the cache ahead of it being requested, without moving the playhead
+    // of the video stream. Returns false if the frame is not cached because it would be the
+    // first frame to be evicted, i.e. the cache is full of frames that will be needed sooner.
+    // Throws IECore::Cancelled if the speculative work is cancelled, see DecodeScheduler.
+    static bool prefetch(const FrameCacheKey &key);
 
     // Erase a single frame from the cache.
     static void erase(const FrameCacheKey &key);
 
-    // Clear the entire cache.
+    // Erase all frames decoded from the given file, both raw and filtered, from the cache,
+    // including frames on disk.
+    static void eraseFile(const std::string &fileName);
+
+    // Clear the entire cache, including frames on disk.
     static void clear();
 
-    // Sets the limit for the number of frames that will
-    // be cached internally.
-    static void setMaxFrames(size_t numFrames);
+    // Sets the limit, in [bytes], for the memory used by frames cached internally.
+    //
+    // When the limit is exceeded frames are evicted based on the playhead of each video stream,
+    // i.e. the most recently requested frame and the direction of playback. Frames outside the
+    // range being played are evicted first, followed by the frames that will be needed furthest
+    // into the future, assuming that playback loops over that range. Looped playback of a range
+    // that almost fits in the cache then mostly hits the cache, instead of always evicting the
+    // next frame as a least recently used policy would.
+    static void setMemoryLimit(size_t bytes);
+
+    // Returns the limit, in [bytes], for the memory used by frames cached internally.
+    // Defaults to ILP_GAFFER_MOVIE_FRAME_CACHE_MB megabytes if that environment variable is set.
+    static size_t getMemoryLimit();
+
+    // Sets whether filtered frames are cached with half precision planes, which halves the memory
+    // used per frame. Raw frames are always cached as decoded. Frames already in the cache are
+    // erased when the setting changes, so that all cached frames use the same storage.
+    static void setHalfStorage(bool enabled);
+
+    // Returns whether filtered frames are cached with half precision planes. Defaults to true if
+    // the ILP_GAFFER_MOVIE_FRAME_CACHE_HALF environment variable is set to 1.
+    static bool getHalfStorage();
+
+    // Sets whether filtered frames that are a native pixel format conversion of the raw frame,
+    // see ilp_movie::FrameFilter::NativeConvert, are cached in the native (YUV) pixel format of
+    // the raw frame. Tiles are then converted to float when read, using a fraction of the memory
+    // of a float frame, e.g. 4 bytes per pixel for yuv422p10le instead of 12. Takes precedence
+    // over half storage, which is used for other frames. Frames already in the cache are erased
+    // when the setting changes.
+    static void setNativeStorage(bool enabled);
+
+    // Returns whether filtered frames are cached in the native pixel format when possible.
+    // Defaults to true if the ILP_GAFFER_MOVIE_FRAME_CACHE_NATIVE environment variable is set
+    // to 1.
+    static bool getNativeStorage();
+
+    // Returns the memory, in [bytes], currently used by cached frames.
+    static size_t memoryUsage();
 
-    // Returns the limit for the number of frames that will
-    // be cached internally.
-    static size_t getMaxFrames();
+    // Returns cache usage and counters accumulated since the last call to resetStatistics.
+    static FrameCacheStatistics statistics();
 
-    // Returns the number of frames currently in the cache.
-    static size_t numFrames();
+    static void resetStatistics();
   };
 
 }// namespace shared_frames_internal
@@ -27,7 +27,6 @@
 #include <vector>
 
 #include "ilp_gaffer_movie/av_reader.hpp"
-#include "internal/trace.hpp"
 
 namespace {
 
@@ -66,6 +65,16 @@ private:
   IlpGafferMovie::MovieReader::FrameMaskMode _mode;
 };
 
+// Returns true if the filter graph only flips frames vertically, which is done more cheaply when
+// reading tiles. The default filter graph of the MovieReader has always been "vflip".
+[[nodiscard]] bool isVflipFilterGraph(const std::string &filterGraph)
+{
+  const auto first = filterGraph.find_first_not_of(" \t\n");
+  if (first == std::string::npos) { return false; }
+  const auto last = filterGraph.find_last_not_of(" \t\n");
+  return filterGraph.compare(first, last - first + 1U, "vflip") == 0;
+}
+
 }// namespace
 
 GAFFER_NODE_DEFINE_TYPE(IlpGafferMovie::MovieReader);
@@ -145,54 +154,93 @@ MovieReader::MovieReader(const std::string &name) : GafferImage::ImageNode(name)
     /*name=*/"filterGraph",
     /*direction=*/Plug::In,
     /*defaultValue=*/"vflip"));
+  addChild(new IntPlug(// [8]
+    /*name=*/"orientation",
+    /*direction=*/Plug::In,
+    /*defaultValue=*/static_cast<int>(Orientation::Native),
+    /*minValue=*/static_cast<int>(Orientation::Native),
+    /*maxValue=*/static_cast<int>(Orientation::FlipVertical)));
+  addChild(new IntPlug(// [9]
+    /*name=*/"prefetchFrames",
+    /*direction=*/Plug::In,
+    /*defaultValue=*/8,
+    /*minValue=*/0));
+  addChild(new IntPlug(// [10]
+    /*name=*/"colorConversion",
+    /*direction=*/Plug::In,
+    /*defaultValue=*/static_cast<int>(ColorConversion::PerTile),
+    /*minValue=*/static_cast<int>(ColorConversion::PerTile),
+    /*maxValue=*/static_cast<int>(ColorConversion::PerFrame)));
 
   // Please the LINTer, it doesn't like bit-wise operations on signed integer types.
   constexpr auto kPlugDefault = static_cast<unsigned int>(Plug::Default);
   constexpr auto kPlugSerialisable = static_cast<unsigned int>(Plug::Serialisable);
 
-  addChild(new IntVectorDataPlug(// [8]
+  addChild(new IntVectorDataPlug(// [11]
     /*name=*/"availableFrames",
     /*direction=*/Plug::Out,
     /*defaultValue=*/new IECore::IntVectorData,
     /*flags=*/kPlugDefault & ~kPlugSerialisable));
-  addChild(new BoolPlug(// [9]
+  addChild(new BoolPlug(// [12]
     /*name=*/"fileValid",
     /*direction=*/Plug::Out,
     /*defaultValue=*/false,
     /*flags=*/kPlugDefault & ~kPlugSerialisable));
-  addChild(new StringPlug(// [10]
+  addChild(new StringPlug(// [13]
     /*name=*/"probe",
     /*direction=*/Plug::Out,
     /*defaultValue=*/"",
     /*flags=*/kPlugDefault & ~kPlugSerialisable));
 
-  addChild(new BoolPlug(// [11]
+  addChild(new BoolPlug(// [14]
     /*name=*/"__intermediateFileValid",
     /*direction=*/Plug::In,
     /*defaultValue=*/false,
     /*flags=*/kPlugDefault & ~kPlugSerialisable));
-  addChild(new AtomicCompoundDataPlug(// [12]
+  addChild(new AtomicCompoundDataPlug(// [15]
     /*name=*/"__intermediateMetadata",
     /*direction=*/Plug::In,
     /*defaultValue=*/new IECore::CompoundData,
     /*flags=*/kPlugDefault & ~kPlugSerialisable));
-  addChild(new StringPlug(// [13]
+  addChild(new StringPlug(// [16]
     /*name=*/"__intermediateColorSpace",
     /*direction=*/Plug::Out,
     /*defaultValue=*/"",
     /*flags=*/kPlugDefault & ~kPlugSerialisable));
-  addChild(new ImagePlug(// [14]
+  addChild(new ImagePlug(// [17]
     /*name=*/"__intermediateImage",
     /*direction=*/Plug::In,
     /*flags=*/kPlugDefault & ~kPlugSerialisable));
+  addChild(new StringPlug(// [18]
+    /*name=*/"__frameColorSpace",
+    /*direction=*/Plug::Out,
+    /*defaultValue=*/"",
+    /*flags=*/kPlugDefault & ~kPlugSerialisable));
+  addChild(new BoolPlug(// [19]
+    /*name=*/"__tileColorConversion",
+    /*direction=*/Plug::Out,
+    /*defaultValue=*/true,
+    /*flags=*/kPlugDefault & ~kPlugSerialisable));
+  addChild(new StringPlug(// [20]
+    /*name=*/"__avFilterGraph",
+    /*direction=*/Plug::Out,
+    /*defaultValue=*/"",
+    /*flags=*/kPlugDefault & ~kPlugSerialisable));
+  addChild(new IntPlug(// [21]
+    /*name=*/"__avOrientation",
+    /*direction=*/Plug::Out,
+    /*defaultValue=*/static_cast<int>(AvReader::Orientation::Native),
+    /*minValue=*/static_cast<int>(AvReader::Orientation::Native),
+    /*maxValue=*/static_cast<int>(AvReader::Orientation::FlipVertical),
+    /*flags=*/kPlugDefault & ~kPlugSerialisable));
 
   // We don't really do much work ourselves - we just
   // defer to internal nodes to do the hard work.
 
   AvReaderPtr avReader = new AvReader(/*name=*/"__avReader");
-  addChild(avReader);// [15]
+  addChild(avReader);// [22]
   ColorSpacePtr colorSpace = new ColorSpace(/*name=*/"__colorSpace");
-  addChild(colorSpace);// [16]
+  addChild(colorSpace);// [23]
 
   // NOTE(tohi):
   // Add all children before using the member functions to get
@@ -202,13 +250,17 @@ MovieReader::MovieReader(const std::string &name) : GafferImage::ImageNode(name)
   avReader->refreshCountPlug()->setInput(refreshCountPlug());
   avReader->missingFrameModePlug()->setInput(missingFrameModePlug());
   avReader->videoStreamPlug()->setInput(videoStreamPlug());
-  avReader->filterGraphPlug()->setInput(filterGraphPlug());
+  avReader->filterGraphPlug()->setInput(_avFilterGraphPlug());
+  avReader->orientationPlug()->setInput(_avOrientationPlug());
+  avReader->prefetchFramesPlug()->setInput(prefetchFramesPlug());
+  avReader->colorSpacePlug()->setInput(_frameColorSpacePlug());
   _intermediateMetadataPlug()->setInput(avReader->outPlug()->metadataPlug());
   _intermediateFileValidPlug()->setInput(avReader->fileValidPlug());
 
   colorSpace->inPlug()->setInput(avReader->outPlug());
   colorSpace->inputSpacePlug()->setInput(_intermediateColorSpacePlug());
   colorSpace->processUnpremultipliedPlug()->setValue(true);
+  colorSpace->enabledPlug()->setInput(_tileColorConversionPlug());
   _intermediateImagePlug()->setInput(colorSpace->outPlug());
 
   availableFramesPlug()->setInput(avReader->availableFramesPlug());
@@ -252,19 +304,26 @@ PLUG_MEMBER_IMPL(colorSpacePlug, Gaffer::StringPlug, 5U);
 
 PLUG_MEMBER_IMPL(videoStreamPlug, Gaffer::StringPlug, 6U);
 PLUG_MEMBER_IMPL(filterGraphPlug, Gaffer::StringPlug, 7U);
-
-PLUG_MEMBER_IMPL(availableFramesPlug, Gaffer::IntVectorDataPlug, 8U);
-PLUG_MEMBER_IMPL(fileValidPlug, Gaffer::BoolPlug, 9U);
-PLUG_MEMBER_IMPL(probePlug, Gaffer::StringPlug, 10U);
-
-PLUG_MEMBER_IMPL(_intermediateFileValidPlug, Gaffer::BoolPlug, 11U);
-PLUG_MEMBER_IMPL(_intermediateMetadataPlug, Gaffer::AtomicCompoundDataPlug, 12U);
-PLUG_MEMBER_IMPL(_intermediateColorSpacePlug, Gaffer::StringPlug, 13U);
-PLUG_MEMBER_IMPL(_intermediateImagePlug, GafferImage::ImagePlug, 14U);
+PLUG_MEMBER_IMPL(orientationPlug, Gaffer::IntPlug, 8U);
+PLUG_MEMBER_IMPL(prefetchFramesPlug, Gaffer::IntPlug, 9U);
+PLUG_MEMBER_IMPL(colorConversionPlug, Gaffer::IntPlug, 10U);
+
+PLUG_MEMBER_IMPL(availableFramesPlug, Gaffer::IntVectorDataPlug, 11U);
+PLUG_MEMBER_IMPL(fileValidPlug, Gaffer::BoolPlug, 12U);
+PLUG_MEMBER_IMPL(probePlug, Gaffer::StringPlug, 13U);
+
+PLUG_MEMBER_IMPL(_intermediateFileValidPlug, Gaffer::BoolPlug, 14U);
+PLUG_MEMBER_IMPL(_intermediateMetadataPlug, Gaffer::AtomicCompoundDataPlug, 15U);
+PLUG_MEMBER_IMPL(_intermediateColorSpacePlug, Gaffer::StringPlug, 16U);
+PLUG_MEMBER_IMPL(_intermediateImagePlug, GafferImage::ImagePlug, 17U);
+PLUG_MEMBER_IMPL(_frameColorSpacePlug, Gaffer::StringPlug, 18U);
+PLUG_MEMBER_IMPL(_tileColorConversionPlug, Gaffer::BoolPlug, 19U);
+PLUG_MEMBER_IMPL(_avFilterGraphPlug, Gaffer::StringPlug, 20U);
+PLUG_MEMBER_IMPL(_avOrientationPlug, Gaffer::IntPlug, 21U);
 
 // Not really plugs, but follow the same pattern (they are also children).
-PLUG_MEMBER_IMPL(_avReader, AvReader, 15U);
-PLUG_MEMBER_IMPL(_colorSpace, GafferImage::ColorSpace, 16U);
+PLUG_MEMBER_IMPL(_avReader, AvReader, 22U);
+PLUG_MEMBER_IMPL(_colorSpace, GafferImage::ColorSpace, 23U);
 
 #undef PLUG_MEMBER_IMPL
 #undef PLUG_MEMBER_IMPL_SUB
@@ -286,6 +345,16 @@ void MovieReader::affects(const Gaffer::Plug *input, AffectedPlugsContainer &out
     outputs.push_back(fileValidPlug());
   } else if (input == _intermediateMetadataPlug() || input == colorSpacePlug()) {
     outputs.push_back(_intermediateColorSpacePlug());
+  } else if (input == _intermediateColorSpacePlug()) {
+    outputs.push_back(_frameColorSpacePlug());
+  } else if (input == colorConversionPlug()) {
+    outputs.push_back(_frameColorSpacePlug());
+    outputs.push_back(_tileColorConversionPlug());
+  } else if (input == filterGraphPlug()) {
+    outputs.push_back(_avFilterGraphPlug());
+    outputs.push_back(_avOrientationPlug());
+  } else if (input == orientationPlug()) {
+    outputs.push_back(_avOrientationPlug());
   } else if (input->parent<ImagePlug>() == _intermediateImagePlug()) {
     outputs.push_back(outPlug()->getChild<ValuePlug>(input->getName()));
   } else if (input == startFramePlug() || input == startModePlug() || 
@@ -310,6 +379,18 @@ void MovieReader::hash(const Gaffer::ValuePlug *output,
     fileNamePlug()->hash(/*out*/ h);
     videoStreamPlug()->hash(/*out*/ h);
     h.append(GafferImage::OpenColorIOAlgo::currentConfigHash());
+  } else if (output == _frameColorSpacePlug()) {
+    colorConversionPlug()->hash(/*out*/ h);
+    if (colorConversionPlug()->getValue() == static_cast<int>(ColorConversion::PerFrame)) {
+      _intermediateColorSpacePlug()->hash(/*out*/ h);
+    }
+  } else if (output == _tileColorConversionPlug()) {
+    colorConversionPlug()->hash(/*out*/ h);
+  } else if (output == _avFilterGraphPlug()) {
+    filterGraphPlug()->hash(/*out*/ h);
+  } else if (output == _avOrientationPlug()) {
+    filterGraphPlug()->hash(/*out*/ h);
+    orientationPlug()->hash(/*out*/ h);
   } else if (output == fileValidPlug()) {
     const FrameMaskScope scope(context, this, /*clampBlack=*/true);
     _avReader()->fileValidPlug()->hash(/*out*/ h);
@@ -322,6 +403,7 @@ void MovieReader::compute(Gaffer::ValuePlug *output, const Gaffer::Context *cont
   // using StringData = IECore::StringData;
   using StringPlug = Gaffer::StringPlug;
   using BoolPlug = Gaffer::BoolPlug;
+  using IntPlug = Gaffer::IntPlug;
 
   if (output == _intermediateColorSpacePlug()) {
     std::string colorSpace = colorSpacePlug()->getValue();
@@ -348,6 +430,28 @@ void MovieReader::compute(Gaffer::ValuePlug *output, const Gaffer::Context *cont
       }
     }
     static_cast<StringPlug *>(output)->setValue(colorSpace);// NOLINT
+  } else if (output == _frameColorSpacePlug()) {
+    // An empty color space disables conversion in the AvReader.
+    if (colorConversionPlug()->getValue() == static_cast<int>(ColorConversion::PerFrame)) {
+      static_cast<StringPlug *>(output)->setValue(// NOLINT
+        _intermediateColorSpacePlug()->getValue());
+    } else {
+      static_cast<StringPlug *>(output)->setToDefault();// NOLINT
+    }
+  } else if (output == _tileColorConversionPlug()) {
+    static_cast<BoolPlug *>(output)->setValue(// NOLINT
+      colorConversionPlug()->getValue() == static_cast<int>(ColorConversion::PerTile));
+  } else if (output == _avFilterGraphPlug()) {
+    const std::string filterGraph = filterGraphPlug()->getValue();
+    static_cast<StringPlug *>(output)->setValue(// NOLINT
+      isVflipFilterGraph(filterGraph) ? std::string{} : filterGraph);
+  } else if (output == _avOrientationPlug()) {
+    // A "vflip" filter graph is applied as a flip when reading tiles, on top of the orientation.
+    const bool flipOrientation =
+      orientationPlug()->getValue() == static_cast<int>(Orientation::FlipVertical);
+    const bool flip = isVflipFilterGraph(filterGraphPlug()->getValue()) != flipOrientation;
+    static_cast<IntPlug *>(output)->setValue(// NOLINT
+      static_cast<int>(flip ? AvReader::Orientation::FlipVertical : AvReader::Orientation::Native));
   } else if (output == fileValidPlug()) {
     const FrameMaskScope scope(context, this, /*clampBlack=*/true);
     static_cast<BoolPlug *>(output)->setValue(_avReader()->fileValidPlug()->getValue());// NOLINT
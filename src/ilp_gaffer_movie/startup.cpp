@@ -1,13 +1,22 @@
 #include "ilp_gaffer_movie/startup.hpp"
 
+#include <cstddef>// size_t
+#include <functional>// std::function
 #include <mutex>// std::call_once, etc.
 #include <string>// std::string
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+
 #include "IECore/MessageHandler.h"// IECore::MessageHandler
 
-#include "ilp_movie/log.hpp"// ilp_movie::SetLogLevel, ilp_movie::SetLogCallback
+#include "ilp_movie/log.hpp"// ilp_movie::SetLogLevel, ilp_movie::SetLogCallback, etc.
+#include "ilp_movie/parallel.hpp"// ilp_movie::SetParallelFor
 
 static std::once_flag initLogFlag;
+static std::once_flag initParallelForFlag;
 
 namespace IlpGafferMovie {
 
@@ -51,6 +60,29 @@ void Startup::initLog()
       // Forward the message to Gaffer's logger, with a translated logging level.
       IECore::msg(/*level=*/iecLevel, /*context=*/"ilp_movie", /*message=*/str);
     });
+
+    // IECore message handlers lock, so don't let decoding threads wait for each other.
+    ilp_movie::SetAsyncLogging(true);
+  });
+}
+
+void Startup::initParallelFor()
+{
+  std::call_once(initParallelForFlag, []() {
+    ilp_movie::SetParallelFor(
+      [](const int begin,
+        const int end,
+        const int grainSize,
+        const std::function<void(int, int)> &func) {
+        // Isolated, so that cancelling the tasks of the caller cannot leave a frame half done.
+        tbb::task_group_context taskGroupContext(tbb::task_group_context::isolated);
+        tbb::parallel_for(
+          tbb::blocked_range<int>(begin, end, static_cast<size_t>(grainSize)),
+          [&](const tbb::blocked_range<int> &r) { func(r.begin(), r.end()); },
+          tbb::simple_partitioner(),
+          taskGroupContext);
+      },
+      tbb::this_task_arena::max_concurrency());
   });
 }
 
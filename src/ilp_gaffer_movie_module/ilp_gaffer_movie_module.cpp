@@ -34,6 +34,8 @@ BOOST_PYTHON_MODULE(_IlpGafferMovie)// NOLINT
    class_<IlpGafferMovie::Startup>("Startup", init())
         .def("initLog", &IlpGafferMovie::Startup::initLog)
         .staticmethod("initLog")
+        .def("initParallelFor", &IlpGafferMovie::Startup::initParallelFor)
+        .staticmethod("initParallelFor")
 		;
 
     // clang-format on
@@ -43,14 +45,42 @@ BOOST_PYTHON_MODULE(_IlpGafferMovie)// NOLINT
     // clang-format off
 
 		scope s = GafferBindings::DependencyNodeClass<IlpGafferMovie::AvReader>()
-#if 0
-			.def( "setOpenFilesLimit", &OpenImageIOReader::setOpenFilesLimit )
-			.staticmethod( "setOpenFilesLimit" )
-			.def( "getOpenFilesLimit", &OpenImageIOReader::getOpenFilesLimit )
-			.staticmethod( "getOpenFilesLimit" )
-#endif
+			.def("setOpenFilesLimit", &IlpGafferMovie::AvReader::setOpenFilesLimit)
+			.staticmethod("setOpenFilesLimit")
+			.def("getOpenFilesLimit", &IlpGafferMovie::AvReader::getOpenFilesLimit)
+			.staticmethod("getOpenFilesLimit")
 			.def("supportedExtensions", &supportedExtensions<IlpGafferMovie::AvReader>)
 			.staticmethod("supportedExtensions")
+			.def("setFrameCacheMemoryLimit", &IlpGafferMovie::AvReader::setFrameCacheMemoryLimit)
+			.staticmethod("setFrameCacheMemoryLimit")
+			.def("getFrameCacheMemoryLimit", &IlpGafferMovie::AvReader::getFrameCacheMemoryLimit)
+			.staticmethod("getFrameCacheMemoryLimit")
+			.def("setFrameCacheHalfFloat", &IlpGafferMovie::AvReader::setFrameCacheHalfFloat)
+			.staticmethod("setFrameCacheHalfFloat")
+			.def("getFrameCacheHalfFloat", &IlpGafferMovie::AvReader::getFrameCacheHalfFloat)
+			.staticmethod("getFrameCacheHalfFloat")
+			.def("setFrameCacheNativeYuv", &IlpGafferMovie::AvReader::setFrameCacheNativeYuv)
+			.staticmethod("setFrameCacheNativeYuv")
+			.def("getFrameCacheNativeYuv", &IlpGafferMovie::AvReader::getFrameCacheNativeYuv)
+			.staticmethod("getFrameCacheNativeYuv")
+			.def("setFrameCacheDiskDirectory", &IlpGafferMovie::AvReader::setFrameCacheDiskDirectory)
+			.staticmethod("setFrameCacheDiskDirectory")
+			.def("getFrameCacheDiskDirectory", &IlpGafferMovie::AvReader::getFrameCacheDiskDirectory)
+			.staticmethod("getFrameCacheDiskDirectory")
+			.def("setFrameCacheDiskLimit", &IlpGafferMovie::AvReader::setFrameCacheDiskLimit)
+			.staticmethod("setFrameCacheDiskLimit")
+			.def("getFrameCacheDiskLimit", &IlpGafferMovie::AvReader::getFrameCacheDiskLimit)
+			.staticmethod("getFrameCacheDiskLimit")
+			.def("frameCacheStatistics", &IlpGafferMovie::AvReader::frameCacheStatistics)
+			.staticmethod("frameCacheStatistics")
+			.def("resetFrameCacheStatistics", &IlpGafferMovie::AvReader::resetFrameCacheStatistics)
+			.staticmethod("resetFrameCacheStatistics")
+			.def("setTraceEnabled", &IlpGafferMovie::AvReader::setTraceEnabled)
+			.staticmethod("setTraceEnabled")
+			.def("getTraceEnabled", &IlpGafferMovie::AvReader::getTraceEnabled)
+			.staticmethod("getTraceEnabled")
+			.def("writeTrace", &IlpGafferMovie::AvReader::writeTrace)
+			.staticmethod("writeTrace")
 		;
 
 		enum_<IlpGafferMovie::AvReader::MissingFrameMode>("MissingFrameMode")
@@ -59,6 +89,11 @@ BOOST_PYTHON_MODULE(_IlpGafferMovie)// NOLINT
 			.value("Hold", IlpGafferMovie::AvReader::MissingFrameMode::Hold)
 		;
 
+		enum_<IlpGafferMovie::AvReader::Orientation>("Orientation")
+			.value("Native", IlpGafferMovie::AvReader::Orientation::Native)
+			.value("FlipVertical", IlpGafferMovie::AvReader::Orientation::FlipVertical)
+		;
+
     // clang-format on
   }
 
@@ -83,6 +118,16 @@ BOOST_PYTHON_MODULE(_IlpGafferMovie)// NOLINT
       .value("ClampToFrame", IlpGafferMovie::MovieReader::FrameMaskMode::ClampToFrame)
     ;
 
+    enum_<IlpGafferMovie::MovieReader::Orientation>("Orientation")
+      .value("Native", IlpGafferMovie::MovieReader::Orientation::Native)
+      .value("FlipVertical", IlpGafferMovie::MovieReader::Orientation::FlipVertical)
+    ;
+
+    enum_<IlpGafferMovie::MovieReader::ColorConversion>("ColorConversion")
+      .value("PerTile", IlpGafferMovie::MovieReader::ColorConversion::PerTile)
+      .value("PerFrame", IlpGafferMovie::MovieReader::ColorConversion::PerFrame)
+    ;
+
     // clang-format on
   }
 
@@ -0,0 +1,534 @@
+#include "ilp_movie/convert.hpp"
+
+#include <algorithm>// std::clamp, std::copy, std::max
+#include <array>// std::array
+#include <atomic>// std::atomic
+#include <cstddef>// std::ptrdiff_t, std::size_t
+#include <optional>// std::optional
+#include <string_view>// std::string_view
+#include <utility>// std::pair
+#include <vector>// std::vector
+
+#include "internal/convert_kernels.hpp"
+#include "internal/parallel.hpp"
+
+// clang-format off
+extern "C" {
+#include <libavutil/avconfig.h>// AV_HAVE_BIGENDIAN
+#include <libavutil/common.h>// AV_CEIL_RSHIFT
+#include <libavutil/pixdesc.h>
+}
+// clang-format on
+
+namespace {
+
+struct YuvFormat
+{
+  // Bits per sample, samples are stored in 8-bit or 16-bit words.
+  int depth = 0;
+  int log2_chroma_w = 0;
+  int log2_chroma_h = 0;
+
+  // Deprecated "yuvj" formats are always full range.
+  bool full_range = false;
+};
+
+[[nodiscard]] auto GetYuvFormat(const AVPixelFormat pix_fmt) noexcept -> std::optional<YuvFormat>
+{
+  const AVPixFmtDescriptor *const desc = av_pix_fmt_desc_get(pix_fmt);
+  if (desc == nullptr || desc->nb_components != 3) { return std::nullopt; }
+
+  // Native endian, planar, integer samples, no palette. Native endian is little endian
+  // since the output is always "le".
+  uint64_t reject_mask = 0U;
+  reject_mask |= AV_PIX_FMT_FLAG_RGB;// NOLINT
+  reject_mask |= AV_PIX_FMT_FLAG_FLOAT;// NOLINT
+  reject_mask |= AV_PIX_FMT_FLAG_PAL;// NOLINT
+  reject_mask |= AV_PIX_FMT_FLAG_BE;// NOLINT
+  reject_mask |= AV_PIX_FMT_FLAG_BITSTREAM;// NOLINT
+  if ((desc->flags & reject_mask) != 0U || (desc->flags & AV_PIX_FMT_FLAG_PLANAR) == 0U) {// NOLINT
+    return std::nullopt;
+  }
+
+  const int depth = desc->comp[0].depth;// NOLINT
+  const int step = depth > 8 ? 2 : 1;// NOLINT
+  if (!(8 <= depth && depth <= 16)) { return std::nullopt; }// NOLINT
+  for (int c = 0; c < 3; ++c) {
+    const AVComponentDescriptor &comp = desc->comp[c];// NOLINT
+    if (comp.plane != c || comp.step != step || comp.offset != 0 || comp.shift != 0
+        || comp.depth != depth) {
+      return std::nullopt;
+    }
+  }
+
+  if (desc->log2_chroma_w > 1 || desc->log2_chroma_h > 1) {
+    return std::nullopt;
+  }
+
+  YuvFormat fmt{};
+  fmt.depth = depth;
+  fmt.log2_chroma_w = desc->log2_chroma_w;
+  fmt.log2_chroma_h = desc->log2_chroma_h;
+  fmt.full_range = pix_fmt == AV_PIX_FMT_YUVJ420P || pix_fmt == AV_PIX_FMT_YUVJ422P
+                   || pix_fmt == AV_PIX_FMT_YUVJ444P || pix_fmt == AV_PIX_FMT_YUVJ440P;
+  return fmt;
+}
+
+// Luma weights for supported color matrices. Unknown color space is treated as BT.601, which is
+// what libswscale does.
+[[nodiscard]] auto GetLumaWeights(const char *color_space_name) noexcept
+  -> std::optional<std::pair<double, double>>
+{
+  const std::string_view name = color_space_name != nullptr ? color_space_name : "unknown";
+  if (name == "bt709") { return std::make_pair(0.2126, 0.0722); }// NOLINT
+  if (name == "bt470bg" || name == "smpte170m" || name == "unknown") {
+    return std::make_pair(0.299, 0.114);// NOLINT
+  }
+  return std::nullopt;
+}
+
+[[nodiscard]] auto IsFullRange(const char *color_range_name, const YuvFormat &fmt) noexcept
+  -> bool
+{
+  return fmt.full_range
+         || (color_range_name != nullptr
+             && std::string_view{ color_range_name } == ilp_movie::ColorRange::kPc);
+}
+
+[[nodiscard]] auto ToIsa(const ilp_movie::ConvertIsa::ValueType isa) noexcept
+  -> convert_internal::Isa
+{
+  if (isa == ilp_movie::ConvertIsa::kAuto) { return convert_internal::DetectIsa(); }
+  return convert_internal::ClampIsa(static_cast<convert_internal::Isa>(
+    std::clamp(isa, ilp_movie::ConvertIsa::kScalar, ilp_movie::ConvertIsa::kAvx2)));
+}
+
+// Rows per parallel task. Aim for a few tasks per thread to balance load, but avoid tiny tasks.
+[[nodiscard]] auto RowGrainSize(const int height) noexcept -> int
+{
+  constexpr int kMinRows = 16;
+  constexpr int kTasksPerThread = 4;
+  return std::max(height / (parallel_internal::Concurrency() * kTasksPerThread), kMinRows);
+}
+
+// Converts segments of rows of a YUV frame to RGB floats. A segment is converted to the same
+// values as when converting the whole row, so that regions of a frame can be converted on
+// demand.
+class YuvToRgbRows
+{
+public:
+  // Returns null if the color matrix is not supported or the source planes are too small.
+  [[nodiscard]] static auto Make(const ilp_movie::FrameView &src,
+    const YuvFormat &fmt,
+    const convert_internal::Isa isa) noexcept -> std::optional<YuvToRgbRows>
+  {
+    const auto kr_kb = GetLumaWeights(src.hdr.color_space_name);
+    if (!kr_kb.has_value()) { return std::nullopt; }
+
+    const int w = src.hdr.width;
+    const int cw = AV_CEIL_RSHIFT(w, fmt.log2_chroma_w);// NOLINT
+    for (std::size_t p = 0U; p < 3U; ++p) {
+      const int min_src_linesize = (p == 0U ? w : cw) * (fmt.depth > 8 ? 2 : 1);// NOLINT
+      if (src.data.at(p) == nullptr || src.linesize.at(p) < min_src_linesize) {
+        return std::nullopt;
+      }
+    }
+
+    YuvToRgbRows rows{ src, fmt, isa };
+    rows._coeffs = convert_internal::MakeYuvToRgbCoeffs(kr_kb->first, kr_kb->second);
+
+    // Normalize Y' to [0, 1] and Cb/Cr to [-0.5, 0.5].
+    const float max_value = static_cast<float>((1 << fmt.depth) - 1);// NOLINT
+    const float mid_value = static_cast<float>(1 << (fmt.depth - 1));// NOLINT
+    const float bit_scale = static_cast<float>(1 << (fmt.depth - 8));// NOLINT
+    rows._y_scale = 1.F / max_value;
+    rows._y_offset = 0.F;
+    rows._c_scale = 1.F / max_value;
+    if (!IsFullRange(src.hdr.color_range_name, fmt)) {
+      rows._y_scale = 1.F / (219.F * bit_scale);// NOLINT
+      rows._y_offset = -16.F * bit_scale * rows._y_scale;// NOLINT
+      rows._c_scale = 1.F / (224.F * bit_scale);// NOLINT
+    }
+    rows._c_offset = -mid_value * rows._c_scale;
+    return rows;
+  }
+
+  // Number of floats of scratch memory needed to convert segments of up to n values.
+  [[nodiscard]] auto ScratchSize(const int n) const noexcept -> std::size_t
+  {
+    // Y, full width U/V, chroma U/V and neighbouring chroma U/V.
+    return static_cast<std::size_t>(n) + 2U * static_cast<std::size_t>(n + 3)
+           + 4U * static_cast<std::size_t>(_ChromaScratch(n));
+  }
+
+  // Convert n values of a source row, starting at column x. The segment must be within the frame.
+  void Convert(const int row,
+    const int x,
+    const int n,
+    float *r,
+    float *g,
+    float *b,
+    float *scratch) const noexcept
+  {
+    float *y_row = scratch;
+    float *u_row = y_row + n;// NOLINT
+    float *v_row = u_row + (n + 3);// NOLINT
+    float *uc_row = v_row + (n + 3);// NOLINT
+    float *vc_row = uc_row + _ChromaScratch(n);// NOLINT
+    float *uc2_row = vc_row + _ChromaScratch(n);// NOLINT
+    float *vc2_row = uc2_row + _ChromaScratch(n);// NOLINT
+
+    _LoadRow(0U, row, x, n, y_row);
+
+    // Upsampled chroma starts at an even column and extends one chroma sample past the
+    // segment, so that the interpolated values do not depend on where the segment ends,
+    // except at the right edge of the frame.
+    int up_x = x;
+    int up_n = n;
+    if (_fmt.log2_chroma_w == 1) {
+      up_x = x & ~1;// NOLINT
+      up_n = std::min(_src.hdr.width - up_x, x - up_x + n + 2);
+    }
+    const int cx = up_x >> _fmt.log2_chroma_w;// NOLINT
+    const int cn = AV_CEIL_RSHIFT(up_n, _fmt.log2_chroma_w);// NOLINT
+
+    if (_fmt.log2_chroma_h == 0) {
+      _LoadRow(1U, row, cx, cn, uc_row);
+      _LoadRow(2U, row, cx, cn, vc_row);
+    } else {
+      // Chroma rows are sited half-way between luma rows, interpolate between the nearest
+      // chroma row (3/4) and its neighbour (1/4).
+      const int ch = AV_CEIL_RSHIFT(_src.hdr.height, _fmt.log2_chroma_h);// NOLINT
+      const int k = row >> 1;// NOLINT
+      const int k2 = std::clamp((row & 1) == 0 ? k - 1 : k + 1, 0, ch - 1);// NOLINT
+      _LoadRow(1U, k, cx, cn, uc_row);
+      _LoadRow(2U, k, cx, cn, vc_row);
+      _LoadRow(1U, k2, cx, cn, uc2_row);
+      _LoadRow(2U, k2, cx, cn, vc2_row);
+      convert_internal::Blend(_isa, uc_row, uc2_row, uc_row, cn, 0.75F, 0.25F);// NOLINT
+      convert_internal::Blend(_isa, vc_row, vc2_row, vc_row, cn, 0.75F, 0.25F);// NOLINT
+    }
+
+    const float *u_full = uc_row;
+    const float *v_full = vc_row;
+    if (_fmt.log2_chroma_w == 1) {
+      convert_internal::UpsampleH2(uc_row, u_row, up_n);
+      convert_internal::UpsampleH2(vc_row, v_row, up_n);
+      u_full = u_row + (x - up_x);// NOLINT
+      v_full = v_row + (x - up_x);// NOLINT
+    }
+
+    convert_internal::YuvToRgb(_isa, y_row, u_full, v_full, r, g, b, n, _coeffs);
+  }
+
+private:
+  YuvToRgbRows(const ilp_movie::FrameView &src,
+    const YuvFormat &fmt,
+    const convert_internal::Isa isa) noexcept
+    : _src{ src }, _fmt{ fmt }, _isa{ isa }
+  {}
+
+  [[nodiscard]] auto _ChromaScratch(const int n) const noexcept -> int
+  {
+    return (n + 4) >> _fmt.log2_chroma_w;// NOLINT
+  }
+
+  void _LoadRow(const std::size_t p, const int row, const int x, const int n, float *out) const
+    noexcept
+  {
+    const bool is_luma = p == 0U;
+    const int step = _fmt.depth > 8 ? 2 : 1;// NOLINT
+    const uint8_t *line = _src.data.at(p) + static_cast<std::ptrdiff_t>(row) * _src.linesize.at(p)
+                          + static_cast<std::ptrdiff_t>(x) * step;
+    if (_fmt.depth > 8) {// NOLINT
+      convert_internal::LoadU16(_isa,
+        reinterpret_cast<const uint16_t *>(line),// NOLINT
+        out,
+        n,
+        is_luma ? _y_scale : _c_scale,
+        is_luma ? _y_offset : _c_offset);
+    } else {
+      convert_internal::LoadU8(
+        _isa, line, out, n, is_luma ? _y_scale : _c_scale, is_luma ? _y_offset : _c_offset);
+    }
+  }
+
+  ilp_movie::FrameView _src;
+  YuvFormat _fmt;
+  convert_internal::Isa _isa;
+  convert_internal::YuvToRgbCoeffs _coeffs = {};
+  float _y_scale = 0.F;
+  float _y_offset = 0.F;
+  float _c_scale = 0.F;
+  float _c_offset = 0.F;
+};
+
+[[nodiscard]] auto ConvertYuvToRgbF32(const ilp_movie::FrameView &src,
+  const ilp_movie::FrameView &dst,
+  const YuvFormat &fmt,
+  const ilp_movie::ConvertOptions &opts) noexcept -> bool
+{
+  const auto rows = YuvToRgbRows::Make(src, fmt, ToIsa(opts.isa));
+  if (!rows.has_value()) { return false; }
+
+  const int w = src.hdr.width;
+  const int h = src.hdr.height;
+  for (std::size_t p = 0U; p < 3U; ++p) {
+    if (dst.data.at(p) == nullptr || dst.linesize.at(p) < w * static_cast<int>(sizeof(float))) {
+      return false;
+    }
+  }
+
+  const auto dst_row = [&](const std::size_t p, const int row) {
+    return reinterpret_cast<float *>(// NOLINT
+      dst.data.at(p) + static_cast<std::ptrdiff_t>(row) * dst.linesize.at(p));
+  };
+
+  std::atomic<bool> ok = true;
+  parallel_internal::ParallelFor(0, h, RowGrainSize(h), [&](const int row_begin, const int row_end) {
+    std::vector<float> scratch;
+    try {
+      scratch.resize(rows->ScratchSize(w));
+    } catch (...) {
+      ok = false;
+      return;
+    }
+
+    for (int row = row_begin; row < row_end; ++row) {
+      // Planes are stored as G, B, R.
+      const int out_row = opts.vflip ? h - 1 - row : row;
+      rows->Convert(row,
+        /*x=*/0,
+        w,
+        /*r=*/dst_row(2U, out_row),
+        /*g=*/dst_row(0U, out_row),
+        /*b=*/dst_row(1U, out_row),
+        scratch.data());
+    }
+  });
+  return ok.load();
+}
+
+[[nodiscard]] auto IsRgbF32(const AVPixelFormat pix_fmt) noexcept -> bool
+{
+  return pix_fmt == AV_PIX_FMT_GBRPF32LE || pix_fmt == AV_PIX_FMT_GBRAPF32LE;
+}
+
+[[nodiscard]] auto ConvertRgbF32ToYuv(const ilp_movie::FrameView &src,
+  const ilp_movie::FrameView &dst,
+  const YuvFormat &fmt,
+  const ilp_movie::ConvertOptions &opts) noexcept -> bool
+{
+  const auto kr_kb = GetLumaWeights(dst.hdr.color_space_name);
+  if (!kr_kb.has_value()) { return false; }
+
+  const int w = src.hdr.width;
+  const int h = src.hdr.height;
+  const int cw = AV_CEIL_RSHIFT(w, fmt.log2_chroma_w);// NOLINT
+  const int ch = AV_CEIL_RSHIFT(h, fmt.log2_chroma_h);// NOLINT
+  for (std::size_t p = 0U; p < 3U; ++p) {
+    if (src.data.at(p) == nullptr
+        || src.linesize.at(p) < w * static_cast<int>(sizeof(float))) {
+      return false;
+    }
+    const int min_dst_linesize = (p == 0U ? w : cw) * (fmt.depth > 8 ? 2 : 1);// NOLINT
+    if (dst.data.at(p) == nullptr || dst.linesize.at(p) < min_dst_linesize) { return false; }
+  }
+
+  // Scale Y' from [0, 1] and Cb/Cr from [-0.5, 0.5] to code values.
+  const int max_value = (1 << fmt.depth) - 1;// NOLINT
+  const float mid_value = static_cast<float>(1 << (fmt.depth - 1));// NOLINT
+  const float bit_scale = static_cast<float>(1 << (fmt.depth - 8));// NOLINT
+  float y_scale = static_cast<float>(max_value);
+  float y_offset = 0.F;
+  float c_scale = static_cast<float>(max_value);
+  if (!IsFullRange(dst.hdr.color_range_name, fmt)) {
+    y_scale = 219.F * bit_scale;// NOLINT
+    y_offset = 16.F * bit_scale;// NOLINT
+    c_scale = 224.F * bit_scale;// NOLINT
+  }
+  const float c_offset = mid_value;
+
+  const auto isa = ToIsa(opts.isa);
+  const auto coeffs = convert_internal::MakeRgbToYuvCoeffs(kr_kb->first, kr_kb->second);
+
+  const auto src_row = [&](const std::size_t p, const int row) {
+    const int in_row = opts.vflip ? h - 1 - row : row;
+    return reinterpret_cast<const float *>(// NOLINT
+      src.data.at(p) + static_cast<std::ptrdiff_t>(in_row) * src.linesize.at(p));
+  };
+
+  const auto store_row = [&](const std::size_t p, const int row, const int n, const float *in) {
+    const bool is_luma = p == 0U;
+    uint8_t *line = dst.data.at(p) + static_cast<std::ptrdiff_t>(row) * dst.linesize.at(p);
+    if (fmt.depth > 8) {// NOLINT
+      convert_internal::StoreU16(isa,
+        in,
+        reinterpret_cast<uint16_t *>(line),// NOLINT
+        n,
+        is_luma ? y_scale : c_scale,
+        is_luma ? y_offset : c_offset,
+        max_value);
+    } else {
+      convert_internal::StoreU8(
+        isa, in, line, n, is_luma ? y_scale : c_scale, is_luma ? y_offset : c_offset);
+    }
+  };
+
+  // Iterate over chroma rows, each of which covers one or two luma rows.
+  std::atomic<bool> ok = true;
+  parallel_internal::ParallelFor(0, ch, RowGrainSize(ch), [&](const int k_begin, const int k_end) {
+    // Scratch rows: Y, full width U/V, chroma U/V and neighbouring chroma U/V.
+    std::vector<float> scratch;
+    try {
+      scratch.resize(3 * static_cast<std::size_t>(w) + 4 * static_cast<std::size_t>(cw));
+    } catch (...) {
+      ok = false;
+      return;
+    }
+    float *y_row = scratch.data();
+    float *u_row = y_row + w;// NOLINT
+    float *v_row = u_row + w;// NOLINT
+    std::array<float *, 2> uc_rows = { v_row + w, v_row + w + cw };// NOLINT
+    std::array<float *, 2> vc_rows = { uc_rows[1] + cw, uc_rows[1] + 2 * cw };// NOLINT
+
+    for (int k = k_begin; k < k_end; ++k) {
+      int rows = 0;
+      for (int j = 0; j < (1 << fmt.log2_chroma_h); ++j) {// NOLINT
+        const int row = (k << fmt.log2_chroma_h) + j;// NOLINT
+        if (row >= h) { break; }
+
+        // Planes are stored as G, B, R.
+        convert_internal::RgbToYuv(isa,
+          /*r=*/src_row(2U, row),
+          /*g=*/src_row(0U, row),
+          /*b=*/src_row(1U, row),
+          y_row,
+          u_row,
+          v_row,
+          w,
+          coeffs);
+        store_row(0U, row, w, y_row);
+
+        const auto jj = static_cast<std::size_t>(j);
+        if (fmt.log2_chroma_w == 1) {
+          convert_internal::DownsampleH2(u_row, uc_rows.at(jj), w);
+          convert_internal::DownsampleH2(v_row, vc_rows.at(jj), w);
+        } else {
+          std::copy(u_row, u_row + w, uc_rows.at(jj));// NOLINT
+          std::copy(v_row, v_row + w, vc_rows.at(jj));// NOLINT
+        }
+        ++rows;
+      }
+
+      // Chroma rows are sited half-way between luma rows, average the two luma rows. At the bottom
+      // edge of frames with odd height there is only one luma row.
+      if (rows == 2) {// NOLINT
+        convert_internal::Blend(isa, uc_rows[0], uc_rows[1], uc_rows[0], cw, 0.5F, 0.5F);// NOLINT
+        convert_internal::Blend(isa, vc_rows[0], vc_rows[1], vc_rows[0], cw, 0.5F, 0.5F);// NOLINT
+      }
+      store_row(1U, k, cw, uc_rows[0]);
+      store_row(2U, k, cw, vc_rows[0]);
+    }
+  });
+  return ok.load();
+}
+
+}// namespace
+
+namespace ilp_movie {
+
+auto BestConvertIsa() noexcept -> ConvertIsa::ValueType
+{
+  return static_cast<ConvertIsa::ValueType>(convert_internal::DetectIsa());
+}
+
+auto CanConvertFrame(const char *src_pix_fmt_name, const char *dst_pix_fmt_name) noexcept -> bool
+{
+  if (AV_HAVE_BIGENDIAN) { return false; }// NOLINT
+  if (src_pix_fmt_name == nullptr || dst_pix_fmt_name == nullptr) { return false; }
+
+  const AVPixelFormat src_pix_fmt = av_get_pix_fmt(src_pix_fmt_name);
+  const AVPixelFormat dst_pix_fmt = av_get_pix_fmt(dst_pix_fmt_name);
+  if (dst_pix_fmt == AV_PIX_FMT_GBRPF32LE) { return GetYuvFormat(src_pix_fmt).has_value(); }
+  if (IsRgbF32(src_pix_fmt)) { return GetYuvFormat(dst_pix_fmt).has_value(); }
+  return false;
+}
+
+auto ConvertFrame(const FrameView &src, const FrameView &dst, const ConvertOptions &opts) noexcept
+  -> bool
+{
+  if (!CanConvertFrame(src.hdr.pix_fmt_name, dst.hdr.pix_fmt_name)) { return false; }
+  if (!(src.hdr.width > 0 && src.hdr.height > 0)) { return false; }
+  if (!(src.hdr.width == dst.hdr.width && src.hdr.height == dst.hdr.height)) { return false; }
+
+  if (IsRgbF32(av_get_pix_fmt(src.hdr.pix_fmt_name))) {
+    const auto yuv_fmt = GetYuvFormat(av_get_pix_fmt(dst.hdr.pix_fmt_name));
+    return yuv_fmt.has_value() && ConvertRgbF32ToYuv(src, dst, *yuv_fmt, opts);
+  }
+  const auto yuv_fmt = GetYuvFormat(av_get_pix_fmt(src.hdr.pix_fmt_name));
+  return yuv_fmt.has_value() && ConvertYuvToRgbF32(src, dst, *yuv_fmt, opts);
+}
+
+auto ConvertFrameRegion(const FrameView &src,
+  const Comp::ValueType c,
+  const int x,
+  const int y,
+  const int w,
+  const int h,
+  float *dst,
+  const std::ptrdiff_t dst_stride,
+  const ConvertOptions &opts) noexcept -> bool
+{
+  if (!(c == Comp::kR || c == Comp::kG || c == Comp::kB)) { return false; }
+  if (!(x >= 0 && y >= 0 && w > 0 && h > 0)) { return false; }
+  if (!(x + w <= src.hdr.width && y + h <= src.hdr.height)) { return false; }
+  if (dst == nullptr || dst_stride < w) { return false; }
+
+  const auto yuv_fmt = GetYuvFormat(av_get_pix_fmt(src.hdr.pix_fmt_name));
+  if (!yuv_fmt.has_value()) { return false; }
+  const auto rows = YuvToRgbRows::Make(src, *yuv_fmt, ToIsa(opts.isa));
+  if (!rows.has_value()) { return false; }
+
+  // The components that were not requested are written to scratch rows.
+  std::vector<float> scratch;
+  try {
+    scratch.resize(rows->ScratchSize(w) + 2U * static_cast<std::size_t>(w));
+  } catch (...) {
+    return false;
+  }
+  float *other0 = scratch.data();
+  float *other1 = other0 + w;// NOLINT
+  float *row_scratch = other1 + w;// NOLINT
+
+  for (int j = 0; j < h; ++j) {
+    float *out = dst + j * dst_stride;// NOLINT
+    const int src_row = opts.vflip ? src.hdr.height - 1 - (y + j) : y + j;
+    rows->Convert(src_row,
+      x,
+      w,
+      /*r=*/c == Comp::kR ? out : other0,
+      /*g=*/c == Comp::kG ? out : (c == Comp::kR ? other0 : other1),
+      /*b=*/c == Comp::kB ? out : other1,
+      row_scratch);
+  }
+  return true;
+}
+
+void FloatToHalf(const float *in,
+  uint16_t *out,
+  const int n,
+  const ConvertIsa::ValueType isa) noexcept
+{
+  convert_internal::FloatToHalf(ToIsa(isa), in, out, n);
+}
+
+void HalfToFloat(const uint16_t *in,
+  float *out,
+  const int n,
+  const ConvertIsa::ValueType isa) noexcept
+{
+  convert_internal::HalfToFloat(ToIsa(isa), in, out, n);
+}
+
+}// namespace ilp_movie
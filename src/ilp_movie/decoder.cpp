@@ -1,13 +1,27 @@
 #include "ilp_movie/decoder.hpp"
 
+#include <algorithm>// std::min, std::max
+#include <array>// std::array
+#include <atomic>// std::atomic
 #include <cassert>// assert
+#include <chrono>// std::chrono::steady_clock
+#include <condition_variable>// std::condition_variable
+#include <cstddef>// std::ptrdiff_t
 #include <cstring>// std::memcpy
+#include <deque>// std::deque
+#include <future>// std::promise, std::shared_future
 #include <map>// std::map
+#include <mutex>// std::mutex, std::lock_guard, std::unique_lock
 #include <sstream>// std::istringstream, std::ostringstream
+#include <utility>// std::move
 
+#include "ilp_movie/convert.hpp"
 #include "ilp_movie/frame.hpp"
+#include "ilp_movie/trace.hpp"
+#include "internal/av_frame_utils.hpp"
 #include "internal/filter_graph.hpp"
 #include "internal/log_utils.hpp"
+#include "internal/parallel.hpp"
 
 // clang-format off
 extern "C" {
@@ -26,6 +40,52 @@ extern "C" {
 
 namespace {
 
+// Replaces AVCodecContext::execute, running the jobs of a decoder with slice threading enabled
+// through parallel_internal::ParallelFor, so that slices are decoded by the same threads as the
+// rest of the parallel work.
+int ExecuteJobs(AVCodecContext *c,
+  int (*func)(AVCodecContext *c2, void *arg),
+  void *arg,
+  int *ret,
+  const int count,
+  const int size)
+{
+  parallel_internal::ParallelFor(0, count, /*grain_size=*/1, [&](const int begin, const int end) {
+    for (int i = begin; i < end; ++i) {
+      void *job_arg = static_cast<char *>(arg) + static_cast<std::ptrdiff_t>(i) * size;// NOLINT
+      const int r = func(c, job_arg);
+      if (ret != nullptr) { ret[i] = r; }// NOLINT
+    }
+  });
+  return 0;
+}
+
+// Replaces AVCodecContext::execute2, see ExecuteJobs. Some codecs keep scratch buffers for each
+// of their threads, indexed by the thread number passed to func. Jobs are therefore grouped into
+// at most thread_count chunks, and the chunk index is passed as the thread number. A chunk runs
+// on a single thread, so no two jobs running concurrently share a thread number.
+int ExecuteJobs2(AVCodecContext *c,
+  int (*func)(AVCodecContext *c2, void *arg, int jobnr, int threadnr),
+  void *arg,
+  int *ret,
+  const int count)
+{
+  const int chunk_count = std::min(count, std::max(c->thread_count, 1));
+  if (chunk_count <= 0) { return 0; }
+  const int chunk_size = (count + chunk_count - 1) / chunk_count;
+  parallel_internal::ParallelFor(
+    0, chunk_count, /*grain_size=*/1, [&](const int chunk_begin, const int chunk_end) {
+      for (int chunk = chunk_begin; chunk < chunk_end; ++chunk) {
+        const int job_end = std::min((chunk + 1) * chunk_size, count);
+        for (int job = chunk * chunk_size; job < job_end; ++job) {
+          const int r = func(c, arg, job, /*threadnr=*/chunk);
+          if (ret != nullptr) { ret[job] = r; }// NOLINT
+        }
+      }
+    });
+  return 0;
+}
+
 class Stream
 {
 public:
@@ -95,17 +155,11 @@ public:
       return exit_func(/*success=*/false);
     }
 
-    if (thread_count > 0) {
-#if 1// NOTE(tohi): experimental, not tested.
-      if (codec->capabilities & AV_CODEC_CAP_SLICE_THREADS) {// NOLINT
-        _av_codec_ctx->thread_count = thread_count;
-        _av_codec_ctx->thread_type = FF_THREAD_SLICE;// NOLINT
-      }
-      if (codec->capabilities & AV_CODEC_CAP_FRAME_THREADS) {// NOLINT
-        _av_codec_ctx->thread_count = thread_count;
-        _av_codec_ctx->thread_type |= FF_THREAD_FRAME;// NOLINT
-      }
-#endif
+    // Only slice threading is used. Frame threading delays the output of each frame by as many
+    // frames as there are threads, which makes seeking to a frame more expensive.
+    if (thread_count > 1 && (codec->capabilities & AV_CODEC_CAP_SLICE_THREADS) != 0) {// NOLINT
+      _av_codec_ctx->thread_count = thread_count;
+      _av_codec_ctx->thread_type = FF_THREAD_SLICE;// NOLINT
     }
 
     // Copy parameters to the codec context.
@@ -121,6 +175,13 @@ public:
       return exit_func(/*success=*/false);
     }
 
+    // The decoder allocates per-thread state for thread_count threads, but the slices are
+    // decoded by our own threads instead of the thread pool created by the decoder.
+    if ((_av_codec_ctx->active_thread_type & FF_THREAD_SLICE) != 0) {// NOLINT
+      _av_codec_ctx->execute = ExecuteJobs;
+      _av_codec_ctx->execute2 = ExecuteJobs2;
+    }
+
     _av_frame = av_frame_alloc();
     if (_av_frame == nullptr) {
       log_utils_internal::LogAvError("Cannot allocate frame for stream", AVERROR(ENOMEM));
@@ -293,6 +354,299 @@ private:
   AVRational _frame_rate = { /*.num=*/0, /*.den=*/1 };
 };
 
+// Decoders without an output pixel format return raw frames, without filtering.
+[[nodiscard]] auto IsRaw(const ilp_movie::DecoderFilterGraphDescription &dfgd) noexcept -> bool
+{
+  return dfgd.out_pix_fmt_name.empty();
+}
+
+using Clock = std::chrono::steady_clock;
+
+[[nodiscard]] auto NsSince(const Clock::time_point t0) noexcept -> int64_t
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+}
+
+// Decoder statistics that can be read while frames are being decoded. Each decode accumulates its
+// statistics locally and adds them once, so the overhead is a handful of atomic additions per
+// frame.
+class AtomicDecoderStats
+{
+public:
+  void Add(const ilp_movie::DecoderStats &stats) noexcept
+  {
+    for (std::size_t i = 0U; i < kFields.size(); ++i) {
+      _values.at(i).fetch_add(stats.*kFields.at(i), std::memory_order_relaxed);
+    }
+  }
+
+  [[nodiscard]] auto Load() const noexcept -> ilp_movie::DecoderStats
+  {
+    ilp_movie::DecoderStats stats{};
+    for (std::size_t i = 0U; i < kFields.size(); ++i) {
+      stats.*kFields.at(i) = _values.at(i).load(std::memory_order_relaxed);
+    }
+    return stats;
+  }
+
+  void Reset() noexcept
+  {
+    for (auto &&v : _values) { v.store(0, std::memory_order_relaxed); }
+  }
+
+private:
+  using Field = int64_t ilp_movie::DecoderStats::*;
+  static constexpr std::array<Field, 15> kFields = {
+    &ilp_movie::DecoderStats::decode_calls,
+    &ilp_movie::DecoderStats::failed_decodes,
+    &ilp_movie::DecoderStats::cancelled_decodes,
+    &ilp_movie::DecoderStats::wakeups,
+    &ilp_movie::DecoderStats::seeks,
+    &ilp_movie::DecoderStats::packets_read,
+    &ilp_movie::DecoderStats::packets_skipped,
+    &ilp_movie::DecoderStats::frames_decoded,
+    &ilp_movie::DecoderStats::frames_discarded,
+    &ilp_movie::DecoderStats::wake_ns,
+    &ilp_movie::DecoderStats::seek_ns,
+    &ilp_movie::DecoderStats::demux_ns,
+    &ilp_movie::DecoderStats::decode_ns,
+    &ilp_movie::DecoderStats::filter_ns,
+    &ilp_movie::DecoderStats::copy_ns,
+  };
+
+  std::array<std::atomic<int64_t>, kFields.size()> _values = {};
+};
+
+// Asynchronous decode requests for a single decoder. Requests are decoded one at a time, in the
+// order they were made, by jobs handed to an executor. Only one job is handed to the executor at a
+// time, which keeps the requests ordered without blocking executor threads on the decoder.
+class AsyncDecodeQueue
+{
+public:
+  using DecodeFunc = std::function<bool(int stream_index,
+    int frame_nb,
+    ilp_movie::Frame &frame,
+    const ilp_movie::DecodeCancelledFunc &cancelled)>;
+
+  explicit AsyncDecodeQueue(DecodeFunc decode) : _state{ std::make_shared<State>() }
+  {
+    _state->decode = std::move(decode);
+  }
+
+  // Jobs that have not yet been run by the executor may outlive the queue, but won't decode.
+  ~AsyncDecodeQueue() { _Cancel(/*close=*/true); }
+
+  // Not copyable or movable.
+  AsyncDecodeQueue(const AsyncDecodeQueue &rhs) = delete;
+  AsyncDecodeQueue &operator=(const AsyncDecodeQueue &rhs) = delete;
+  AsyncDecodeQueue(AsyncDecodeQueue &&rhs) = delete;
+  AsyncDecodeQueue &operator=(AsyncDecodeQueue &&rhs) = delete;
+
+  [[nodiscard]] auto Submit(const int stream_index,
+    const int frame_nb,
+    ilp_movie::DecodeCallback on_decoded) noexcept -> std::shared_future<ilp_movie::DecodedFrame>
+  {
+    std::shared_ptr<Request> req;
+    bool post = false;
+    try {
+      std::lock_guard<std::mutex> lock{ _state->mutex };
+      req = _state->FindRequest(stream_index, frame_nb);
+      if (req == nullptr) {
+        req = std::make_shared<Request>();
+        req->stream_index = stream_index;
+        req->frame_nb = frame_nb;
+        req->future = req->promise.get_future().share();
+        _state->queue.push_back(req);
+        post = !_state->running;
+        _state->running = true;
+      }
+      if (on_decoded) { req->callbacks.push_back(std::move(on_decoded)); }
+    } catch (...) {
+      ilp_movie::LogMsg(ilp_movie::LogLevel::kError, "Cannot queue asynchronous decode\n");
+      return _FailedFuture();
+    }
+    if (post) { _Post(_state); }
+    return req->future;
+  }
+
+  // Completes queued requests with a null result, cancels the request being decoded and waits for
+  // it to complete.
+  void CancelAll() noexcept { _Cancel(/*close=*/false); }
+
+  [[nodiscard]] auto PendingCount() const noexcept -> int
+  {
+    std::lock_guard<std::mutex> lock{ _state->mutex };
+    return static_cast<int>(_state->queue.size()) + (_state->current != nullptr ? 1 : 0);
+  }
+
+  void SetExecutor(ilp_movie::DecodeExecutor executor) noexcept
+  {
+    std::lock_guard<std::mutex> lock{ _state->mutex };
+    _state->executor = std::move(executor);
+  }
+
+private:
+  struct Request
+  {
+    int stream_index = -1;
+    int frame_nb = -1;
+    std::promise<ilp_movie::DecodedFrame> promise;
+    std::shared_future<ilp_movie::DecodedFrame> future;
+    std::vector<ilp_movie::DecodeCallback> callbacks;
+  };
+
+  // Shared with the jobs handed to the executor.
+  struct State
+  {
+    [[nodiscard]] auto FindRequest(const int stream_index, const int frame_nb) const noexcept
+      -> std::shared_ptr<Request>
+    {
+      const auto matches = [&](const std::shared_ptr<Request> &req) {
+        return req != nullptr && req->stream_index == stream_index && req->frame_nb == frame_nb;
+      };
+      if (matches(current)) { return current; }
+      for (auto &&req : queue) {
+        if (matches(req)) { return req; }
+      }
+      return nullptr;
+    }
+
+    DecodeFunc decode;
+    ilp_movie::DecodeExecutor executor;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::shared_ptr<Request>> queue;
+
+    // The request being decoded, if any.
+    std::shared_ptr<Request> current;
+
+    // True while a job has been handed to the executor and has not yet found the queue empty.
+    bool running = false;
+
+    // Set when the queue is destroyed, after which requests are no longer decoded.
+    bool closed = false;
+
+    std::atomic<bool> cancel{ false };
+  };
+
+  void _Cancel(const bool close) noexcept
+  {
+    std::deque<std::shared_ptr<Request>> cancelled;
+    {
+      std::lock_guard<std::mutex> lock{ _state->mutex };
+      _state->cancel.store(true, std::memory_order_relaxed);
+      _state->closed = _state->closed || close;
+      cancelled.swap(_state->queue);
+    }
+    for (auto &&req : cancelled) { _Complete(*req, /*frame=*/nullptr); }
+
+    // Only wait for the request being decoded, a job that has not been run yet cannot start
+    // decoding the cancelled requests.
+    std::unique_lock<std::mutex> lock{ _state->mutex };
+    _state->cv.wait(lock, [this]() { return _state->current == nullptr; });
+    _state->cancel.store(false, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] static auto _FailedFuture() noexcept -> std::shared_future<ilp_movie::DecodedFrame>
+  {
+    try {
+      std::promise<ilp_movie::DecodedFrame> promise;
+      promise.set_value(nullptr);
+      return promise.get_future().share();
+    } catch (...) {
+      return {};
+    }
+  }
+
+  static void _Complete(Request &req, const ilp_movie::DecodedFrame &frame) noexcept
+  {
+    try {
+      req.promise.set_value(frame);
+    } catch (...) {// NOLINT
+      // Already satisfied.
+    }
+    for (auto &&cb : req.callbacks) {
+      try {
+        cb(frame);
+      } catch (...) {
+        ilp_movie::LogMsg(
+          ilp_movie::LogLevel::kError, "Asynchronous decode callback threw an exception\n");
+      }
+    }
+  }
+
+  // Hands a job that decodes the next request to the executor. Runs the job on the calling
+  // thread if there is no executor to hand it to.
+  static void _Post(const std::shared_ptr<State> &state) noexcept
+  {
+    ilp_movie::DecodeExecutor executor;
+    {
+      std::lock_guard<std::mutex> lock{ state->mutex };
+      executor = state->executor;
+    }
+    try {
+      const auto job = [state]() { _RunNext(state); };
+      if (executor) {
+        executor(job);
+        return;
+      }
+      if (parallel_internal::Submit(job)) { return; }
+    } catch (...) {
+      ilp_movie::LogMsg(
+        ilp_movie::LogLevel::kWarning, "Cannot hand decode to executor, decoding inline\n");
+    }
+    _RunNext(state);
+  }
+
+  static void _RunNext(const std::shared_ptr<State> &state) noexcept
+  {
+    std::shared_ptr<Request> req;
+    {
+      std::lock_guard<std::mutex> lock{ state->mutex };
+      if (state->queue.empty() || state->closed) {
+        state->running = false;
+        return;
+      }
+      req = state->queue.front();
+      state->queue.pop_front();
+      state->current = req;
+    }
+
+    ilp_movie::DecodedFrame result;
+    if (!state->cancel.load(std::memory_order_relaxed)) {
+      try {
+        auto frame = std::make_shared<ilp_movie::Frame>();
+        if (state->decode(req->stream_index, req->frame_nb, *frame, [&state]() {
+              return state->cancel.load(std::memory_order_relaxed);
+            })) {
+          result = std::move(frame);
+        }
+      } catch (...) {
+        ilp_movie::LogMsg(
+          ilp_movie::LogLevel::kError, "Cannot allocate frame for asynchronous decode\n");
+      }
+    }
+
+    // Complete the request before the next request is started, so that callbacks are invoked in
+    // the order of the requests.
+    _Complete(*req, result);
+
+    {
+      std::lock_guard<std::mutex> lock{ state->mutex };
+      state->current.reset();
+      state->cv.notify_all();
+      if (state->queue.empty() || state->closed) {
+        state->running = false;
+        return;
+      }
+    }
+    _Post(state);
+  }
+
+  std::shared_ptr<State> _state;
+};
+
 }// namespace
 
 namespace ilp_movie {
@@ -349,11 +703,25 @@ public:
   }
 
 
-  DecoderImpl() = default;
-  ~DecoderImpl() { Close(); }
+  DecoderImpl()
+    : _async{ [this](const int stream_index,
+                const int frame_nb,
+                Frame &frame,
+                const DecodeCancelledFunc &cancelled) {
+        return DecodeVideoFrame(stream_index, frame_nb, frame, cancelled);
+      } }
+  {}
+
+  ~DecoderImpl()
+  {
+    _async.CancelAll();
+    _Close();
+  }
 
-  DecoderImpl(DecoderImpl &&rhs) noexcept = default;
-  DecoderImpl &operator=(DecoderImpl &&rhs) noexcept = default;
+  // Not movable, since the mutex isn't. The decoder is moved by moving its pointer to the
+  // implementation.
+  DecoderImpl(DecoderImpl &&rhs) noexcept = delete;
+  DecoderImpl &operator=(DecoderImpl &&rhs) noexcept = delete;
 
   // Not copyable.
   DecoderImpl(const DecoderImpl &rhs) = delete;
@@ -361,13 +729,284 @@ public:
 
   [[nodiscard]] auto Open(const std::string &url,
     const DecoderFilterGraphDescription &dfgd) noexcept -> bool
+  {
+    _async.CancelAll();
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _Close();
+    _url = url;
+    _dfgd = dfgd;
+    if (!_OpenContexts(/*wake=*/false)) {
+      _Close();
+      return false;
+    }
+    return true;
+  }
+
+  [[nodiscard]] auto IsOpen() const noexcept -> bool { return !_url.empty(); }
+
+  [[nodiscard]] auto Url() const noexcept -> const std::string & { return _url; }
+  [[nodiscard]] auto Probe() const noexcept -> const std::string & { return _probe; }
+
+  void Close() noexcept
+  {
+    _async.CancelAll();
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _Close();
+  }
+
+  void Hibernate() noexcept
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    if (!IsOpen() || _hibernating) { return; }
+    _CloseContexts();
+    _hibernating = true;
+  }
+
+  [[nodiscard]] auto TryHibernate() noexcept -> bool
+  {
+    std::unique_lock<std::mutex> lock{ _mutex, std::try_to_lock };
+    if (!lock.owns_lock()) { return false; }
+    if (IsOpen() && !_hibernating) {
+      _CloseContexts();
+      _hibernating = true;
+    }
+    return true;
+  }
+
+  [[nodiscard]] auto IsHibernating() const noexcept -> bool
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    return _hibernating;
+  }
+
+  [[nodiscard]] auto BestVideoStreamIndex() const noexcept -> std::optional<int> { 
+    if (!(_best_video_stream >= 0)) { return std::nullopt; }
+    return _best_video_stream; 
+  }
+
+  [[nodiscard]] auto VideoStreamHeaders() const noexcept
+    -> const std::vector<InputVideoStreamHeader> &
+  {
+    return _video_stream_headers;
+  }
+
+  [[nodiscard]] auto VideoStreamHeader(const int stream_index) const noexcept
+    -> std::optional<InputVideoStreamHeader>
+  {
+    return _FindHeader(_video_stream_headers, stream_index);
+  }
+
+  [[nodiscard]] auto FilteredVideoStreamHeader(const int stream_index) const noexcept
+    -> std::optional<InputVideoStreamHeader>
+  {
+    return _FindHeader(_filtered_video_stream_headers, stream_index);
+  }
+
+  [[nodiscard]] auto DecodeVideoFrame(int stream_index,
+    int frame_nb,
+    Frame &frame,
+    const DecodeCancelledFunc &cancelled) noexcept -> bool
+  {
+    ILP_MOVIE_TRACE_SPAN_ARG("decoder", "decode video frame", "frame", frame_nb);
+    DecoderStats stats{};
+    stats.decode_calls = 1;
+    const bool ok = _DecodeVideoFrame(stream_index, frame_nb, frame, cancelled, stats);
+    if (!ok && stats.cancelled_decodes == 0) { stats.failed_decodes = 1; }
+    _stats.Add(stats);
+    return ok;
+  }
+
+  [[nodiscard]] auto Stats() const noexcept -> DecoderStats { return _stats.Load(); }
+
+  void ResetStats() noexcept { _stats.Reset(); }
+
+  [[nodiscard]] auto DecodeVideoFrameAsync(const int stream_index,
+    const int frame_nb,
+    DecodeCallback on_decoded) noexcept -> std::shared_future<DecodedFrame>
+  {
+    return _async.Submit(stream_index, frame_nb, std::move(on_decoded));
+  }
+
+  [[nodiscard]] auto PendingDecodeCount() const noexcept -> int { return _async.PendingCount(); }
+
+  void SetExecutor(DecodeExecutor executor) noexcept { _async.SetExecutor(std::move(executor)); }
+
+private:
+  // Decode a frame, accumulating counters and timings for the call in stats.
+  [[nodiscard]] auto _DecodeVideoFrame(int stream_index,
+    int frame_nb,
+    Frame &frame,
+    const DecodeCancelledFunc &cancelled,
+    DecoderStats &stats) noexcept -> bool
+  {
+    const auto is_cancelled = [&cancelled, &stats]() {
+      if (cancelled && cancelled()) {
+        LogMsg(LogLevel::kDebug, "Decoding video frame cancelled\n");
+        stats.cancelled_decodes = 1;
+        return true;
+      }
+      return false;
+    };
+
+    std::lock_guard<std::mutex> lock{ _mutex };
+    if (_hibernating) {
+      ILP_MOVIE_TRACE_SPAN("decoder", "wake");
+      const auto t_wake = Clock::now();
+      stats.wakeups = 1;
+      const bool woke = _OpenContexts(/*wake=*/true);
+      stats.wake_ns = NsSince(t_wake);
+      if (!woke) {
+        LogMsg(LogLevel::kError, "Cannot wake up hibernating decoder\n");
+        return false;
+      }
+    }
+    const int index = stream_index == -1 ? _best_video_stream : stream_index;
+
+    Stream *stream = nullptr;
+    filter_graph_internal::FilterGraph *filter_graph = nullptr;
+    const FilteredStream *fs = nullptr;
+    if (const auto fs_iter = _video_streams.find(index); fs_iter != _video_streams.end()) {
+      fs = &fs_iter->second;
+      stream = fs->stream.get();
+      filter_graph = fs->filter_graph.get();
+    } else {
+      LogMsg(LogLevel::kWarning, "Bad stream index for decoding video frame\n");
+      return false;
+    }
+    assert(stream != nullptr);// NOLINT
+    assert(filter_graph != nullptr || IsRaw(_dfgd));// NOLINT
+
+    // Check if frame exists in stream.
+    if (!(1 <= frame_nb && frame_nb <= stream->FrameCount())) { return false; }
+
+    const int64_t timestamp = stream->FrameToPts(frame_nb - 1);
+
+    {
+      ILP_MOVIE_TRACE_SPAN("decoder", "seek");
+      const auto t_seek = Clock::now();
+      constexpr int kSeekFlags = AVSEEK_FLAG_BACKWARD;
+      if (const int ret = av_seek_frame(_av_fmt_ctx, stream->Get()->index, timestamp, kSeekFlags);
+          ret < 0) {
+        log_utils_internal::LogAvError("Cannot seek to timestamp", ret);
+        return false;
+      }
+
+      stream->FlushCodec();
+      stats.seeks = 1;
+      stats.seek_ns = NsSince(t_seek);
+    }
+
+    bool got_frame = false;
+    bool keep_going = true;
+    int ret = 0;
+    while (ret >= 0 && keep_going) {
+      // The previous packet has been unreferenced at this point, and the next decode seeks and
+      // flushes the codec, so it is safe to stop here.
+      if (is_cancelled()) { return false; }
+
+      // Read a packet, which for video streams corresponds to one frame.
+      {
+        ILP_MOVIE_TRACE_SPAN("decoder", "read packet");
+        const auto t_demux = Clock::now();
+        ret = av_read_frame(_av_fmt_ctx, _av_packet);
+        stats.demux_ns += NsSince(t_demux);
+      }
+
+      // A packet was successfully read, check if was from the stream we are interested in.
+      if (ret >= 0 && _av_packet->stream_index != stream->Get()->index) {
+        // Ignore packets that are not from the video stream we are trying to read from.
+        av_packet_unref(_av_packet);
+        ++stats.packets_skipped;
+        continue;
+      }
+      if (ret >= 0) { ++stats.packets_read; }
+
+      // TODO(tohi): Can we seek based on packet PTS? Not all formats/streams support
+      //             packet PTS.
+
+      // Time spent on frames received from the codec is not counted as decoding.
+      // Filter and copy spans are nested in the decode span.
+      ILP_MOVIE_TRACE_SPAN("decoder", "decode");
+      int64_t frame_ns = 0;
+      const auto t_decode = Clock::now();
+      keep_going =
+        stream->ReceiveFrames(ret >= 0 ? _av_packet : /*flush*/ nullptr, [&](AVFrame *dec_frame) {
+          // TODO(tohi): Can we seek based on frame PTS? Check frame PTS before sending to filter
+          // graph?
+          ++stats.frames_decoded;
+          if (!(dec_frame->pts <= timestamp
+                && timestamp < (dec_frame->pts + dec_frame->pkt_duration))) {
+            ++stats.frames_discarded;
+            return true;
+          }
+          if (is_cancelled()) { return false; }
+
+          const auto t_frame = Clock::now();
+          const bool keep_going_dec = [&]() {
+            if (filter_graph == nullptr) {
+              // Raw frames, no need to look for more frames.
+              ILP_MOVIE_TRACE_SPAN("decoder", "copy");
+              const auto t_copy = Clock::now();
+              got_frame = av_frame_utils_internal::CopyAvFrame(dec_frame, frame_nb, frame);
+              stats.copy_ns += NsSince(t_copy);
+              return false;
+            }
+            ILP_MOVIE_TRACE_SPAN("decoder", "filter");
+            const auto t_filter = Clock::now();
+            if (fs->native_convert
+                && av_frame_utils_internal::ConvertAvFrame(
+                  dec_frame, frame_nb, fs->out_pix_fmt, fs->native_vflip, frame)) {
+              // Found our frame, no need to look for more frames.
+              stats.filter_ns += NsSince(t_filter);
+              got_frame = true;
+              return false;
+            }
+            int64_t copy_ns = 0;
+            const bool keep_going_filt =
+              filter_graph->FilterFrames(dec_frame, [&](AVFrame *filt_frame) {
+                // Check if the frame has a PTS/duration that matches our seek target.
+                if (filt_frame->pts <= timestamp
+                    && timestamp < (filt_frame->pts + filt_frame->pkt_duration)) {
+                  // Found a frame with a good PTS so we do not need to look for more frames.
+                  // This is our one chance.
+                  if (is_cancelled()) { return false; }
+                  ILP_MOVIE_TRACE_SPAN("decoder", "copy");
+                  const auto t_copy = Clock::now();
+                  got_frame = av_frame_utils_internal::CopyAvFrame(filt_frame, frame_nb, frame);
+                  copy_ns += NsSince(t_copy);
+                  return false;
+                }
+                return true;
+              });
+            stats.copy_ns += copy_ns;
+            stats.filter_ns += NsSince(t_filter) - copy_ns;
+            return keep_going_filt;
+          }();
+          frame_ns += NsSince(t_frame);
+          return keep_going_dec;
+        });
+      stats.decode_ns += NsSince(t_decode) - frame_ns;
+    }
+    return got_frame;
+
+    // _av_frame->crop_top
+    // _av_frame->crop_bottom
+    // _av_frame->crop_left
+    // _av_frame->crop_right
+    // av_frame_apply_cropping(...)
+  }
+
+  // Opens the file and creates decoders and filter graphs for all video streams. When waking
+  // up from hibernation the stream headers and probe information are kept as is, since these
+  // may be accessed concurrently (without locking).
+  [[nodiscard]] auto _OpenContexts(const bool wake) noexcept -> bool
   {
     const auto exit_func = [&](const bool success) {
-      if (!success) { Close(); }
+      if (!success) { _CloseContexts(); }
       return success;
     };
 
-    Close();
+    const DecoderFilterGraphDescription &dfgd = _dfgd;
 
     assert(_av_packet == nullptr);// NOLINT
     _av_packet = av_packet_alloc();
@@ -376,7 +1015,6 @@ public:
       return exit_func(/*success=*/false);
     }
 
-    _url = url;
     assert(_av_fmt_ctx == nullptr);// NOLINT
 
     _av_fmt_ctx = avformat_alloc_context();
@@ -399,32 +1037,60 @@ public:
     }
 
     // Find the "best" video stream.
-    assert(_best_video_stream == -1);// NOLINT
-    _best_video_stream = av_find_best_stream(_av_fmt_ctx,
+    const int best_video_stream = av_find_best_stream(_av_fmt_ctx,
       AVMEDIA_TYPE_VIDEO,
       /*wanted_stream_nb=*/-1,
       /*related_stream=*/-1,
       /*decoder_ret=*/nullptr,
       /*flags=*/0);
-    if (_best_video_stream < 0) {
+    if (best_video_stream < 0) {
       log_utils_internal::LogAvError(
-        "Cannot find best video stream for decoding", _best_video_stream);
+        "Cannot find best video stream for decoding", best_video_stream);
       return exit_func(/*success=*/false);
     }
+    if (wake) {
+      if (best_video_stream != _best_video_stream) {
+        LogMsg(LogLevel::kError, "File changed while decoder was hibernating\n");
+        return exit_func(/*success=*/false);
+      }
+    } else {
+      _best_video_stream = best_video_stream;
+    }
 
-    // NOTE(tohi): Not using multi-threading for now. Should test before enabling.
-    constexpr int kThreadCount = 0;
+    // Slices are decoded in parallel, see ExecuteJobs. The decoder still creates its own (idle)
+    // threads, so limit their number since many decoders may be open at the same time.
+    constexpr int kMaxSliceThreads = 16;
+    const int thread_count = std::min(parallel_internal::Concurrency(), kMaxSliceThreads);
 
     // Create and open all video streams.
     for (unsigned int i = 0U; i < _av_fmt_ctx->nb_streams; ++i) {
       if (_av_fmt_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {// NOLINT
         auto video_stream = std::make_unique<Stream>();
         const int stream_index = _av_fmt_ctx->streams[i]->index;// NOLINT
-        if (!video_stream->Open(_av_fmt_ctx, stream_index, kThreadCount)) {
+        if (!video_stream->Open(_av_fmt_ctx, stream_index, thread_count)) {
           LogMsg(LogLevel::kError, "Failed opening video stream for decoding\n");
           return exit_func(/*success=*/false);
         }
 
+        // Cache video stream header information.
+        const auto hdr = video_stream->MakeHeader();
+        if (!hdr.has_value()) {
+          LogMsg(LogLevel::kError, "Cannot make video stream header\n");
+          return exit_func(/*success=*/false);
+        }
+
+        FilteredStream fs{};
+        if (IsRaw(dfgd)) {
+          // Decoded frames are copied as is, without a filter graph.
+          if (!wake) {
+            _video_stream_headers.push_back(*hdr);
+            _filtered_video_stream_headers.push_back(*hdr);
+          }
+          fs.stream = std::move(video_stream);
+          _video_streams[stream_index] = std::move(fs);
+          continue;
+        }
+
         // Create filter graph for video stream.
         // Each video stream requires its own filter graph instance since the inputs are
         // configured from the codec/stream parameters.
@@ -449,18 +1115,39 @@ public:
           return exit_func(/*success=*/false);
         }
 
-        // Cache video stream header information.
-        const auto hdr = video_stream->MakeHeader();
-        if (!hdr.has_value()) {
-          LogMsg(LogLevel::kError, "Cannot make video stream header\n");
+        // The output link properties are known once the filter graph has been configured.
+        const auto fg_out = fg->Output();
+        if (!fg_out.has_value()) {
+          LogMsg(LogLevel::kError, "Cannot get filter graph output properties\n");
           return exit_func(/*success=*/false);
         }
-        _video_stream_headers.push_back(*hdr);
 
-        _video_streams[stream_index] = { std::move(video_stream), std::move(fg) };
+        if (!wake) {
+          _video_stream_headers.push_back(*hdr);
+          _filtered_video_stream_headers.push_back(
+            av_frame_utils_internal::MakeFilteredHeader(*hdr, *fg_out));
+        }
+
+        // Use a native conversion, instead of the filter graph, if the filter graph does nothing
+        // more than converting the pixel format. The filter graph is kept as a fallback for frames
+        // that cannot be converted natively.
+        fs.native_convert =
+          av_frame_utils_internal::IsNativeConvertFilter(dfgd.filter_descr, fs.native_vflip)
+          && CanConvertFrame(av_get_pix_fmt_name(video_stream->CodecContext()->pix_fmt),
+            av_get_pix_fmt_name(out_pix_fmt));
+        fs.out_pix_fmt = out_pix_fmt;
+        fs.stream = std::move(video_stream);
+        fs.filter_graph = std::move(fg);
+        _video_streams[stream_index] = std::move(fs);
       }
     }
 
+    if (wake) {
+      // Probe information is kept from when the file was first opened.
+      _hibernating = false;
+      return exit_func(/*success=*/true);
+    }
+
     assert(_probe.empty());// NOLINT
     _probe = std::invoke([&]() {
       const auto push_cb = GetLogCallback();
@@ -478,15 +1165,8 @@ public:
     return exit_func(/*success=*/true);
   }
 
-  [[nodiscard]] auto IsOpen() const noexcept -> bool { return !_url.empty(); }
-
-  [[nodiscard]] auto Url() const noexcept -> const std::string & { return _url; }
-  [[nodiscard]] auto Probe() const noexcept -> const std::string & { return _probe; }
-
-  void Close() noexcept
+  void _CloseContexts() noexcept
   {
-    _url.clear();
-    _probe.clear();
     if (_av_fmt_ctx != nullptr) {
       // Calls avformat_free_context internally.
       avformat_close_input(&_av_fmt_ctx);
@@ -497,24 +1177,23 @@ public:
       av_packet_free(&_av_packet);
       assert(_av_packet == nullptr);// NOLINT
     }
-    _best_video_stream = -1;
-    _video_stream_headers.clear();
     _video_streams.clear();
   }
 
-  [[nodiscard]] auto BestVideoStreamIndex() const noexcept -> std::optional<int> { 
-    if (!(_best_video_stream >= 0)) { return std::nullopt; }
-    return _best_video_stream; 
-  }
-
-  [[nodiscard]] auto VideoStreamHeaders() const noexcept
-    -> const std::vector<InputVideoStreamHeader> &
+  void _Close() noexcept
   {
-    return _video_stream_headers;
+    _CloseContexts();
+    _url.clear();
+    _probe.clear();
+    _dfgd = {};
+    _hibernating = false;
+    _best_video_stream = -1;
+    _video_stream_headers.clear();
+    _filtered_video_stream_headers.clear();
   }
 
-  [[nodiscard]] auto VideoStreamHeader(const int stream_index) const noexcept
-    -> std::optional<InputVideoStreamHeader>
+  [[nodiscard]] auto _FindHeader(const std::vector<InputVideoStreamHeader> &headers,
+    const int stream_index) const noexcept -> std::optional<InputVideoStreamHeader>
   {
     // In the special case of -1 being passed substitute the search index
     // to be the "best" video stream index. After this potential substitution
@@ -523,7 +1202,7 @@ public:
     if (!(search_index >= 0)) { return std::nullopt; }
 
     // Linear search, only video streams.
-    for (auto &&hdr : _video_stream_headers) {
+    for (auto &&hdr : headers) {
       if (hdr.stream_index == search_index) { return hdr; }
     }
 
@@ -531,158 +1210,41 @@ public:
     return std::nullopt;
   }
 
-  [[nodiscard]] auto DecodeVideoFrame(int stream_index, int frame_nb, Frame &frame) noexcept -> bool
-  {
-    const int index = stream_index == -1 ? _best_video_stream : stream_index;
-
-    Stream *stream = nullptr;
-    filter_graph_internal::FilterGraph *filter_graph = nullptr;
-    if (const auto fs_iter = _video_streams.find(index); fs_iter != _video_streams.end()) {
-      stream = fs_iter->second.stream.get();
-      filter_graph = fs_iter->second.filter_graph.get();
-    } else {
-      LogMsg(LogLevel::kWarning, "Bad stream index for decoding video frame\n");
-      return false;
-    }
-    assert(stream != nullptr);// NOLINT
-    assert(filter_graph != nullptr);// NOLINT
-
-    // Check if frame exists in stream.
-    if (!(1 <= frame_nb && frame_nb <= stream->FrameCount())) { return false; }
-
-    const int64_t timestamp = stream->FrameToPts(frame_nb - 1);
+  // Serializes decoding, since decoding modifies the state of the format and codec contexts,
+  // as well as hibernation.
+  mutable std::mutex _mutex;
+  bool _hibernating = false;
 
-    constexpr int kSeekFlags = AVSEEK_FLAG_BACKWARD;
-    if (const int ret = av_seek_frame(_av_fmt_ctx, stream->Get()->index, timestamp, kSeekFlags);
-        ret < 0) {
-      log_utils_internal::LogAvError("Cannot seek to timestamp", ret);
-      return false;
-    }
-
-    stream->FlushCodec();
-
-    bool got_frame = false;
-    bool keep_going = true;
-    int ret = 0;
-    while (ret >= 0 && keep_going) {
-      // Read a packet, which for video streams corresponds to one frame.
-      ret = av_read_frame(_av_fmt_ctx, _av_packet);
-
-      // A packet was successfully read, check if was from the stream we are interested in.
-      if (ret >= 0 && _av_packet->stream_index != stream->Get()->index) {
-        // Ignore packets that are not from the video stream we are trying to read from.
-        av_packet_unref(_av_packet);
-        continue;
-      }
-
-      // TODO(tohi): Can we seek based on packet PTS? Not all formats/streams support
-      //             packet PTS.
-
-      keep_going =
-        stream->ReceiveFrames(ret >= 0 ? _av_packet : /*flush*/ nullptr, [&](AVFrame *dec_frame) {
-          // TODO(tohi): Can we seek based on frame PTS? Check frame PTS before sending to filter
-          // graph?
-          bool keep_going_dec = true;
-          if (dec_frame->pts <= timestamp
-              && timestamp < (dec_frame->pts + dec_frame->pkt_duration)) {
-            keep_going_dec = filter_graph->FilterFrames(dec_frame, [&](AVFrame *filt_frame) {
-              // Check if the frame has a PTS/duration that matches our seek target.
-              bool keep_going_filt = true;
-              if (filt_frame->pts <= timestamp
-                  && timestamp < (filt_frame->pts + filt_frame->pkt_duration)) {
-                // Found a frame with a good PTS so we do not need to look for more frames.
-                // This is our one chance.
-                keep_going_filt = false;
-
-                const auto pix_fmt = static_cast<AVPixelFormat>(filt_frame->format);
-
-                // Translate frame header.
-
-                // clang-format off
-                frame.hdr.width = filt_frame->width;
-                frame.hdr.height = filt_frame->height;
-                assert(frame.hdr.width > 0 && frame.hdr.height > 0);// NOLINT
-                frame.hdr.key_frame = filt_frame->key_frame > 0;
-                frame.hdr.frame_nb = frame_nb;
-                frame.hdr.pixel_aspect_ratio = { 
-                  /*.num=*/filt_frame->sample_aspect_ratio.num,
-                  /*.den=*/filt_frame->sample_aspect_ratio.den 
-                };
-                frame.hdr.pix_fmt_name = av_get_pix_fmt_name(pix_fmt);
-                frame.hdr.color_range_name = av_color_range_name(filt_frame->color_range);
-                frame.hdr.color_space_name = av_color_space_name(filt_frame->colorspace);
-                frame.hdr.color_trc_name = av_color_transfer_name(filt_frame->color_trc);
-                frame.hdr.color_primaries_name = av_color_primaries_name(filt_frame->color_primaries);
-                // clang-format on
-
-                // Allocate buffer.
-                const auto buf_size =
-                  GetBufferSize(frame.hdr.pix_fmt_name, frame.hdr.width, frame.hdr.height);
-                if (!buf_size.has_value()) {
-                  log_utils_internal::LogAvError("Cannot get image buffer size", AVERROR(EINVAL));
-                  return keep_going_filt;
-                }
-                frame.buf = std::make_unique<uint8_t[]>(*buf_size);// NOLINT
-
-                // Setup arrays.
-                if (!FillArrays(/*out*/ frame.data,
-                      /*out*/ frame.linesize,
-                      frame.buf.get(),
-                      frame.hdr.pix_fmt_name,
-                      frame.hdr.width,
-                      frame.hdr.height)) {
-                  return keep_going_filt;
-                }
-
-                // Copy frame contents to buffer.
-                if (const int bytes_written = av_image_copy_to_buffer(frame.buf.get(),
-                      static_cast<int>(*buf_size),
-                      filt_frame->data,// NOLINT
-                      filt_frame->linesize,// NOLINT
-                      pix_fmt,
-                      frame.hdr.width,
-                      frame.hdr.height,
-                      /*align=*/1);
-                    bytes_written < 0) {
-                  log_utils_internal::LogAvError("Cannot copy image to buffer", bytes_written);
-                  return keep_going_filt;
-                }
-
-                got_frame = true;
-                return keep_going_filt;
-              }
-              return keep_going_filt;
-            });
-          }
-          return keep_going_dec;
-        });
-    }
-    return got_frame;
-
-    // _av_frame->crop_top
-    // _av_frame->crop_bottom
-    // _av_frame->crop_left
-    // _av_frame->crop_right
-    // av_frame_apply_cropping(...)
-  }
-
-private:
   std::string _url;
   std::string _probe;
+  DecoderFilterGraphDescription _dfgd;
 
   AVFormatContext *_av_fmt_ctx = nullptr;
   AVPacket *_av_packet = nullptr;
 
   int _best_video_stream = -1;
   std::vector<InputVideoStreamHeader> _video_stream_headers;
+  std::vector<InputVideoStreamHeader> _filtered_video_stream_headers;
 
   struct FilteredStream
   {
     std::unique_ptr<Stream> stream;
+
+    // Null for raw frames.
     std::unique_ptr<filter_graph_internal::FilterGraph> filter_graph;
+
+    // Bypass the filter graph, see ConvertFrame.
+    bool native_convert = false;
+    bool native_vflip = false;
+    AVPixelFormat out_pix_fmt = AV_PIX_FMT_NONE;
   };
 
   std::map<int, FilteredStream> _video_streams;
+
+  AtomicDecoderStats _stats;
+
+  // Declared last, so that it is destroyed first.
+  AsyncDecodeQueue _async;
 };
 
 // -----------
@@ -708,6 +1270,12 @@ auto Decoder::Probe() const noexcept -> const std::string & { return _Pimpl()->P
 
 void Decoder::Close() noexcept { _Pimpl()->Close(); }
 
+void Decoder::Hibernate() noexcept { _Pimpl()->Hibernate(); }
+
+auto Decoder::TryHibernate() noexcept -> bool { return _Pimpl()->TryHibernate(); }
+
+auto Decoder::IsHibernating() const noexcept -> bool { return _Pimpl()->IsHibernating(); }
+
 auto Decoder::BestVideoStreamIndex() const noexcept -> std::optional<int>
 {
   return _Pimpl()->BestVideoStreamIndex();
@@ -724,10 +1292,51 @@ auto Decoder::VideoStreamHeader(const int stream_index) const noexcept
   return _Pimpl()->VideoStreamHeader(stream_index);
 }
 
+auto Decoder::FilteredVideoStreamHeader(const int stream_index) const noexcept
+  -> std::optional<InputVideoStreamHeader>
+{
+  return _Pimpl()->FilteredVideoStreamHeader(stream_index);
+}
+
 auto Decoder::DecodeVideoFrame(const int stream_index, const int frame_nb, Frame &frame) noexcept
   -> bool
 {
-  return _Pimpl()->DecodeVideoFrame(stream_index, frame_nb, frame);
+  return DecodeVideoFrame(stream_index, frame_nb, frame, /*cancelled=*/DecodeCancelledFunc{});
+}
+
+auto Decoder::DecodeVideoFrame(const int stream_index,
+  const int frame_nb,
+  Frame &frame,
+  const DecodeCancelledFunc &cancelled) noexcept -> bool
+{
+  return _Pimpl()->DecodeVideoFrame(stream_index, frame_nb, frame, cancelled);
+}
+
+auto Decoder::DecodeVideoFrameAsync(const int stream_index, const int frame_nb) noexcept
+  -> std::shared_future<DecodedFrame>
+{
+  return _Pimpl()->DecodeVideoFrameAsync(stream_index, frame_nb, /*on_decoded=*/DecodeCallback{});
 }
 
+void Decoder::DecodeVideoFrameAsync(const int stream_index,
+  const int frame_nb,
+  DecodeCallback on_decoded) noexcept
+{
+  (void)_Pimpl()->DecodeVideoFrameAsync(stream_index, frame_nb, std::move(on_decoded));
+}
+
+auto Decoder::PendingDecodeCount() const noexcept -> int
+{
+  return _Pimpl()->PendingDecodeCount();
+}
+
+void Decoder::SetExecutor(DecodeExecutor executor) noexcept
+{
+  _Pimpl()->SetExecutor(std::move(executor));
+}
+
+auto Decoder::Stats() const noexcept -> DecoderStats { return _Pimpl()->Stats(); }
+
+void Decoder::ResetStats() noexcept { _Pimpl()->ResetStats(); }
+
 }// namespace ilp_movie
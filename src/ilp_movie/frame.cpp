@@ -36,32 +36,52 @@ auto FillArrays(std::array<uint8_t *, 4> &data,
          >= 0;
 }
 
-template<>
-auto CompPixelData<float>(const std::array<uint8_t *, 4> &data,
-  const std::array<int, 4> &linesize,
-  const Comp::ValueType c,
-  const int height,
-  const char *const pix_fmt_name) noexcept -> PixelData<float>
+namespace {
+
+// Returns the pixel format descriptor if the component can be accessed as planar 32-bit float
+// (RGB) pixel data; otherwise null.
+[[nodiscard]] auto CompPixFmtDesc(const Comp::ValueType c, const char *const pix_fmt_name) noexcept
+  -> const AVPixFmtDescriptor *
 {
-  if (pix_fmt_name == nullptr || c == Comp::kUnknown) { return {}; }
+  if (pix_fmt_name == nullptr || c == Comp::kUnknown) { return nullptr; }
 
   const AVPixelFormat pix_fmt = av_get_pix_fmt(pix_fmt_name);
-  if (pix_fmt == AV_PIX_FMT_NONE) { return {}; }
+  if (pix_fmt == AV_PIX_FMT_NONE) { return nullptr; }
 
   const AVPixFmtDescriptor *const pix_desc = av_pix_fmt_desc_get(pix_fmt);
-  if (pix_desc == nullptr) { return {}; }
+  if (pix_desc == nullptr) { return nullptr; }
   assert(1U <= pix_desc->nb_components && pix_desc->nb_components <= 4U);// NOLINT
-  if (!(0 <= c && c < static_cast<Comp::ValueType>(pix_desc->nb_components))) { return {}; }
+  if (!(0 <= c && c < static_cast<Comp::ValueType>(pix_desc->nb_components))) { return nullptr; }
 
   // Check flags, all must be set in the pixel description.
   uint64_t mask = 0U;
   mask |= AV_PIX_FMT_FLAG_RGB;// NOLINT
   mask |= AV_PIX_FMT_FLAG_FLOAT;// NOLINT
   mask |= AV_PIX_FMT_FLAG_PLANAR;// NOLINT
-  if ((pix_desc->flags & mask) != mask) { return {}; }
+  if ((pix_desc->flags & mask) != mask) { return nullptr; }
 
   // Check 32-bit floats.
-  if (!(pix_desc->comp[c].depth == 32)) { return {}; }// NOLINT
+  if (!(pix_desc->comp[c].depth == 32)) { return nullptr; }// NOLINT
+
+  return pix_desc;
+}
+
+}// namespace
+
+auto HasCompPixelData(const Comp::ValueType c, const char *const pix_fmt_name) noexcept -> bool
+{
+  return CompPixFmtDesc(c, pix_fmt_name) != nullptr;
+}
+
+template<>
+auto CompPixelData<float>(const std::array<uint8_t *, 4> &data,
+  const std::array<int, 4> &linesize,
+  const Comp::ValueType c,
+  const int height,
+  const char *const pix_fmt_name) noexcept -> PixelData<float>
+{
+  const AVPixFmtDescriptor *const pix_desc = CompPixFmtDesc(c, pix_fmt_name);
+  if (pix_desc == nullptr) { return {}; }
 
   // Which plane contains the requested component?
   const auto p = static_cast<std::size_t>(pix_desc->comp[c].plane);// NOLINT
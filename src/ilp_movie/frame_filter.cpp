@@ -0,0 +1,199 @@
+#include "ilp_movie/frame_filter.hpp"
+
+#include <mutex>// std::mutex, std::lock_guard, std::unique_lock
+
+#include "ilp_movie/convert.hpp"
+#include "ilp_movie/frame.hpp"
+#include "ilp_movie/log.hpp"
+#include "internal/av_frame_utils.hpp"
+#include "internal/filter_graph.hpp"
+#include "internal/log_utils.hpp"
+
+// clang-format off
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+}
+// clang-format on
+
+namespace {
+
+// Frames are allocated by libav, since the size of AVFrame is not part of the ABI.
+struct AvFrameDeleter
+{
+  void operator()(AVFrame *f) const noexcept { av_frame_free(&f); }
+};
+using AvFramePtr = std::unique_ptr<AVFrame, AvFrameDeleter>;
+
+}// namespace
+
+namespace ilp_movie {
+
+class FrameFilterImpl
+{
+public:
+  FrameFilterImpl() = default;
+  ~FrameFilterImpl() = default;
+
+  // Not movable, since the mutex isn't. The filter is moved by moving its pointer to the
+  // implementation.
+  FrameFilterImpl(FrameFilterImpl &&rhs) noexcept = delete;
+  FrameFilterImpl &operator=(FrameFilterImpl &&rhs) noexcept = delete;
+
+  // Not copyable.
+  FrameFilterImpl(const FrameFilterImpl &rhs) = delete;
+  FrameFilterImpl &operator=(const FrameFilterImpl &rhs) = delete;
+
+  [[nodiscard]] auto SetDescription(const DecoderFilterGraphDescription &dfgd,
+    const InputVideoStreamHeader &in_hdr) noexcept -> bool
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    _Reset();
+
+    const AVPixelFormat in_pix_fmt =
+      in_hdr.pix_fmt_name != nullptr ? av_get_pix_fmt(in_hdr.pix_fmt_name) : AV_PIX_FMT_NONE;
+    const AVPixelFormat out_pix_fmt = av_get_pix_fmt(dfgd.out_pix_fmt_name.c_str());
+    if (in_pix_fmt == AV_PIX_FMT_NONE || out_pix_fmt == AV_PIX_FMT_NONE) {
+      LogMsg(LogLevel::kError, "Unrecognized pixel format for frame filter\n");
+      return false;
+    }
+
+    // Frames are pushed one at a time, each with unit duration, see WrapFrame.
+    filter_graph_internal::FilterGraphDescription fg_descr{};
+    fg_descr.filter_descr = dfgd.filter_descr;
+    fg_descr.in.width = in_hdr.width;
+    fg_descr.in.height = in_hdr.height;
+    fg_descr.in.pix_fmt = in_pix_fmt;
+    fg_descr.in.sample_aspect_ratio = { /*.num=*/in_hdr.pixel_aspect_ratio.num,
+      /*.den=*/in_hdr.pixel_aspect_ratio.den };
+    fg_descr.in.time_base = { /*.num=*/1, /*.den=*/1 };
+    fg_descr.out.pix_fmt = out_pix_fmt;
+    auto fg = std::make_unique<filter_graph_internal::FilterGraph>();
+    if (!fg->SetDescription(fg_descr)) {
+      LogMsg(LogLevel::kError, "Failed constructing filter graph for frame filter\n");
+      return false;
+    }
+
+    const auto fg_out = fg->Output();
+    if (!fg_out.has_value()) {
+      LogMsg(LogLevel::kError, "Cannot get filter graph output properties\n");
+      return false;
+    }
+
+    _native_convert =
+      av_frame_utils_internal::IsNativeConvertFilter(dfgd.filter_descr, _native_vflip)
+      && CanConvertFrame(in_hdr.pix_fmt_name, av_get_pix_fmt_name(out_pix_fmt));
+    _in_hdr = in_hdr;
+    _out_hdr = av_frame_utils_internal::MakeFilteredHeader(in_hdr, *fg_out);
+    _out_pix_fmt = out_pix_fmt;
+    _filter_graph = std::move(fg);
+    return true;
+  }
+
+  [[nodiscard]] auto OutputHeader() const noexcept -> std::optional<InputVideoStreamHeader>
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    return _out_hdr;
+  }
+
+  [[nodiscard]] auto NativeConvert() const noexcept -> std::optional<ConvertOptions>
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    if (!_native_convert) { return std::nullopt; }
+    ConvertOptions opts{};
+    opts.vflip = _native_vflip;
+    return opts;
+  }
+
+  [[nodiscard]] auto FilterFrame(const Frame &in_frame, Frame &out_frame) const noexcept -> bool
+  {
+    AvFramePtr av_frame{ av_frame_alloc() };
+    if (av_frame == nullptr) {
+      log_utils_internal::LogAvError("Cannot allocate frame for filtering", AVERROR(ENOMEM));
+      return false;
+    }
+    if (!av_frame_utils_internal::WrapFrame(in_frame, av_frame.get())) { return false; }
+
+    std::unique_lock<std::mutex> lock{ _mutex };
+    if (_filter_graph == nullptr) {
+      LogMsg(LogLevel::kWarning, "Cannot filter frame - no description set for frame filter\n");
+      return false;
+    }
+    if (!(in_frame.hdr.width == _in_hdr.width && in_frame.hdr.height == _in_hdr.height
+          && av_frame->format == av_get_pix_fmt(_in_hdr.pix_fmt_name))) {
+      LogMsg(LogLevel::kError, "Frame does not match frame filter input\n");
+      return false;
+    }
+
+    if (_native_convert) {
+      // The native conversion has no state, so there is no need to hold on to the lock.
+      const AVPixelFormat out_pix_fmt = _out_pix_fmt;
+      const bool vflip = _native_vflip;
+      lock.unlock();
+      if (av_frame_utils_internal::ConvertAvFrame(
+            av_frame.get(), in_frame.hdr.frame_nb, out_pix_fmt, vflip, out_frame)) {
+        return true;
+      }
+      lock.lock();
+    }
+
+    bool got_frame = false;
+    const bool ok = _filter_graph->FilterFrames(av_frame.get(), [&](AVFrame *filt_frame) {
+      got_frame =
+        av_frame_utils_internal::CopyAvFrame(filt_frame, in_frame.hdr.frame_nb, out_frame);
+      return false;
+    });
+    return ok && got_frame;
+  }
+
+private:
+  void _Reset() noexcept
+  {
+    _filter_graph.reset();
+    _in_hdr = {};
+    _out_hdr.reset();
+    _out_pix_fmt = AV_PIX_FMT_NONE;
+    _native_convert = false;
+    _native_vflip = false;
+  }
+
+  // Serializes filtering, since pushing frames through a filter graph modifies its state.
+  mutable std::mutex _mutex;
+
+  std::unique_ptr<filter_graph_internal::FilterGraph> _filter_graph;
+  InputVideoStreamHeader _in_hdr = {};
+  std::optional<InputVideoStreamHeader> _out_hdr;
+  AVPixelFormat _out_pix_fmt = AV_PIX_FMT_NONE;
+
+  // Bypass the filter graph, see ConvertFrame.
+  bool _native_convert = false;
+  bool _native_vflip = false;
+};
+
+// -----------
+
+FrameFilter::FrameFilter() : _pimpl{ std::make_unique<FrameFilterImpl>() } {}
+FrameFilter::~FrameFilter() = default;
+
+auto FrameFilter::SetDescription(const DecoderFilterGraphDescription &dfgd,
+  const InputVideoStreamHeader &in_hdr) noexcept -> bool
+{
+  return _Pimpl()->SetDescription(dfgd, in_hdr);
+}
+
+auto FrameFilter::OutputHeader() const noexcept -> std::optional<InputVideoStreamHeader>
+{
+  return _Pimpl()->OutputHeader();
+}
+
+auto FrameFilter::NativeConvert() const noexcept -> std::optional<ConvertOptions>
+{
+  return _Pimpl()->NativeConvert();
+}
+
+auto FrameFilter::FilterFrame(const Frame &in_frame, Frame &out_frame) const noexcept -> bool
+{
+  return _Pimpl()->FilterFrame(in_frame, out_frame);
+}
+
+}// namespace ilp_movie
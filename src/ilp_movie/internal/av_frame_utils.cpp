@@ -0,0 +1,245 @@
+#include <internal/av_frame_utils.hpp>
+
+#include <cassert>// assert
+
+// clang-format off
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/mathematics.h>
+#include <libavutil/pixdesc.h>
+}
+// clang-format on
+
+#include <ilp_movie/convert.hpp>
+#include <ilp_movie/log.hpp>
+#include <internal/log_utils.hpp>
+
+namespace {
+
+// Returns the enum value for a color property name, or the fallback value if the name is null or
+// not recognized.
+template<typename EnumT>
+[[nodiscard]] auto ColorEnum(const char *name, int (*from_name)(const char *), const EnumT fallback)
+  -> EnumT
+{
+  if (name == nullptr) { return fallback; }
+  const int value = from_name(name);
+  return value < 0 ? fallback : static_cast<EnumT>(value);
+}
+
+}// namespace
+
+namespace av_frame_utils_internal {
+
+auto IsNativeConvertFilter(const std::string &filter_descr, bool &vflip) noexcept -> bool
+{
+  const auto first = filter_descr.find_first_not_of(" \t\n");
+  const auto last = filter_descr.find_last_not_of(" \t\n");
+  const std::string f =
+    first == std::string::npos ? std::string{} : filter_descr.substr(first, last - first + 1);
+  if (f == "null") {
+    vflip = false;
+    return true;
+  }
+  if (f == "vflip") {
+    vflip = true;
+    return true;
+  }
+  return false;
+}
+
+auto ConvertAvFrame(const AVFrame *av_frame,
+  const int64_t frame_nb,
+  const AVPixelFormat out_pix_fmt,
+  const bool vflip,
+  ilp_movie::Frame &frame) noexcept -> bool
+{
+  ilp_movie::FrameView src{};
+  src.hdr.width = av_frame->width;
+  src.hdr.height = av_frame->height;
+  src.hdr.pix_fmt_name = av_get_pix_fmt_name(static_cast<AVPixelFormat>(av_frame->format));
+  src.hdr.color_range_name = av_color_range_name(av_frame->color_range);
+  src.hdr.color_space_name = av_color_space_name(av_frame->colorspace);
+  for (std::size_t i = 0U; i < 4U; ++i) {
+    src.data.at(i) = av_frame->data[i];// NOLINT
+    src.linesize.at(i) = av_frame->linesize[i];// NOLINT
+  }
+
+  const char *out_pix_fmt_name = av_get_pix_fmt_name(out_pix_fmt);
+  if (!ilp_movie::CanConvertFrame(src.hdr.pix_fmt_name, out_pix_fmt_name)) { return false; }
+
+  // clang-format off
+  frame.hdr.width = av_frame->width;
+  frame.hdr.height = av_frame->height;
+  frame.hdr.key_frame = av_frame->key_frame > 0;
+  frame.hdr.frame_nb = frame_nb;
+  frame.hdr.pixel_aspect_ratio = {
+    /*.num=*/av_frame->sample_aspect_ratio.num,
+    /*.den=*/av_frame->sample_aspect_ratio.den
+  };
+  frame.hdr.pix_fmt_name = out_pix_fmt_name;
+  frame.hdr.color_range_name = av_color_range_name(AVCOL_RANGE_JPEG);
+  frame.hdr.color_space_name = av_color_space_name(AVCOL_SPC_RGB);
+  frame.hdr.color_trc_name = av_color_transfer_name(av_frame->color_trc);
+  frame.hdr.color_primaries_name = av_color_primaries_name(av_frame->color_primaries);
+  // clang-format on
+
+  const auto buf_size =
+    ilp_movie::GetBufferSize(frame.hdr.pix_fmt_name, frame.hdr.width, frame.hdr.height);
+  if (!buf_size.has_value()) {
+    log_utils_internal::LogAvError("Cannot get image buffer size", AVERROR(EINVAL));
+    return false;
+  }
+  frame.buf = std::make_unique<uint8_t[]>(*buf_size);// NOLINT
+  if (!ilp_movie::FillArrays(/*out*/ frame.data,
+        /*out*/ frame.linesize,
+        frame.buf.get(),
+        frame.hdr.pix_fmt_name,
+        frame.hdr.width,
+        frame.hdr.height)) {
+    return false;
+  }
+
+  ilp_movie::FrameView dst{};
+  dst.hdr = frame.hdr;
+  dst.data = frame.data;
+  dst.linesize = frame.linesize;
+  dst.buf = frame.buf.get();
+
+  ilp_movie::ConvertOptions opts{};
+  opts.vflip = vflip;
+  return ilp_movie::ConvertFrame(src, dst, opts);
+}
+
+auto CopyAvFrame(const AVFrame *av_frame, const int64_t frame_nb, ilp_movie::Frame &frame) noexcept
+  -> bool
+{
+  const auto pix_fmt = static_cast<AVPixelFormat>(av_frame->format);
+
+  // Translate frame header.
+
+  // clang-format off
+  frame.hdr.width = av_frame->width;
+  frame.hdr.height = av_frame->height;
+  assert(frame.hdr.width > 0 && frame.hdr.height > 0);// NOLINT
+  frame.hdr.key_frame = av_frame->key_frame > 0;
+  frame.hdr.frame_nb = frame_nb;
+  frame.hdr.pixel_aspect_ratio = {
+    /*.num=*/av_frame->sample_aspect_ratio.num,
+    /*.den=*/av_frame->sample_aspect_ratio.den
+  };
+  frame.hdr.pix_fmt_name = av_get_pix_fmt_name(pix_fmt);
+  frame.hdr.color_range_name = av_color_range_name(av_frame->color_range);
+  frame.hdr.color_space_name = av_color_space_name(av_frame->colorspace);
+  frame.hdr.color_trc_name = av_color_transfer_name(av_frame->color_trc);
+  frame.hdr.color_primaries_name = av_color_primaries_name(av_frame->color_primaries);
+  // clang-format on
+
+  // Allocate buffer.
+  const auto buf_size =
+    ilp_movie::GetBufferSize(frame.hdr.pix_fmt_name, frame.hdr.width, frame.hdr.height);
+  if (!buf_size.has_value()) {
+    log_utils_internal::LogAvError("Cannot get image buffer size", AVERROR(EINVAL));
+    return false;
+  }
+  frame.buf = std::make_unique<uint8_t[]>(*buf_size);// NOLINT
+
+  // Setup arrays.
+  if (!ilp_movie::FillArrays(/*out*/ frame.data,
+        /*out*/ frame.linesize,
+        frame.buf.get(),
+        frame.hdr.pix_fmt_name,
+        frame.hdr.width,
+        frame.hdr.height)) {
+    return false;
+  }
+
+  // Copy frame contents to buffer.
+  if (const int bytes_written = av_image_copy_to_buffer(frame.buf.get(),
+        static_cast<int>(*buf_size),
+        av_frame->data,// NOLINT
+        av_frame->linesize,// NOLINT
+        pix_fmt,
+        frame.hdr.width,
+        frame.hdr.height,
+        /*align=*/1);
+      bytes_written < 0) {
+    log_utils_internal::LogAvError("Cannot copy image to buffer", bytes_written);
+    return false;
+  }
+  return true;
+}
+
+auto WrapFrame(const ilp_movie::Frame &frame, AVFrame *av_frame) noexcept -> bool
+{
+  const AVPixelFormat pix_fmt =
+    frame.hdr.pix_fmt_name != nullptr ? av_get_pix_fmt(frame.hdr.pix_fmt_name) : AV_PIX_FMT_NONE;
+  if (!(av_frame != nullptr && pix_fmt != AV_PIX_FMT_NONE && frame.hdr.width > 0
+        && frame.hdr.height > 0)) {
+    ilp_movie::LogMsg(ilp_movie::LogLevel::kError, "Cannot wrap frame\n");
+    return false;
+  }
+
+  av_frame_unref(av_frame);
+  av_frame->width = frame.hdr.width;
+  av_frame->height = frame.hdr.height;
+  av_frame->format = pix_fmt;
+  for (std::size_t i = 0U; i < 4U; ++i) {
+    av_frame->data[i] = frame.data.at(i);// NOLINT
+    av_frame->linesize[i] = frame.linesize.at(i);// NOLINT
+  }
+  av_frame->key_frame = frame.hdr.key_frame ? 1 : 0;
+  av_frame->sample_aspect_ratio = { /*.num=*/frame.hdr.pixel_aspect_ratio.num,
+    /*.den=*/frame.hdr.pixel_aspect_ratio.den };
+
+  // clang-format off
+  av_frame->color_range = ColorEnum(
+    frame.hdr.color_range_name, av_color_range_from_name, AVCOL_RANGE_UNSPECIFIED);
+  av_frame->colorspace = ColorEnum(
+    frame.hdr.color_space_name, av_color_space_from_name, AVCOL_SPC_UNSPECIFIED);
+  av_frame->color_trc = ColorEnum(
+    frame.hdr.color_trc_name, av_color_transfer_from_name, AVCOL_TRC_UNSPECIFIED);
+  av_frame->color_primaries = ColorEnum(
+    frame.hdr.color_primaries_name, av_color_primaries_from_name, AVCOL_PRI_UNSPECIFIED);
+  // clang-format on
+
+  // One-based frame numbers, in a time base where each frame has unit duration.
+  av_frame->pts = frame.hdr.frame_nb - 1;
+  av_frame->pkt_duration = 1;
+  return true;
+}
+
+auto MakeFilteredHeader(const ilp_movie::InputVideoStreamHeader &in_hdr,
+  const filter_graph_internal::FilterGraphOutput &out) noexcept -> ilp_movie::InputVideoStreamHeader
+{
+  ilp_movie::InputVideoStreamHeader hdr = in_hdr;
+  hdr.width = out.width;
+  hdr.height = out.height;
+
+  // clang-format off
+  hdr.pixel_aspect_ratio = {
+    /*.num=*/out.sample_aspect_ratio.num,
+    /*.den=*/out.sample_aspect_ratio.den };
+  hdr.display_aspect_ratio = {};
+  if (out.sample_aspect_ratio.num > 0 && out.sample_aspect_ratio.den > 0) {
+    av_reduce(&hdr.display_aspect_ratio.num, &hdr.display_aspect_ratio.den,
+      out.width * static_cast<int64_t>(out.sample_aspect_ratio.num),
+      out.height * static_cast<int64_t>(out.sample_aspect_ratio.den),
+      1024 * 1024);
+  }
+  // clang-format on
+
+  hdr.pix_fmt_name = av_get_pix_fmt_name(out.pix_fmt);
+
+  // Frames converted to RGB are full range, same as for the native conversion (see
+  // ConvertAvFrame). Transfer characteristics and primaries are passed through.
+  if (const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(out.pix_fmt);
+      desc != nullptr && (desc->flags & AV_PIX_FMT_FLAG_RGB) != 0U) {// NOLINT
+    hdr.color_range_name = av_color_range_name(AVCOL_RANGE_JPEG);
+    hdr.color_space_name = av_color_space_name(AVCOL_SPC_RGB);
+  }
+  return hdr;
+}
+
+}// namespace av_frame_utils_internal
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>// int64_t
+#include <string>// std::string
+
+// clang-format off
+extern "C" {
+#include <libavutil/pixfmt.h>// AVPixelFormat
+}
+// clang-format on
+
+#include <ilp_movie/decoder.hpp>// ilp_movie::InputVideoStreamHeader
+#include <ilp_movie/frame.hpp>// ilp_movie::Frame
+#include <ilp_movie/ilp_movie_export.hpp>// ILP_MOVIE_NO_EXPORT
+
+#include "internal/filter_graph.hpp"// filter_graph_internal::FilterGraphOutput
+
+// Forward declarations.
+struct AVFrame;
+
+namespace av_frame_utils_internal {
+
+// Filter graphs that can be replaced by a native pixel format conversion, i.e. those that
+// only do a pixel format conversion and possibly a vertical flip. Returns true if so, and
+// sets vflip accordingly.
+[[nodiscard]] ILP_MOVIE_NO_EXPORT auto IsNativeConvertFilter(const std::string &filter_descr,
+  bool &vflip) noexcept -> bool;
+
+// Convert a frame directly to the output pixel format, bypassing the filter graph.
+// Returns false if the frame cannot be converted natively, for instance if it uses an
+// unsupported color matrix.
+[[nodiscard]] ILP_MOVIE_NO_EXPORT auto ConvertAvFrame(const AVFrame *av_frame,
+  int64_t frame_nb,
+  AVPixelFormat out_pix_fmt,
+  bool vflip,
+  ilp_movie::Frame &frame) noexcept -> bool;
+
+// Copy a frame, keeping its pixel format. The copied pixels are tightly packed.
+[[nodiscard]] ILP_MOVIE_NO_EXPORT auto CopyAvFrame(const AVFrame *av_frame,
+  int64_t frame_nb,
+  ilp_movie::Frame &frame) noexcept -> bool;
+
+// Setup a (non reference counted) AVFrame that references the pixels of the frame. The frame
+// must outlive av_frame, and any frames referencing av_frame are given a copy of the pixels.
+[[nodiscard]] ILP_MOVIE_NO_EXPORT auto WrapFrame(const ilp_movie::Frame &frame,
+  AVFrame *av_frame) noexcept -> bool;
+
+// Make a header describing the frames pulled from a filter graph, given the header of the
+// decoded video stream. Note that this does not require decoding any frames.
+[[nodiscard]] ILP_MOVIE_NO_EXPORT auto MakeFilteredHeader(
+  const ilp_movie::InputVideoStreamHeader &in_hdr,
+  const filter_graph_internal::FilterGraphOutput &out) noexcept
+  -> ilp_movie::InputVideoStreamHeader;
+
+}// namespace av_frame_utils_internal
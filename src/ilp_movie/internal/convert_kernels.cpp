@@ -0,0 +1,825 @@
+#include "internal/convert_kernels.hpp"
+
+#include <algorithm>// std::max, std::min
+#include <cmath>// std::nearbyint
+#include <cstring>// std::memcpy
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ILP_MOVIE_CONVERT_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define ILP_MOVIE_CONVERT_X86 0
+#endif
+
+// NOTE(tohi): The scalar code must not be contracted into fused multiply-adds, otherwise it
+//             would no longer be bit-exact with the vectorized code. This is the default for
+//             GCC in ISO C++ mode (-ffp-contract=off), and none of the functions below are
+//             compiled with FMA enabled.
+
+namespace {
+
+// Same semantics as the SSE/AVX max/min instructions, which matters for signed zeros.
+[[nodiscard]] inline auto Max0(const float x) noexcept -> float { return x > 0.F ? x : 0.F; }
+[[nodiscard]] inline auto Min1(const float x) noexcept -> float { return x < 1.F ? x : 1.F; }
+
+// Scalar.
+
+void LoadU8Scalar(const uint8_t *in,
+  float *out,
+  const int n,
+  const float scale,
+  const float offset) noexcept
+{
+  for (int i = 0; i < n; ++i) { out[i] = static_cast<float>(in[i]) * scale + offset; }// NOLINT
+}
+
+void LoadU16Scalar(const uint16_t *in,
+  float *out,
+  const int n,
+  const float scale,
+  const float offset) noexcept
+{
+  for (int i = 0; i < n; ++i) { out[i] = static_cast<float>(in[i]) * scale + offset; }// NOLINT
+}
+
+void BlendScalar(const float *a,
+  const float *b,
+  float *out,
+  const int n,
+  const float wa,
+  const float wb) noexcept
+{
+  for (int i = 0; i < n; ++i) { out[i] = a[i] * wa + b[i] * wb; }// NOLINT
+}
+
+void YuvToRgbScalar(const float *y,
+  const float *u,
+  const float *v,
+  float *r,
+  float *g,
+  float *b,
+  const int n,
+  const convert_internal::YuvToRgbCoeffs &c) noexcept
+{
+  // NOLINTNEXTLINE
+  for (int i = 0; i < n; ++i) {
+    r[i] = Min1(Max0(y[i] + v[i] * c.cr_r));// NOLINT
+    g[i] = Min1(Max0((y[i] + u[i] * c.cb_g) + v[i] * c.cr_g));// NOLINT
+    b[i] = Min1(Max0(y[i] + u[i] * c.cb_b));// NOLINT
+  }
+}
+
+void RgbToYuvScalar(const float *r,
+  const float *g,
+  const float *b,
+  float *y,
+  float *u,
+  float *v,
+  const int n,
+  const convert_internal::RgbToYuvCoeffs &c) noexcept
+{
+  // NOLINTNEXTLINE
+  for (int i = 0; i < n; ++i) {
+    const float rr = Min1(Max0(r[i]));// NOLINT
+    const float gg = Min1(Max0(g[i]));// NOLINT
+    const float bb = Min1(Max0(b[i]));// NOLINT
+    const float yy = (rr * c.kr + gg * c.kg) + bb * c.kb;
+    y[i] = yy;// NOLINT
+    u[i] = (bb - yy) * c.cb_scale;// NOLINT
+    v[i] = (rr - yy) * c.cr_scale;// NOLINT
+  }
+}
+
+// Clamp before rounding, which is equivalent to clamping after rounding since the limits are
+// integers, but avoids overflow when converting to integers.
+[[nodiscard]] inline auto
+  Quantize(const float x, const float scale, const float offset, const float max_value) noexcept
+  -> int
+{
+  const float q = x * scale + offset;
+  return static_cast<int>(std::nearbyint(q > 0.F ? (q < max_value ? q : max_value) : 0.F));
+}
+
+void StoreU8Scalar(const float *in,
+  uint8_t *out,
+  const int n,
+  const float scale,
+  const float offset) noexcept
+{
+  constexpr float kMaxValue = 255.F;
+  // NOLINTNEXTLINE
+  for (int i = 0; i < n; ++i) {
+    out[i] = static_cast<uint8_t>(Quantize(in[i], scale, offset, kMaxValue));// NOLINT
+  }
+}
+
+void StoreU16Scalar(const float *in,
+  uint16_t *out,
+  const int n,
+  const float scale,
+  const float offset,
+  const float max_value) noexcept
+{
+  // NOLINTNEXTLINE
+  for (int i = 0; i < n; ++i) {
+    out[i] = static_cast<uint16_t>(Quantize(in[i], scale, offset, max_value));// NOLINT
+  }
+}
+
+// Same results as the F16C instructions (with the default rounding mode), including NaNs, which
+// are quieted and keep the upper bits of their payload.
+[[nodiscard]] inline auto FloatToHalf1(const float f) noexcept -> uint16_t
+{
+  uint32_t x = 0U;
+  std::memcpy(&x, &f, sizeof(x));
+  const uint32_t sign = (x >> 16U) & 0x8000U;// NOLINT
+  const uint32_t abs_x = x & 0x7fffffffU;// NOLINT
+
+  // NaN, infinity and values that round to infinity, i.e. >= 65520.
+  if (abs_x > 0x7f800000U) {// NOLINT
+    return static_cast<uint16_t>(sign | 0x7e00U | ((abs_x >> 13U) & 0x3ffU));// NOLINT
+  }
+  if (abs_x >= 0x477ff000U) { return static_cast<uint16_t>(sign | 0x7c00U); }// NOLINT
+
+  uint32_t h = 0U;
+  uint32_t rem = 0U;
+  uint32_t halfway = 0U;
+  if (abs_x >= 0x38800000U) {// NOLINT
+    // Normal, re-bias the exponent and drop 13 bits of mantissa.
+    h = (abs_x - 0x38000000U) >> 13U;// NOLINT
+    rem = abs_x & 0x1fffU;// NOLINT
+    halfway = 0x1000U;// NOLINT
+  } else if (abs_x >= 0x33000000U) {// NOLINT
+    // Subnormal, i.e. m * 2^-24.
+    const uint32_t shift = 126U - (abs_x >> 23U);// NOLINT
+    const uint32_t mantissa = (abs_x & 0x7fffffU) | 0x800000U;// NOLINT
+    h = mantissa >> shift;
+    rem = mantissa & ((1U << shift) - 1U);
+    halfway = 1U << (shift - 1U);
+  } else {
+    // Rounds to zero.
+    return static_cast<uint16_t>(sign);
+  }
+
+  // Round half to even, carries into the exponent as needed.
+  if (rem > halfway || (rem == halfway && (h & 1U) != 0U)) { ++h; }
+  return static_cast<uint16_t>(sign | h);
+}
+
+[[nodiscard]] inline auto HalfToFloat1(const uint16_t h) noexcept -> float
+{
+  const uint32_t sign = (h & 0x8000U) << 16U;// NOLINT
+  const uint32_t e = (h >> 10U) & 0x1fU;// NOLINT
+  const uint32_t m = h & 0x3ffU;// NOLINT
+  uint32_t x = 0U;
+  if (e == 0U) {
+    // Zero or subnormal, exact in single precision.
+    constexpr float kSubnormalScale = 1.F / 16777216.F;// 2^-24
+    const float f = static_cast<float>(m) * kSubnormalScale;
+    std::memcpy(&x, &f, sizeof(x));
+    x |= sign;
+  } else if (e == 0x1fU) {// NOLINT
+    // Infinity or (quieted) NaN.
+    x = sign | 0x7f800000U | (m << 13U) | (m != 0U ? 0x400000U : 0U);// NOLINT
+  } else {
+    x = sign | ((e + 112U) << 23U) | (m << 13U);// NOLINT
+  }
+  float f = 0.F;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+void FloatToHalfScalar(const float *in, uint16_t *out, const int n) noexcept
+{
+  for (int i = 0; i < n; ++i) { out[i] = FloatToHalf1(in[i]); }// NOLINT
+}
+
+void HalfToFloatScalar(const uint16_t *in, float *out, const int n) noexcept
+{
+  for (int i = 0; i < n; ++i) { out[i] = HalfToFloat1(in[i]); }// NOLINT
+}
+
+#if ILP_MOVIE_CONVERT_X86
+
+// SSE4.1
+
+__attribute__((target("sse4.1"))) void LoadU8Sse41(const uint8_t *in,
+  float *out,
+  const int n,
+  const float scale,
+  const float offset) noexcept
+{
+  const __m128 s = _mm_set1_ps(scale);
+  const __m128 o = _mm_set1_ps(offset);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    int32_t packed = 0;
+    __builtin_memcpy(&packed, in + i, sizeof(packed));// NOLINT
+    const __m128 x = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)));
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(x, s), o));// NOLINT
+  }
+  LoadU8Scalar(in + i, out + i, n - i, scale, offset);// NOLINT
+}
+
+__attribute__((target("sse4.1"))) void LoadU16Sse41(const uint16_t *in,
+  float *out,
+  const int n,
+  const float scale,
+  const float offset) noexcept
+{
+  const __m128 s = _mm_set1_ps(scale);
+  const __m128 o = _mm_set1_ps(offset);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + i));// NOLINT
+    const __m128 x = _mm_cvtepi32_ps(_mm_cvtepu16_epi32(packed));
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(x, s), o));// NOLINT
+  }
+  LoadU16Scalar(in + i, out + i, n - i, scale, offset);// NOLINT
+}
+
+__attribute__((target("sse4.1"))) void BlendSse41(const float *a,
+  const float *b,
+  float *out,
+  const int n,
+  const float wa,
+  const float wb) noexcept
+{
+  const __m128 va = _mm_set1_ps(wa);
+  const __m128 vb = _mm_set1_ps(wb);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128 x = _mm_mul_ps(_mm_loadu_ps(a + i), va);// NOLINT
+    const __m128 y = _mm_mul_ps(_mm_loadu_ps(b + i), vb);// NOLINT
+    _mm_storeu_ps(out + i, _mm_add_ps(x, y));// NOLINT
+  }
+  BlendScalar(a + i, b + i, out + i, n - i, wa, wb);// NOLINT
+}
+
+__attribute__((target("sse4.1"))) void YuvToRgbSse41(const float *y,
+  const float *u,
+  const float *v,
+  float *r,
+  float *g,
+  float *b,
+  const int n,
+  const convert_internal::YuvToRgbCoeffs &c) noexcept
+{
+  const __m128 cr_r = _mm_set1_ps(c.cr_r);
+  const __m128 cb_g = _mm_set1_ps(c.cb_g);
+  const __m128 cr_g = _mm_set1_ps(c.cr_g);
+  const __m128 cb_b = _mm_set1_ps(c.cb_b);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.F);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128 yy = _mm_loadu_ps(y + i);// NOLINT
+    const __m128 uu = _mm_loadu_ps(u + i);// NOLINT
+    const __m128 vv = _mm_loadu_ps(v + i);// NOLINT
+    const __m128 rr = _mm_add_ps(yy, _mm_mul_ps(vv, cr_r));
+    const __m128 gg = _mm_add_ps(_mm_add_ps(yy, _mm_mul_ps(uu, cb_g)), _mm_mul_ps(vv, cr_g));
+    const __m128 bb = _mm_add_ps(yy, _mm_mul_ps(uu, cb_b));
+    _mm_storeu_ps(r + i, _mm_min_ps(_mm_max_ps(rr, zero), one));// NOLINT
+    _mm_storeu_ps(g + i, _mm_min_ps(_mm_max_ps(gg, zero), one));// NOLINT
+    _mm_storeu_ps(b + i, _mm_min_ps(_mm_max_ps(bb, zero), one));// NOLINT
+  }
+  YuvToRgbScalar(y + i, u + i, v + i, r + i, g + i, b + i, n - i, c);// NOLINT
+}
+
+__attribute__((target("sse4.1"))) void RgbToYuvSse41(const float *r,
+  const float *g,
+  const float *b,
+  float *y,
+  float *u,
+  float *v,
+  const int n,
+  const convert_internal::RgbToYuvCoeffs &c) noexcept
+{
+  const __m128 kr = _mm_set1_ps(c.kr);
+  const __m128 kg = _mm_set1_ps(c.kg);
+  const __m128 kb = _mm_set1_ps(c.kb);
+  const __m128 cb_scale = _mm_set1_ps(c.cb_scale);
+  const __m128 cr_scale = _mm_set1_ps(c.cr_scale);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.F);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128 rr = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(r + i), zero), one);// NOLINT
+    const __m128 gg = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(g + i), zero), one);// NOLINT
+    const __m128 bb = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(b + i), zero), one);// NOLINT
+    const __m128 yy =
+      _mm_add_ps(_mm_add_ps(_mm_mul_ps(rr, kr), _mm_mul_ps(gg, kg)), _mm_mul_ps(bb, kb));
+    _mm_storeu_ps(y + i, yy);// NOLINT
+    _mm_storeu_ps(u + i, _mm_mul_ps(_mm_sub_ps(bb, yy), cb_scale));// NOLINT
+    _mm_storeu_ps(v + i, _mm_mul_ps(_mm_sub_ps(rr, yy), cr_scale));// NOLINT
+  }
+  RgbToYuvScalar(r + i, g + i, b + i, y + i, u + i, v + i, n - i, c);// NOLINT
+}
+
+// Returns 4 rounded and clamped integers.
+[[nodiscard]] __attribute__((target("sse4.1"))) inline auto QuantizeSse41(const __m128 x,
+  const __m128 scale,
+  const __m128 offset,
+  const __m128 max_value) noexcept -> __m128i
+{
+  const __m128 q = _mm_add_ps(_mm_mul_ps(x, scale), offset);
+  return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(q, _mm_setzero_ps()), max_value));
+}
+
+__attribute__((target("sse4.1"))) void StoreU8Sse41(const float *in,
+  uint8_t *out,
+  const int n,
+  const float scale,
+  const float offset) noexcept
+{
+  const __m128 s = _mm_set1_ps(scale);
+  const __m128 o = _mm_set1_ps(offset);
+  const __m128 m = _mm_set1_ps(255.F);// NOLINT
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m128i q = QuantizeSse41(_mm_loadu_ps(in + i), s, o, m);// NOLINT
+    const __m128i q16 = _mm_packus_epi32(q, q);
+    const int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(q16, q16));
+    __builtin_memcpy(out + i, &packed, sizeof(packed));// NOLINT
+  }
+  StoreU8Scalar(in + i, out + i, n - i, scale, offset);// NOLINT
+}
+
+__attribute__((target("sse4.1"))) void StoreU16Sse41(const float *in,
+  uint16_t *out,
+  const int n,
+  const float scale,
+  const float offset,
+  const float max_value) noexcept
+{
+  const __m128 s = _mm_set1_ps(scale);
+  const __m128 o = _mm_set1_ps(offset);
+  const __m128 m = _mm_set1_ps(max_value);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i q0 = QuantizeSse41(_mm_loadu_ps(in + i), s, o, m);// NOLINT
+    const __m128i q1 = QuantizeSse41(_mm_loadu_ps(in + i + 4), s, o, m);// NOLINT
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi32(q0, q1));// NOLINT
+  }
+  StoreU16Scalar(in + i, out + i, n - i, scale, offset, max_value);// NOLINT
+}
+
+// AVX2
+
+__attribute__((target("avx2"))) void LoadU8Avx2(const uint8_t *in,
+  float *out,
+  const int n,
+  const float scale,
+  const float offset) noexcept
+{
+  const __m256 s = _mm256_set1_ps(scale);
+  const __m256 o = _mm256_set1_ps(offset);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + i));// NOLINT
+    const __m256 x = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(packed));
+    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(x, s), o));// NOLINT
+  }
+  LoadU8Scalar(in + i, out + i, n - i, scale, offset);// NOLINT
+}
+
+__attribute__((target("avx2"))) void LoadU16Avx2(const uint16_t *in,
+  float *out,
+  const int n,
+  const float scale,
+  const float offset) noexcept
+{
+  const __m256 s = _mm256_set1_ps(scale);
+  const __m256 o = _mm256_set1_ps(offset);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));// NOLINT
+    const __m256 x = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(packed));
+    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(x, s), o));// NOLINT
+  }
+  LoadU16Scalar(in + i, out + i, n - i, scale, offset);// NOLINT
+}
+
+__attribute__((target("avx2"))) void BlendAvx2(const float *a,
+  const float *b,
+  float *out,
+  const int n,
+  const float wa,
+  const float wb) noexcept
+{
+  const __m256 va = _mm256_set1_ps(wa);
+  const __m256 vb = _mm256_set1_ps(wb);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 x = _mm256_mul_ps(_mm256_loadu_ps(a + i), va);// NOLINT
+    const __m256 y = _mm256_mul_ps(_mm256_loadu_ps(b + i), vb);// NOLINT
+    _mm256_storeu_ps(out + i, _mm256_add_ps(x, y));// NOLINT
+  }
+  BlendScalar(a + i, b + i, out + i, n - i, wa, wb);// NOLINT
+}
+
+__attribute__((target("avx2"))) void YuvToRgbAvx2(const float *y,
+  const float *u,
+  const float *v,
+  float *r,
+  float *g,
+  float *b,
+  const int n,
+  const convert_internal::YuvToRgbCoeffs &c) noexcept
+{
+  const __m256 cr_r = _mm256_set1_ps(c.cr_r);
+  const __m256 cb_g = _mm256_set1_ps(c.cb_g);
+  const __m256 cr_g = _mm256_set1_ps(c.cr_g);
+  const __m256 cb_b = _mm256_set1_ps(c.cb_b);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.F);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 yy = _mm256_loadu_ps(y + i);// NOLINT
+    const __m256 uu = _mm256_loadu_ps(u + i);// NOLINT
+    const __m256 vv = _mm256_loadu_ps(v + i);// NOLINT
+    const __m256 rr = _mm256_add_ps(yy, _mm256_mul_ps(vv, cr_r));
+    const __m256 gg =
+      _mm256_add_ps(_mm256_add_ps(yy, _mm256_mul_ps(uu, cb_g)), _mm256_mul_ps(vv, cr_g));
+    const __m256 bb = _mm256_add_ps(yy, _mm256_mul_ps(uu, cb_b));
+    _mm256_storeu_ps(r + i, _mm256_min_ps(_mm256_max_ps(rr, zero), one));// NOLINT
+    _mm256_storeu_ps(g + i, _mm256_min_ps(_mm256_max_ps(gg, zero), one));// NOLINT
+    _mm256_storeu_ps(b + i, _mm256_min_ps(_mm256_max_ps(bb, zero), one));// NOLINT
+  }
+  YuvToRgbScalar(y + i, u + i, v + i, r + i, g + i, b + i, n - i, c);// NOLINT
+}
+
+__attribute__((target("avx2"))) void RgbToYuvAvx2(const float *r,
+  const float *g,
+  const float *b,
+  float *y,
+  float *u,
+  float *v,
+  const int n,
+  const convert_internal::RgbToYuvCoeffs &c) noexcept
+{
+  const __m256 kr = _mm256_set1_ps(c.kr);
+  const __m256 kg = _mm256_set1_ps(c.kg);
+  const __m256 kb = _mm256_set1_ps(c.kb);
+  const __m256 cb_scale = _mm256_set1_ps(c.cb_scale);
+  const __m256 cr_scale = _mm256_set1_ps(c.cr_scale);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.F);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256 rr = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(r + i), zero), one);// NOLINT
+    const __m256 gg = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(g + i), zero), one);// NOLINT
+    const __m256 bb = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(b + i), zero), one);// NOLINT
+    const __m256 yy = _mm256_add_ps(
+      _mm256_add_ps(_mm256_mul_ps(rr, kr), _mm256_mul_ps(gg, kg)), _mm256_mul_ps(bb, kb));
+    _mm256_storeu_ps(y + i, yy);// NOLINT
+    _mm256_storeu_ps(u + i, _mm256_mul_ps(_mm256_sub_ps(bb, yy), cb_scale));// NOLINT
+    _mm256_storeu_ps(v + i, _mm256_mul_ps(_mm256_sub_ps(rr, yy), cr_scale));// NOLINT
+  }
+  RgbToYuvScalar(r + i, g + i, b + i, y + i, u + i, v + i, n - i, c);// NOLINT
+}
+
+// Returns 8 rounded and clamped integers, packed to unsigned 16-bit.
+[[nodiscard]] __attribute__((target("avx2"))) inline auto QuantizeAvx2(const __m256 x,
+  const __m256 scale,
+  const __m256 offset,
+  const __m256 max_value) noexcept -> __m128i
+{
+  const __m256 q = _mm256_add_ps(_mm256_mul_ps(x, scale), offset);
+  const __m256i qi =
+    _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(q, _mm256_setzero_ps()), max_value));
+  return _mm_packus_epi32(_mm256_castsi256_si128(qi), _mm256_extracti128_si256(qi, 1));
+}
+
+__attribute__((target("avx2"))) void StoreU8Avx2(const float *in,
+  uint8_t *out,
+  const int n,
+  const float scale,
+  const float offset) noexcept
+{
+  const __m256 s = _mm256_set1_ps(scale);
+  const __m256 o = _mm256_set1_ps(offset);
+  const __m256 m = _mm256_set1_ps(255.F);// NOLINT
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i q16 = QuantizeAvx2(_mm256_loadu_ps(in + i), s, o, m);// NOLINT
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(q16, q16));// NOLINT
+  }
+  StoreU8Scalar(in + i, out + i, n - i, scale, offset);// NOLINT
+}
+
+__attribute__((target("avx2"))) void StoreU16Avx2(const float *in,
+  uint16_t *out,
+  const int n,
+  const float scale,
+  const float offset,
+  const float max_value) noexcept
+{
+  const __m256 s = _mm256_set1_ps(scale);
+  const __m256 o = _mm256_set1_ps(offset);
+  const __m256 m = _mm256_set1_ps(max_value);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i q16 = QuantizeAvx2(_mm256_loadu_ps(in + i), s, o, m);// NOLINT
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), q16);// NOLINT
+  }
+  StoreU16Scalar(in + i, out + i, n - i, scale, offset, max_value);// NOLINT
+}
+
+// F16C, which is not implied by AVX2 and must be checked separately, see HasF16c.
+
+__attribute__((target("avx2,f16c"))) void FloatToHalfF16c(const float *in,
+  uint16_t *out,
+  const int n) noexcept
+{
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);// NOLINT
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), h);// NOLINT
+  }
+  FloatToHalfScalar(in + i, out + i, n - i);// NOLINT
+}
+
+__attribute__((target("avx2,f16c"))) void HalfToFloatF16c(const uint16_t *in,
+  float *out,
+  const int n) noexcept
+{
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));// NOLINT
+    _mm256_storeu_ps(out + i, _mm256_cvtph_ps(h));// NOLINT
+  }
+  HalfToFloatScalar(in + i, out + i, n - i);// NOLINT
+}
+
+[[nodiscard]] auto HasF16c() noexcept -> bool
+{
+  static const bool has_f16c = []() {
+    unsigned int eax = 0U;
+    unsigned int ebx = 0U;
+    unsigned int ecx = 0U;
+    unsigned int edx = 0U;
+    return __get_cpuid(1U, &eax, &ebx, &ecx, &edx) != 0 && (ecx & bit_F16C) != 0U;
+  }();
+  return has_f16c;
+}
+
+#endif// ILP_MOVIE_CONVERT_X86
+
+}// namespace
+
+namespace convert_internal {
+
+auto DetectIsa() noexcept -> Isa
+{
+#if ILP_MOVIE_CONVERT_X86
+  static const Isa isa = []() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) { return Isa::kAvx2; }
+    if (__builtin_cpu_supports("sse4.1")) { return Isa::kSse41; }
+    return Isa::kScalar;
+  }();
+  return isa;
+#else
+  return Isa::kScalar;
+#endif
+}
+
+auto ClampIsa(const Isa isa) noexcept -> Isa
+{
+  return static_cast<Isa>(std::min(static_cast<int>(isa), static_cast<int>(DetectIsa())));
+}
+
+void LoadU8(const Isa isa,
+  const uint8_t *in,
+  float *out,
+  const int n,
+  const float scale,
+  const float offset) noexcept
+{
+  switch (isa) {
+#if ILP_MOVIE_CONVERT_X86
+  case Isa::kAvx2:
+    LoadU8Avx2(in, out, n, scale, offset);
+    break;
+  case Isa::kSse41:
+    LoadU8Sse41(in, out, n, scale, offset);
+    break;
+#endif
+  default:
+    LoadU8Scalar(in, out, n, scale, offset);
+    break;
+  }
+}
+
+void LoadU16(const Isa isa,
+  const uint16_t *in,
+  float *out,
+  const int n,
+  const float scale,
+  const float offset) noexcept
+{
+  switch (isa) {
+#if ILP_MOVIE_CONVERT_X86
+  case Isa::kAvx2:
+    LoadU16Avx2(in, out, n, scale, offset);
+    break;
+  case Isa::kSse41:
+    LoadU16Sse41(in, out, n, scale, offset);
+    break;
+#endif
+  default:
+    LoadU16Scalar(in, out, n, scale, offset);
+    break;
+  }
+}
+
+void Blend(const Isa isa,
+  const float *a,
+  const float *b,
+  float *out,
+  const int n,
+  const float wa,
+  const float wb) noexcept
+{
+  switch (isa) {
+#if ILP_MOVIE_CONVERT_X86
+  case Isa::kAvx2:
+    BlendAvx2(a, b, out, n, wa, wb);
+    break;
+  case Isa::kSse41:
+    BlendSse41(a, b, out, n, wa, wb);
+    break;
+#endif
+  default:
+    BlendScalar(a, b, out, n, wa, wb);
+    break;
+  }
+}
+
+void UpsampleH2(const float *in, float *out, const int n) noexcept
+{
+  if (n <= 0) { return; }
+  const int last = (n + 1) / 2 - 1;
+  for (int x = 0; x < n; ++x) {
+    const int k = x >> 1;// NOLINT
+    // NOLINTNEXTLINE
+    out[x] = (x & 1) == 0 ? in[k] : (in[k] + in[std::min(k + 1, last)]) * 0.5F;
+  }
+}
+
+auto MakeYuvToRgbCoeffs(const double kr, const double kb) noexcept -> YuvToRgbCoeffs
+{
+  const double kg = 1.0 - kr - kb;
+  YuvToRgbCoeffs c{};
+  c.cr_r = static_cast<float>(2.0 * (1.0 - kr));
+  c.cb_g = static_cast<float>(-2.0 * kb * (1.0 - kb) / kg);
+  c.cr_g = static_cast<float>(-2.0 * kr * (1.0 - kr) / kg);
+  c.cb_b = static_cast<float>(2.0 * (1.0 - kb));
+  return c;
+}
+
+void YuvToRgb(const Isa isa,
+  const float *y,
+  const float *u,
+  const float *v,
+  float *r,
+  float *g,
+  float *b,
+  const int n,
+  const YuvToRgbCoeffs &c) noexcept
+{
+  switch (isa) {
+#if ILP_MOVIE_CONVERT_X86
+  case Isa::kAvx2:
+    YuvToRgbAvx2(y, u, v, r, g, b, n, c);
+    break;
+  case Isa::kSse41:
+    YuvToRgbSse41(y, u, v, r, g, b, n, c);
+    break;
+#endif
+  default:
+    YuvToRgbScalar(y, u, v, r, g, b, n, c);
+    break;
+  }
+}
+
+auto MakeRgbToYuvCoeffs(const double kr, const double kb) noexcept -> RgbToYuvCoeffs
+{
+  RgbToYuvCoeffs c{};
+  c.kr = static_cast<float>(kr);
+  c.kg = static_cast<float>(1.0 - kr - kb);
+  c.kb = static_cast<float>(kb);
+  c.cb_scale = static_cast<float>(0.5 / (1.0 - kb));
+  c.cr_scale = static_cast<float>(0.5 / (1.0 - kr));
+  return c;
+}
+
+void RgbToYuv(const Isa isa,
+  const float *r,
+  const float *g,
+  const float *b,
+  float *y,
+  float *u,
+  float *v,
+  const int n,
+  const RgbToYuvCoeffs &c) noexcept
+{
+  switch (isa) {
+#if ILP_MOVIE_CONVERT_X86
+  case Isa::kAvx2:
+    RgbToYuvAvx2(r, g, b, y, u, v, n, c);
+    break;
+  case Isa::kSse41:
+    RgbToYuvSse41(r, g, b, y, u, v, n, c);
+    break;
+#endif
+  default:
+    RgbToYuvScalar(r, g, b, y, u, v, n, c);
+    break;
+  }
+}
+
+void DownsampleH2(const float *in, float *out, const int n) noexcept
+{
+  if (n <= 0) { return; }
+  const int cn = (n + 1) / 2;
+  for (int k = 0; k < cn; ++k) {
+    const int x = 2 * k;
+    // NOLINTNEXTLINE
+    out[k] = ((in[std::max(x - 1, 0)] + in[x] * 2.F) + in[std::min(x + 1, n - 1)]) * 0.25F;
+  }
+}
+
+void StoreU8(const Isa isa,
+  const float *in,
+  uint8_t *out,
+  const int n,
+  const float scale,
+  const float offset) noexcept
+{
+  switch (isa) {
+#if ILP_MOVIE_CONVERT_X86
+  case Isa::kAvx2:
+    StoreU8Avx2(in, out, n, scale, offset);
+    break;
+  case Isa::kSse41:
+    StoreU8Sse41(in, out, n, scale, offset);
+    break;
+#endif
+  default:
+    StoreU8Scalar(in, out, n, scale, offset);
+    break;
+  }
+}
+
+void StoreU16(const Isa isa,
+  const float *in,
+  uint16_t *out,
+  const int n,
+  const float scale,
+  const float offset,
+  const int max_value) noexcept
+{
+  const auto m = static_cast<float>(max_value);
+  switch (isa) {
+#if ILP_MOVIE_CONVERT_X86
+  case Isa::kAvx2:
+    StoreU16Avx2(in, out, n, scale, offset, m);
+    break;
+  case Isa::kSse41:
+    StoreU16Sse41(in, out, n, scale, offset, m);
+    break;
+#endif
+  default:
+    StoreU16Scalar(in, out, n, scale, offset, m);
+    break;
+  }
+}
+
+void FloatToHalf(const Isa isa, const float *in, uint16_t *out, const int n) noexcept
+{
+#if ILP_MOVIE_CONVERT_X86
+  if (isa == Isa::kAvx2 && HasF16c()) {
+    FloatToHalfF16c(in, out, n);
+    return;
+  }
+#endif
+  static_cast<void>(isa);
+  FloatToHalfScalar(in, out, n);
+}
+
+void HalfToFloat(const Isa isa, const uint16_t *in, float *out, const int n) noexcept
+{
+#if ILP_MOVIE_CONVERT_X86
+  if (isa == Isa::kAvx2 && HasF16c()) {
+    HalfToFloatF16c(in, out, n);
+    return;
+  }
+#endif
+  static_cast<void>(isa);
+  HalfToFloatScalar(in, out, n);
+}
+
+}// namespace convert_internal
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>// uint8_t, uint16_t
+
+#include <ilp_movie/ilp_movie_export.hpp>// ILP_MOVIE_NO_EXPORT
+
+// Row kernels used for pixel format conversions. These do not depend on libav.
+//
+// All kernels exist in a scalar version and, on x86, SSE4.1 and AVX2 versions that are selected at
+// runtime. The vectorized kernels use the exact same sequence of (single precision) multiplications
+// and additions as the scalar kernels, without fused multiply-add, so that the results are
+// bit-exact regardless of the instruction set being used.
+namespace convert_internal {
+
+enum class Isa { kScalar = 0, kSse41 = 1, kAvx2 = 2 };
+
+// Returns the best instruction set supported by the running CPU.
+[[nodiscard]] ILP_MOVIE_NO_EXPORT auto DetectIsa() noexcept -> Isa;
+
+// Returns the given instruction set if it is supported by the running CPU, otherwise the best
+// supported instruction set that is "lower" than the requested one.
+[[nodiscard]] ILP_MOVIE_NO_EXPORT auto ClampIsa(Isa isa) noexcept -> Isa;
+
+// out[i] = float(in[i]) * scale + offset
+ILP_MOVIE_NO_EXPORT void
+  LoadU8(Isa isa, const uint8_t *in, float *out, int n, float scale, float offset) noexcept;
+ILP_MOVIE_NO_EXPORT void
+  LoadU16(Isa isa, const uint16_t *in, float *out, int n, float scale, float offset) noexcept;
+
+// out[i] = a[i] * wa + b[i] * wb
+//
+// The output may alias either of the inputs.
+ILP_MOVIE_NO_EXPORT void
+  Blend(Isa isa, const float *a, const float *b, float *out, int n, float wa, float wb) noexcept;
+
+// Horizontal 2x upsampling of co-sited chroma samples (MPEG-2/H.264 "left" siting), i.e.
+//
+//   out[2k]   = in[k]
+//   out[2k+1] = (in[k] + in[k+1]) * 0.5
+//
+// where the last input sample is repeated at the right edge. The input has (n + 1) / 2 samples.
+ILP_MOVIE_NO_EXPORT void UpsampleH2(const float *in, float *out, int n) noexcept;
+
+// Coefficients for converting normalized Y'CbCr, where Y' is in [0, 1] and Cb/Cr are in
+// [-0.5, 0.5], to R'G'B'.
+struct YuvToRgbCoeffs
+{
+  float cr_r = 0.F;
+  float cb_g = 0.F;
+  float cr_g = 0.F;
+  float cb_b = 0.F;
+};
+
+// Returns coefficients for the given luma weights, e.g. kr = 0.2126, kb = 0.0722 for BT.709.
+[[nodiscard]] ILP_MOVIE_NO_EXPORT auto MakeYuvToRgbCoeffs(double kr, double kb) noexcept
+  -> YuvToRgbCoeffs;
+
+// r[i] = clamp(y[i] + v[i] * cr_r, 0, 1)
+// g[i] = clamp(y[i] + u[i] * cb_g + v[i] * cr_g, 0, 1)
+// b[i] = clamp(y[i] + u[i] * cb_b, 0, 1)
+//
+// Output is clamped to [0, 1] to match libswscale.
+ILP_MOVIE_NO_EXPORT void YuvToRgb(Isa isa,
+  const float *y,
+  const float *u,
+  const float *v,
+  float *r,
+  float *g,
+  float *b,
+  int n,
+  const YuvToRgbCoeffs &c) noexcept;
+
+// Coefficients for converting R'G'B' to normalized Y'CbCr, where Y' is in [0, 1] and Cb/Cr are in
+// [-0.5, 0.5].
+struct RgbToYuvCoeffs
+{
+  float kr = 0.F;
+  float kg = 0.F;
+  float kb = 0.F;
+  float cb_scale = 0.F;
+  float cr_scale = 0.F;
+};
+
+// Returns coefficients for the given luma weights, e.g. kr = 0.2126, kb = 0.0722 for BT.709.
+[[nodiscard]] ILP_MOVIE_NO_EXPORT auto MakeRgbToYuvCoeffs(double kr, double kb) noexcept
+  -> RgbToYuvCoeffs;
+
+// Input is first clamped to [0, 1], same as libswscale does for float input, then:
+//
+// y[i] = r[i] * kr + g[i] * kg + b[i] * kb
+// u[i] = (b[i] - y[i]) * cb_scale
+// v[i] = (r[i] - y[i]) * cr_scale
+ILP_MOVIE_NO_EXPORT void RgbToYuv(Isa isa,
+  const float *r,
+  const float *g,
+  const float *b,
+  float *y,
+  float *u,
+  float *v,
+  int n,
+  const RgbToYuvCoeffs &c) noexcept;
+
+// Horizontal 2:1 downsampling to co-sited chroma positions (MPEG-2/H.264 "left" siting) using a
+// [1 2 1] / 4 filter, where edge samples are repeated. The output has (n + 1) / 2 samples.
+ILP_MOVIE_NO_EXPORT void DownsampleH2(const float *in, float *out, int n) noexcept;
+
+// out[i] = clamp(round(in[i] * scale + offset), 0, max_value)
+//
+// Rounds half to even, i.e. the default floating point rounding mode.
+ILP_MOVIE_NO_EXPORT void
+  StoreU8(Isa isa, const float *in, uint8_t *out, int n, float scale, float offset) noexcept;
+ILP_MOVIE_NO_EXPORT void StoreU16(Isa isa,
+  const float *in,
+  uint16_t *out,
+  int n,
+  float scale,
+  float offset,
+  int max_value) noexcept;
+
+// out[i] = half(in[i]) and out[i] = float(in[i]) respectively, where half precision (IEEE 754
+// binary16) values are stored as uint16_t. Rounds half to even.
+//
+// The AVX2 versions use F16C instructions, if supported by the CPU, otherwise the scalar versions
+// are used. There are no SSE4.1 versions.
+ILP_MOVIE_NO_EXPORT void FloatToHalf(Isa isa, const float *in, uint16_t *out, int n) noexcept;
+ILP_MOVIE_NO_EXPORT void HalfToFloat(Isa isa, const uint16_t *in, float *out, int n) noexcept;
+
+}// namespace convert_internal
@@ -185,6 +185,18 @@ public:
     return exit_func(/*success=*/true);
   }
 
+  [[nodiscard]] auto Output() const noexcept -> std::optional<FilterGraphOutput>
+  {
+    if (_buffersink_ctx == nullptr) { return std::nullopt; }
+
+    FilterGraphOutput out{};
+    out.width = av_buffersink_get_w(_buffersink_ctx);
+    out.height = av_buffersink_get_h(_buffersink_ctx);
+    out.pix_fmt = static_cast<AVPixelFormat>(av_buffersink_get_format(_buffersink_ctx));
+    out.sample_aspect_ratio = av_buffersink_get_sample_aspect_ratio(_buffersink_ctx);
+    return out;
+  }
+
   [[nodiscard]] auto FilterFrames(AVFrame *in_frame,
     const std::function<bool(AVFrame *)> &filter_func) const noexcept -> bool
   {
@@ -255,6 +267,11 @@ auto FilterGraph::SetDescription(const FilterGraphDescription &descr) noexcept -
   return Pimpl()->SetDescription(descr);
 }
 
+auto FilterGraph::Output() const noexcept -> std::optional<FilterGraphOutput>
+{
+  return Pimpl()->Output();
+}
+
 auto FilterGraph::FilterFrames(AVFrame *const in_frame,
   const std::function<bool(AVFrame *)> &filter_func) const noexcept -> bool
 {
@@ -2,6 +2,7 @@
 
 #include <functional>// std::function
 #include <memory>// std::unique_ptr
+#include <optional>// std::optional
 #include <string>// std::string
 
 // clang-format off
@@ -40,6 +41,15 @@ struct FilterGraphDescription
   } out;
 };
 
+// Properties of the frames pulled from a configured filter graph.
+struct FilterGraphOutput
+{
+  int width = -1;
+  int height = -1;
+  AVPixelFormat pix_fmt = AV_PIX_FMT_NONE;
+  AVRational sample_aspect_ratio = { /*.num=*/0, /*.den=*/1 };
+};
+
 class FilterGraphImpl;
 class ILP_MOVIE_NO_EXPORT FilterGraph
 {
@@ -57,6 +67,11 @@ public:
 
   [[nodiscard]] auto SetDescription(const FilterGraphDescription &descr) noexcept -> bool;
 
+  // Returns the properties of the output link, as negotiated when the graph was configured, i.e.
+  // without having to push any frames through the graph. Returns null if no description has
+  // been set.
+  [[nodiscard]] auto Output() const noexcept -> std::optional<FilterGraphOutput>;
+
   [[nodiscard]] auto FilterFrames(AVFrame *in_frame,
     const std::function<bool(AVFrame *)> &filter_func) const noexcept -> bool;
 
@@ -0,0 +1,243 @@
+#include "internal/parallel.hpp"
+
+#include <ilp_movie/parallel.hpp>
+
+#include <algorithm>// std::fill, std::max, std::min
+#include <atomic>// std::atomic
+#include <condition_variable>// std::condition_variable
+#include <deque>// std::deque
+#include <memory>// std::make_shared, std::shared_ptr
+#include <mutex>// std::mutex, std::lock_guard, std::unique_lock
+#include <thread>// std::thread
+#include <utility>// std::move
+#include <vector>// std::vector
+
+namespace {
+
+class ThreadPool
+{
+public:
+  [[nodiscard]] static auto Instance() noexcept -> ThreadPool &
+  {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  // Not copyable or movable.
+  ThreadPool(const ThreadPool &rhs) = delete;
+  ThreadPool &operator=(const ThreadPool &rhs) = delete;
+  ThreadPool(ThreadPool &&rhs) = delete;
+  ThreadPool &operator=(ThreadPool &&rhs) = delete;
+
+  [[nodiscard]] auto WorkerCount() const noexcept -> int
+  {
+    return static_cast<int>(_workers.size());
+  }
+
+  // Returns false, without queuing the job, if the job cannot be queued.
+  [[nodiscard]] auto Submit(std::function<void()> job) noexcept -> bool
+  {
+    try {
+      std::lock_guard<std::mutex> lock{ _mutex };
+      _jobs.push_back(std::move(job));
+    } catch (...) {
+      return false;
+    }
+    _cv.notify_one();
+    return true;
+  }
+
+private:
+  ThreadPool() noexcept
+  {
+    // The calling thread always participates, so one less worker than there are cores.
+    const int worker_count = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1) - 1;
+    try {
+      _workers.reserve(static_cast<std::size_t>(worker_count));
+      for (int i = 0; i < worker_count; ++i) {
+        _workers.emplace_back([this]() { _Run(); });
+      }
+    } catch (...) {
+      // Run with the workers we managed to start, possibly none.
+    }
+  }
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock{ _mutex };
+      _stop = true;
+    }
+    _cv.notify_all();
+    for (auto &&w : _workers) { w.join(); }
+  }
+
+  void _Run() noexcept
+  {
+    while (true) {
+      std::function<void()> job;
+      {
+        std::unique_lock<std::mutex> lock{ _mutex };
+        _cv.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+        if (_jobs.empty()) { return; }// Stopped.
+        job = std::move(_jobs.front());
+        _jobs.pop_front();
+      }
+      job();
+    }
+  }
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::deque<std::function<void()>> _jobs;
+  std::vector<std::thread> _workers;
+  bool _stop = false;
+};
+
+// Parallel-for implementation provided by the host application, see ilp_movie::SetParallelFor.
+struct ExternalParallelFor
+{
+  ilp_movie::ParallelForFunc parallel_for;
+  int concurrency = 1;
+};
+
+std::mutex external_mutex;
+std::shared_ptr<const ExternalParallelFor> external_parallel_for;
+
+[[nodiscard]] auto GetExternalParallelFor() noexcept -> std::shared_ptr<const ExternalParallelFor>
+{
+  std::lock_guard<std::mutex> lock{ external_mutex };
+  return external_parallel_for;
+}
+
+}// namespace
+
+namespace ilp_movie {
+
+void SetParallelFor(const ParallelForFunc &parallel_for, const int concurrency) noexcept
+{
+  std::shared_ptr<const ExternalParallelFor> p;
+  if (parallel_for) {
+    try {
+      p = std::make_shared<const ExternalParallelFor>(
+        ExternalParallelFor{ parallel_for, std::max(concurrency, 1) });
+    } catch (...) {
+      // Keep using the built-in thread pool.
+      return;
+    }
+  }
+  std::lock_guard<std::mutex> lock{ external_mutex };
+  external_parallel_for = std::move(p);
+}
+
+}// namespace ilp_movie
+
+namespace parallel_internal {
+
+void ParallelFor(const int begin,
+  const int end,
+  const int grain_size,
+  const std::function<void(int, int)> &func) noexcept
+{
+  if (!(begin < end)) { return; }
+
+  const int grain = std::max(grain_size, 1);
+  if (const auto external = GetExternalParallelFor(); external != nullptr) {
+    // Elements are marked once processed, so that if the external implementation fails part way
+    // through only the remaining elements are processed, here. Processing elements twice is not
+    // harmless, e.g. decoding a slice twice. Sub-ranges never overlap, and the external
+    // implementation has finished running func when it returns or throws.
+    std::vector<unsigned char> processed;
+    try {
+      processed.resize(static_cast<std::size_t>(end - begin));
+    } catch (...) {
+      func(begin, end);
+      return;
+    }
+    try {
+      external->parallel_for(begin, end, grain, [&](const int range_begin, const int range_end) {
+        func(range_begin, range_end);
+        std::fill(processed.begin() + (range_begin - begin),
+          processed.begin() + (range_end - begin),
+          static_cast<unsigned char>(1U));
+      });
+      return;
+    } catch (...) {
+      // Process the remaining elements below.
+    }
+    for (int i = begin; i < end;) {
+      if (processed[static_cast<std::size_t>(i - begin)] != 0U) {
+        ++i;
+        continue;
+      }
+      int j = i + 1;
+      while (j < end && processed[static_cast<std::size_t>(j - begin)] == 0U) { ++j; }
+      func(i, j);
+      i = j;
+    }
+    return;
+  }
+
+  const int chunk_count = (end - begin + grain - 1) / grain;
+  auto &pool = ThreadPool::Instance();
+  const int helper_count = std::min(chunk_count - 1, pool.WorkerCount());
+  if (helper_count <= 0) {
+    func(begin, end);
+    return;
+  }
+
+  struct State
+  {
+    std::atomic<int> next_chunk = 0;
+    std::atomic<int> done_count = 0;
+    std::mutex mutex;
+    std::condition_variable cv;
+  };
+  auto state = std::make_shared<State>();
+
+  // Helpers that start after all chunks have been claimed return immediately without touching
+  // func, which may then already be out of scope.
+  const auto work = [state, &func, begin, end, grain, chunk_count]() {
+    int done = 0;
+    for (int i = state->next_chunk++; i < chunk_count; i = state->next_chunk++) {
+      const int b = begin + i * grain;
+      func(b, std::min(b + grain, end));
+      ++done;
+    }
+    if (done > 0 && state->done_count.fetch_add(done) + done == chunk_count) {
+      std::lock_guard<std::mutex> lock{ state->mutex };
+      state->cv.notify_all();
+    }
+  };
+
+  // Chunks that no helper could be queued for are processed by the calling thread. Copying the
+  // job into a std::function may fail too.
+  for (int i = 0; i < helper_count; ++i) {
+    try {
+      if (!pool.Submit(work)) { break; }
+    } catch (...) {
+      break;
+    }
+  }
+  work();
+
+  std::unique_lock<std::mutex> lock{ state->mutex };
+  state->cv.wait(lock, [&]() { return state->done_count.load() == chunk_count; });
+}
+
+auto Submit(std::function<void()> job) noexcept -> bool
+{
+  auto &pool = ThreadPool::Instance();
+  if (pool.WorkerCount() <= 0) { return false; }
+  return pool.Submit(std::move(job));
+}
+
+auto Concurrency() noexcept -> int
+{
+  if (const auto external = GetExternalParallelFor(); external != nullptr) {
+    return external->concurrency;
+  }
+  return ThreadPool::Instance().WorkerCount() + 1;
+}
+
+}// namespace parallel_internal
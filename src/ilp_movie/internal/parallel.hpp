@@ -0,0 +1,29 @@
+#pragma once
+
+#include <functional>// std::function
+
+#include <ilp_movie/ilp_movie_export.hpp>// ILP_MOVIE_NO_EXPORT
+
+namespace parallel_internal {
+
+// Invokes func(range_begin, range_end) for consecutive sub-ranges of [begin, end), each spanning at
+// most grain_size elements. The sub-ranges are distributed over a small pool of worker threads that
+// is shared by the library, or handed to the implementation set with ilp_movie::SetParallelFor.
+// The calling thread also processes sub-ranges, so nested calls cannot deadlock. Returns when all
+// sub-ranges have been processed.
+//
+// NOTE: func must not throw.
+ILP_MOVIE_NO_EXPORT void ParallelFor(int begin,
+  int end,
+  int grain_size,
+  const std::function<void(int, int)> &func) noexcept;
+
+// Runs job on a worker thread of the pool shared by the library, see ParallelFor. Returns false,
+// without running the job, if the pool has no worker threads or the job cannot be queued, in
+// which case the caller may run the job itself.
+[[nodiscard]] ILP_MOVIE_NO_EXPORT auto Submit(std::function<void()> job) noexcept -> bool;
+
+// Number of threads that may execute sub-ranges concurrently, including the calling thread.
+[[nodiscard]] ILP_MOVIE_NO_EXPORT auto Concurrency() noexcept -> int;
+
+}// namespace parallel_internal
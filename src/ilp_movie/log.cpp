@@ -1,8 +1,18 @@
 #include <ilp_movie/log.hpp>
 
 #include <array>// std::array
+#include <atomic>// std::atomic
+#include <chrono>// std::chrono::milliseconds
+#include <condition_variable>// std::condition_variable
+#include <cstddef>// std::ptrdiff_t, std::size_t
+#include <cstdio>// std::snprintf
+#include <cstring>// std::memcpy, std::strlen
+#include <memory>// std::unique_ptr, std::make_unique
 #include <mutex>// std::mutex, std::scoped_lock
 #include <sstream>// std::ostringstream
+#include <string>// std::string
+#include <string_view>// std::string_view
+#include <thread>// std::thread
 
 // clang-format off
 extern "C" {
@@ -57,32 +67,308 @@ static std::function<void(int, const char *)> IlpLogCallback =
   return av_level;
 }
 
+// Messages are formatted into a buffer of this size, longer messages are truncated.
+constexpr int kLineSize = 1024;
+
+namespace {
+
+// Collapses repeated warnings and errors, so that a codec reporting the same problem for every
+// packet doesn't flood the log. Only complete lines are compared, since libav builds lines from
+// several fragments. Must be called with the mutex locked.
+class RepeatFilter
+{
+public:
+  void Deliver(const int level, const char *msg) noexcept
+  {
+    const std::string_view line{ msg };
+    const bool complete =
+      level <= ilp_movie::LogLevel::kWarning && !line.empty() && line.back() == '\n';
+    if (complete && _has_last && level == _last_level && line == _last_line) {
+      ++_repeat_count;
+      return;
+    }
+    Flush();
+    IlpLogCallback(level, msg);
+    _has_last = false;
+    if (complete && line.size() < _last_line.max_size()) {
+      try {
+        _last_line.assign(line);
+        _last_level = level;
+        _has_last = true;
+      } catch (...) {// NOLINT
+        // Don't collapse this line.
+      }
+    }
+  }
+
+  // Report lines that have been collapsed since they were last delivered.
+  void Flush() noexcept
+  {
+    if (_repeat_count == 0) { return; }
+    std::array<char, 128> summary = {};// NOLINT
+    std::snprintf(summary.data(),// NOLINT
+      summary.size(),
+      "    Last message repeated %d times\n",
+      _repeat_count);
+    _repeat_count = 0;
+    IlpLogCallback(_last_level, summary.data());
+  }
+
+private:
+  std::string _last_line;
+  int _last_level = 0;
+  bool _has_last = false;
+  int _repeat_count = 0;
+};
+
+}// namespace
+
+static RepeatFilter repeat_filter;
+
+// Delivers a message to the user-provided logger. Must be called with the mutex locked.
+static void DeliverLocked(const int level, const char *msg) noexcept
+{
+  repeat_filter.Deliver(level, msg);
+}
+
+namespace {
+
+// Messages queued by the threads that log them and delivered to the user-provided logger on a
+// background thread, so that decoding threads never wait for each other, or for the logger,
+// when logging. The queue is a bounded, lock-free multiple producer single consumer ring buffer.
+class AsyncLog
+{
+public:
+  AsyncLog() noexcept = default;
+
+  ~AsyncLog()
+  {
+    {
+      std::lock_guard<std::mutex> lock{ _wake_mutex };
+      _stop = true;
+    }
+    _wake_cv.notify_one();
+    if (_sink.joinable()) { _sink.join(); }
+
+    // Deliver anything logged after the sink stopped.
+    std::scoped_lock lock{ mutex };
+    _Drain();
+    repeat_filter.Flush();
+  }
+
+  // Not copyable or movable.
+  AsyncLog(const AsyncLog &rhs) = delete;
+  AsyncLog &operator=(const AsyncLog &rhs) = delete;
+  AsyncLog(AsyncLog &&rhs) = delete;
+  AsyncLog &operator=(AsyncLog &&rhs) = delete;
+
+  [[nodiscard]] auto Enabled() const noexcept -> bool
+  {
+    return _enabled.load(std::memory_order_acquire);
+  }
+
+  void SetEnabled(const bool enabled) noexcept
+  {
+    if (enabled) {
+      std::lock_guard<std::mutex> lock{ _wake_mutex };
+      if (!_sink.joinable()) {
+        try {
+          _sink = std::thread{ [this]() { _Run(); } };
+        } catch (...) {
+          // Keep logging synchronously.
+          return;
+        }
+        _sink_id = _sink.get_id();
+        _started.store(true, std::memory_order_release);
+      }
+    }
+    _enabled.store(enabled, std::memory_order_release);
+    if (!enabled) { Flush(); }
+  }
+
+  // Returns false if the message could not be queued, in which case the caller should deliver
+  // it synchronously or drop it.
+  [[nodiscard]] auto Push(const int level, const char *msg) noexcept -> bool
+  {
+    const std::size_t len = std::strlen(msg);
+    if (len >= static_cast<std::size_t>(kLineSize)) { return false; }
+
+    std::size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    while (true) {
+      slot = &_slots[pos & kMask];// NOLINT
+      const std::size_t seq = slot->seq.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+      if (diff == 0) {
+        if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // Full.
+        _dropped.fetch_add(1U, std::memory_order_relaxed);
+        return false;
+      } else {
+        pos = _enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    slot->level = level;
+    std::memcpy(slot->text.data(), msg, len + 1);
+    slot->seq.store(pos + 1, std::memory_order_release);
+
+    // The sink polls while idle, so a missed wake-up only delays delivery.
+    if (_sleeping.load(std::memory_order_relaxed)) { _wake_cv.notify_one(); }
+    return true;
+  }
+
+  // Blocks until all messages queued before the call have been delivered.
+  void Flush() noexcept
+  {
+    if (!_started.load(std::memory_order_acquire) || std::this_thread::get_id() == _sink_id) {
+      return;
+    }
+    const std::size_t target = _enqueue_pos.load(std::memory_order_acquire);
+    _wake_cv.notify_one();
+    std::unique_lock<std::mutex> lock{ _wake_mutex };
+    _flushed_cv.wait(lock, [&]() {
+      return _stop || _delivered.load(std::memory_order_acquire) >= target;
+    });
+    lock.unlock();
+
+    std::scoped_lock cb_lock{ mutex };
+    repeat_filter.Flush();
+  }
+
+private:
+  static constexpr std::size_t kCapacity = 512U;
+  static constexpr std::size_t kMask = kCapacity - 1U;
+  static_assert((kCapacity & kMask) == 0U, "Capacity must be a power of two");
+
+  struct Slot
+  {
+    std::atomic<std::size_t> seq{ 0U };
+    int level = 0;
+    std::array<char, kLineSize> text = {};
+  };
+
+  [[nodiscard]] static auto _MakeSlots() noexcept -> std::unique_ptr<Slot[]>// NOLINT
+  {
+    auto slots = std::make_unique<Slot[]>(kCapacity);// NOLINT
+    for (std::size_t i = 0U; i < kCapacity; ++i) {
+      slots[i].seq.store(i, std::memory_order_relaxed);// NOLINT
+    }
+    return slots;
+  }
+
+  // Delivers the queued messages. Must be called with the mutex locked, and only from a single
+  // thread at a time.
+  auto _Drain() noexcept -> bool
+  {
+    bool delivered = false;
+    while (true) {
+      Slot &slot = _slots[_dequeue_pos & kMask];// NOLINT
+      if (slot.seq.load(std::memory_order_acquire) != _dequeue_pos + 1) { break; }
+      DeliverLocked(slot.level, slot.text.data());
+      slot.seq.store(_dequeue_pos + kCapacity, std::memory_order_release);
+      ++_dequeue_pos;
+      delivered = true;
+    }
+    if (const std::size_t dropped = _dropped.exchange(0U, std::memory_order_relaxed);
+        dropped > 0U) {
+      std::array<char, 128> summary = {};// NOLINT
+      std::snprintf(summary.data(),// NOLINT
+        summary.size(),
+        "Dropped %zu log messages, the log queue was full\n",
+        dropped);
+      DeliverLocked(ilp_movie::LogLevel::kWarning, summary.data());
+    }
+    _delivered.store(_dequeue_pos, std::memory_order_release);
+    return delivered;
+  }
+
+  void _Run() noexcept
+  {
+    // Poll interval while idle, bounds the delay caused by a missed wake-up.
+    constexpr auto kIdleWait = std::chrono::milliseconds(10);
+    while (true) {
+      {
+        std::scoped_lock lock{ mutex };
+        _Drain();
+      }
+      std::unique_lock<std::mutex> lock{ _wake_mutex };
+      _flushed_cv.notify_all();
+      if (_stop) { return; }
+      _sleeping.store(true, std::memory_order_relaxed);
+      _wake_cv.wait_for(lock, kIdleWait, [this]() { return _stop || !_Empty(); });
+      _sleeping.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  [[nodiscard]] auto _Empty() const noexcept -> bool
+  {
+    const Slot &slot = _slots[_dequeue_pos & kMask];// NOLINT
+    return slot.seq.load(std::memory_order_acquire) != _dequeue_pos + 1;
+  }
+
+  std::unique_ptr<Slot[]> _slots = _MakeSlots();// NOLINT
+  std::atomic<std::size_t> _enqueue_pos{ 0U };
+  std::atomic<std::size_t> _dropped{ 0U };
+  std::atomic<bool> _enabled{ false };
+  std::atomic<bool> _sleeping{ false };
+
+  // Only accessed by the consumer, i.e. the sink, or when the sink has stopped.
+  std::size_t _dequeue_pos = 0U;
+  std::atomic<std::size_t> _delivered{ 0U };
+
+  std::mutex _wake_mutex;
+  std::condition_variable _wake_cv;
+  std::condition_variable _flushed_cv;
+  bool _stop = false;
+  std::thread _sink;
+  std::thread::id _sink_id;
+  std::atomic<bool> _started{ false };
+};
+
+}// namespace
+
+static AsyncLog async_log;
+
+// Delivers a message, either by queuing it or synchronously.
+static void Log(const int level, const char *msg) noexcept
+{
+  if (async_log.Enabled()) {
+    if (async_log.Push(level, msg)) { return; }
+
+    // Messages that don't fit in the queue are only delivered if they are important.
+    if (level > ilp_movie::LogLevel::kError && std::strlen(msg) < kLineSize) { return; }
+  }
+  std::scoped_lock lock{ mutex };
+  DeliverLocked(level, msg);
+}
+
 // Hook into the av_log calls so that we can pass a string to a user-provided logger.
 // Needs to be thread-safe!
 static void IlpMovieAvLogCallback(void *ptr, int av_level, const char *fmt, va_list vl) noexcept
 {
-  /*static*/ constexpr int kLineSize = 1024;
-  /*static*/ std::array<char, kLineSize> line = {};
-  /*static*/ int print_prefix = 1;
-
-  // Filter messages based on log level. We can do this before locking the mutex.
+  // Filter messages based on log level, before doing any formatting.
   if (av_level > av_log_get_level()) { return; }
 
-  std::scoped_lock lock{ mutex };
+  // Each thread formats its own messages, so threads never wait for each other here. Whether
+  // to print a prefix depends on if the previous message from the thread ended a line.
+  thread_local std::array<char, kLineSize> line = {};
+  thread_local int print_prefix = 1;
+
   const int ret =
     av_log_format_line2(ptr, av_level, fmt, vl, line.data(), kLineSize, &print_prefix);
-
-  // Don't call LogMsg below, since we have already locked the mutex above.
   if (ret < 0) {
-    IlpLogCallback(ilp_movie::LogLevel::kError, "Error in av_log_format_line2");
+    Log(ilp_movie::LogLevel::kError, "Error in av_log_format_line2");
     return;
   } else if (!(ret < kLineSize)) {
-    IlpLogCallback(ilp_movie::LogLevel::kError, "Truncated log message");
+    Log(ilp_movie::LogLevel::kError, "Truncated log message");
     return;
   }
 
   // Send raw message from libav to callback, don't add any decorations.
-  IlpLogCallback(GetIlpLogLevel(av_level), line.data());
+  Log(GetIlpLogLevel(av_level), line.data());
 }
 
 namespace {
@@ -111,10 +397,21 @@ auto GetLogLevel() noexcept -> int { return GetIlpLogLevel(av_log_get_level());
 
 void SetLogCallback(const std::function<void(int, const char *)> &cb) noexcept
 {
+  // Queued messages go to the callback that was set when they were logged.
+  async_log.Flush();
+  std::scoped_lock lock{ mutex };
+  repeat_filter.Flush();
   IlpLogCallback = cb;
 }
 
+void SetAsyncLogging(const bool enabled) noexcept { async_log.SetEnabled(enabled); }
+
+auto IsAsyncLogging() noexcept -> bool { return async_log.Enabled(); }
+
+void FlushLog() noexcept { async_log.Flush(); }
+
 auto GetLogCallback() noexcept -> std::function<void(int, const char *)> {
+  std::scoped_lock lock{ mutex };
   return IlpLogCallback;
 }
 
@@ -140,8 +437,7 @@ void LogMsg(const int level, const char *msg) noexcept
 {
   // Filter messages based on log level, we can do this before locking the mutex.
   if (level > GetLogLevel()) { return; }
-  std::scoped_lock lock{ mutex };
-  IlpLogCallback(level, msg);
+  Log(level, msg);
 }
 
 }// namespace ilp_movie
@@ -27,13 +27,22 @@ extern "C" {
 }
 // clang-format on
 
+#include <ilp_movie/convert.hpp>
 #include <ilp_movie/log.hpp>
+#include <ilp_movie/trace.hpp>
 #include <internal/dict_utils.hpp>
 #include <internal/filter_graph.hpp>
 #include <internal/log_utils.hpp>
 
 using namespace std::literals;// "hello"sv
 
+// Default filter graphs, converting from full range RGB to full range BT.709 YUV.
+constexpr auto kProResFilterGraph =
+  "scale=in_range=full:in_color_matrix=bt709:out_range=full:out_color_matrix=bt709"sv;
+constexpr auto kH264FilterGraph =
+  "scale=in_range=full:in_color_matrix=bt709:out_range=full:out_color_matrix=bt709"
+  ":flags=spline+accurate_rnd+full_chroma_int+full_chroma_inp"sv;
+
 namespace ilp_movie {
 
 struct MuxImpl
@@ -46,6 +55,12 @@ struct MuxImpl
   AVFrame *enc_frame = nullptr;
 
   std::unique_ptr<filter_graph_internal::FilterGraph> filter_graph;
+
+  // True if frames are converted to the encoder pixel format without the filter graph. Only
+  // possible when the filter graph is one of the defaults, custom filter graphs always use
+  // libavfilter.
+  bool native_convert = false;
+
   // AVFilterGraph *graph = nullptr;
   // AVFilterContext *buffersink_ctx = nullptr;
   // AVFilterContext *buffersrc_ctx = nullptr;
@@ -294,6 +309,54 @@ struct MuxImpl
 #endif
 }
 
+// Returns true if the filter graph only converts from RGB to YUV in a way that is supported by
+// ConvertFrame, i.e. if it is one of the default filter graphs.
+[[nodiscard]] static auto IsNativeConvertFilter(const std::string_view filter_graph) noexcept
+  -> bool
+{
+  return filter_graph == kProResFilterGraph || filter_graph == kH264FilterGraph;
+}
+
+[[nodiscard]] static auto ConvertEncodeWriteFrame(AVFormatContext *ofmt_ctx,
+  AVCodecContext *enc_ctx,
+  AVPacket *enc_pkt,
+  AVFrame *enc_frame,
+  const ilp_movie::FrameView &frame) noexcept -> bool
+{
+  // Same output as the default filter graphs: full range BT.709.
+  av_frame_unref(enc_frame);
+  enc_frame->format = enc_ctx->pix_fmt;
+  enc_frame->width = enc_ctx->width;
+  enc_frame->height = enc_ctx->height;
+  enc_frame->color_range = AVCOL_RANGE_JPEG;
+  enc_frame->colorspace = AVCOL_SPC_BT709;
+  if (const int ret = av_frame_get_buffer(enc_frame, /*align=*/0); ret < 0) {
+    log_utils_internal::LogAvError("Cannot allocate encode frame buffer", ret);
+    return false;
+  }
+
+  ilp_movie::FrameView dst = {};
+  dst.hdr.width = enc_frame->width;
+  dst.hdr.height = enc_frame->height;
+  dst.hdr.pix_fmt_name = av_get_pix_fmt_name(enc_ctx->pix_fmt);
+  dst.hdr.color_range_name = ilp_movie::ColorRange::kPc;
+  dst.hdr.color_space_name = ilp_movie::Colorspace::kBt709;
+  for (std::size_t i = 0U; i < dst.data.size(); ++i) {
+    dst.data.at(i) = enc_frame->data[i];// NOLINT
+    dst.linesize.at(i) = enc_frame->linesize[i];// NOLINT
+  }
+  if (!ilp_movie::ConvertFrame(frame, dst)) {
+    ilp_movie::LogMsg(ilp_movie::LogLevel::kError, "Cannot convert frame\n");
+    av_frame_unref(enc_frame);
+    return false;
+  }
+  enc_frame->pts = frame.hdr.frame_nb;
+
+  const bool ok = EncodeWriteFrame(ofmt_ctx, enc_ctx, enc_pkt, enc_frame);
+  av_frame_unref(enc_frame);
+  return ok;
+}
+
 #if 0
 static void LogPacket(const AVFormatContext *fmt_ctx, const AVPacket *pkt) noexcept {
 #if 0
@@ -361,8 +424,7 @@ auto MakeMuxParameters(const std::string_view filename,
   // p.color_trc = "iec61966-2-1"sv;
 
   // p.sws_flags = "flags=spline+accurate_rnd+full_chroma_int+full_chroma_inp"sv;
-  p.filter_graph =
-    "scale=in_range=full:in_color_matrix=bt709:out_range=full:out_color_matrix=bt709"sv;
+  p.filter_graph = kProResFilterGraph;
 
   p.codec_name = "prores_ks"sv;
   p.qscale = enc_params.qscale;
@@ -394,9 +456,7 @@ auto MakeMuxParameters(const std::string_view filename,
   p.colorspace = enc_params.colorspace;
   p.color_trc = enc_params.color_trc;
 
-  p.filter_graph =
-    "scale=in_range=full:in_color_matrix=bt709:out_range=full:out_color_matrix=bt709"
-    ":flags=spline+accurate_rnd+full_chroma_int+full_chroma_inp"sv;
+  p.filter_graph = kH264FilterGraph;
 
   p.codec_name = "libx264";
   p.preset = enc_params.preset;
@@ -563,6 +623,12 @@ auto MakeMuxContext(const MuxParameters &params) noexcept -> std::unique_ptr<Mux
   impl->filter_graph = std::make_unique<filter_graph_internal::FilterGraph>();
   if (!impl->filter_graph->SetDescription(fg_descr)) { return nullptr; }
 
+  // The filter graph is kept as a fallback for input that cannot be converted natively.
+  impl->native_convert =
+    IsNativeConvertFilter(params.filter_graph)
+    && CanConvertFrame(PixFmt::kRGB_P_F32, av_get_pix_fmt_name(impl->enc_ctx->pix_fmt));
+  if (impl->native_convert) { LogMsg(LogLevel::kInfo, "Using native pixel format conversion\n"); }
+
   auto mux_ctx = std::make_unique<MuxContext>();
   mux_ctx->params = params;
   mux_ctx->impl = std::move(impl);
@@ -573,6 +639,7 @@ auto MakeMuxContext(const MuxParameters &params) noexcept -> std::unique_ptr<Mux
 // DEPRECATED!!
 auto MuxWriteFrame(const MuxContext &mux_ctx, const MuxFrame &mux_frame) noexcept -> bool
 {
+  ILP_MOVIE_TRACE_SPAN_ARG("mux", "write frame", "frame", mux_frame.frame_nb);
   // clang-format off
   // TODO(tohi): Any way to check if frame_nb is bad? Must be positive?
   if (!(mux_frame.width == mux_ctx.impl->enc_ctx->width && 
@@ -585,6 +652,22 @@ auto MuxWriteFrame(const MuxContext &mux_ctx, const MuxFrame &mux_frame) noexcep
   }
   // clang-format on
 
+  if (mux_ctx.impl->native_convert) {
+    FrameView frame = {};
+    frame.hdr.width = mux_frame.width;
+    frame.hdr.height = mux_frame.height;
+    frame.hdr.frame_nb = static_cast<int64_t>(mux_frame.frame_nb);
+    frame.hdr.pix_fmt_name = PixFmt::kRGB_P_F32;
+    // NOLINTNEXTLINE
+    frame.data = { reinterpret_cast<uint8_t *>(const_cast<float *>(mux_frame.g)),
+      reinterpret_cast<uint8_t *>(const_cast<float *>(mux_frame.b)),// NOLINT
+      reinterpret_cast<uint8_t *>(const_cast<float *>(mux_frame.r)),// NOLINT
+      nullptr };
+    const int linesize = mux_frame.width * static_cast<int>(sizeof(float));
+    frame.linesize = { linesize, linesize, linesize, 0 };
+    return MuxWriteFrame(mux_ctx, frame);
+  }
+
   // Pretend that a decoder sent us a frame.
   // Create a frame and fill in the pixel data from the given mux frame.
   AVFrame *dec_frame = av_frame_alloc();
@@ -598,6 +681,7 @@ auto MuxWriteFrame(const MuxContext &mux_ctx, const MuxFrame &mux_frame) noexcep
   dec_frame->pts = static_cast<int64_t>(mux_frame.frame_nb);
   if (const int ret = av_frame_get_buffer(dec_frame, /*align=*/0); ret < 0) {
     log_utils_internal::LogAvError("Cannot allocate decode frame buffer", ret);
+    av_frame_free(&dec_frame);
     return false;
   }
 
@@ -606,16 +690,20 @@ auto MuxWriteFrame(const MuxContext &mux_ctx, const MuxFrame &mux_frame) noexcep
   std::memcpy(/*__dest=*/dec_frame->data[1], /*__src=*/mux_frame.b, byte_count);
   std::memcpy(/*__dest=*/dec_frame->data[2], /*__src=*/mux_frame.r, byte_count);
 
-  return FilterEncodeWriteFrame(mux_ctx.impl->ofmt_ctx,
+  // The filter graph keeps its own reference to the frame data.
+  const bool ok = FilterEncodeWriteFrame(mux_ctx.impl->ofmt_ctx,
     mux_ctx.impl->enc_ctx,
     mux_ctx.impl->enc_pkt,
     mux_ctx.impl->enc_frame,
     mux_ctx.impl->filter_graph.get(),
     dec_frame);
+  av_frame_free(&dec_frame);
+  return ok;
 }
 
 auto MuxWriteFrame(const MuxContext &mux_ctx, const FrameView &frame) noexcept -> bool
 {
+  ILP_MOVIE_TRACE_SPAN_ARG("mux", "write frame", "frame", frame.hdr.frame_nb);
   const int w = frame.hdr.width;
   const int h = frame.hdr.height;
   const char *pix_fmt_name = frame.hdr.pix_fmt_name;
@@ -633,6 +721,15 @@ auto MuxWriteFrame(const MuxContext &mux_ctx, const FrameView &frame) noexcept -
   }
   // clang-format on
 
+  if (mux_ctx.impl->native_convert
+      && CanConvertFrame(pix_fmt_name, av_get_pix_fmt_name(mux_ctx.impl->enc_ctx->pix_fmt))) {
+    return ConvertEncodeWriteFrame(mux_ctx.impl->ofmt_ctx,
+      mux_ctx.impl->enc_ctx,
+      mux_ctx.impl->enc_pkt,
+      mux_ctx.impl->enc_frame,
+      frame);
+  }
+
   // Pretend that a decoder sent us a frame.
   // Create a frame and fill in the pixel data from the given mux frame.
   AVFrame *dec_frame = av_frame_alloc();
@@ -645,6 +742,7 @@ auto MuxWriteFrame(const MuxContext &mux_ctx, const FrameView &frame) noexcept -
   dec_frame->height = h;
   if (const int ret = av_frame_get_buffer(dec_frame, /*align=*/0); ret < 0) {
     log_utils_internal::LogAvError("Cannot allocate decode frame buffer", ret);
+    av_frame_free(&dec_frame);
     return false;
   }
   dec_frame->pts = static_cast<int64_t>(frame.hdr.frame_nb);
@@ -653,16 +751,20 @@ auto MuxWriteFrame(const MuxContext &mux_ctx, const FrameView &frame) noexcept -
   std::memcpy(dec_frame->data[1], b.data, b.count * sizeof(float));
   std::memcpy(dec_frame->data[2], r.data, r.count * sizeof(float));
 
-  return FilterEncodeWriteFrame(mux_ctx.impl->ofmt_ctx,
+  // The filter graph keeps its own reference to the frame data.
+  const bool ok = FilterEncodeWriteFrame(mux_ctx.impl->ofmt_ctx,
     mux_ctx.impl->enc_ctx,
     mux_ctx.impl->enc_pkt,
     mux_ctx.impl->enc_frame,
     mux_ctx.impl->filter_graph.get(),
     dec_frame);
+  av_frame_free(&dec_frame);
+  return ok;
 }
 
 auto MuxFinish(const MuxContext &mux_ctx) noexcept -> bool
 {
+  ILP_MOVIE_TRACE_SPAN("mux", "finish");
   // Flush filter.
   LogMsg(LogLevel::kInfo, "Flushing filter\n");
   if (!FilterEncodeWriteFrame(mux_ctx.impl->ofmt_ctx,
@@ -0,0 +1,284 @@
+#include <ilp_movie/trace.hpp>
+
+#include <atomic>// std::atomic
+#include <chrono>// std::chrono::steady_clock
+#include <cstdlib>// std::getenv
+#include <fstream>// std::ofstream
+#include <iomanip>// std::setprecision
+#include <memory>// std::shared_ptr, std::make_shared
+#include <mutex>// std::mutex, std::lock_guard
+#include <string>// std::string
+#include <vector>// std::vector
+
+#include <unistd.h>// ::getpid
+
+#include <ilp_movie/log.hpp>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct TraceEvent
+{
+  const char *category = nullptr;
+  const char *name = nullptr;
+  const char *arg_name = nullptr;
+  int64_t arg_value = 0;
+  int64_t begin_ns = 0;
+
+  // Negative for instant events.
+  int64_t duration_ns = -1;
+};
+
+// Limits the memory used if tracing is left enabled, roughly 50 MB per thread.
+constexpr std::size_t kMaxEventsPerThread = std::size_t{ 1 } << 20U;
+
+struct ThreadEvents
+{
+  // Only contended while the trace is being written.
+  std::mutex mutex;
+  std::vector<TraceEvent> events;
+  std::size_t dropped = 0U;
+  int tid = 0;
+};
+
+class Tracer
+{
+public:
+  // Never destroyed, since spans may end on threads that outlive static objects.
+  [[nodiscard]] static auto Instance() noexcept -> Tracer &
+  {
+    static auto *tracer = new Tracer;// NOLINT
+    return *tracer;
+  }
+
+  // Not copyable or movable.
+  Tracer(const Tracer &rhs) = delete;
+  Tracer &operator=(const Tracer &rhs) = delete;
+  Tracer(Tracer &&rhs) = delete;
+  Tracer &operator=(Tracer &&rhs) = delete;
+
+  [[nodiscard]] auto Enabled() const noexcept -> bool
+  {
+    return _enabled.load(std::memory_order_relaxed);
+  }
+
+  void SetEnabled(const bool enabled) noexcept
+  {
+    _enabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] auto Now() const noexcept -> int64_t
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - _epoch).count();
+  }
+
+  void Record(const TraceEvent &e) noexcept
+  {
+    ThreadEvents *te = _ThreadEvents();
+    if (te == nullptr) { return; }
+    std::lock_guard<std::mutex> lock{ te->mutex };
+    if (te->events.size() >= kMaxEventsPerThread) {
+      ++te->dropped;
+      return;
+    }
+    try {
+      te->events.push_back(e);
+    } catch (...) {
+      ++te->dropped;
+    }
+  }
+
+  [[nodiscard]] auto Write(const std::string &path) noexcept -> bool
+  {
+    try {
+      std::ofstream ofs{ path };
+      if (!ofs) {
+        ilp_movie::LogMsg(ilp_movie::LogLevel::kError, "Cannot open trace file for writing\n");
+        return false;
+      }
+
+      const int pid = ::getpid();
+      std::size_t dropped = 0U;
+      bool first = true;
+      // Nanosecond resolution, regardless of how long the process has been running.
+      ofs << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+      std::lock_guard<std::mutex> lock{ _mutex };
+      for (auto &&te : _threads) {
+        std::lock_guard<std::mutex> te_lock{ te->mutex };
+        for (auto &&e : te->events) {
+          ofs << (first ? "" : ",\n");
+          first = false;
+          _WriteEvent(ofs, e, pid, te->tid);
+        }
+        te->events.clear();
+        dropped += te->dropped;
+        te->dropped = 0U;
+      }
+      ofs << "\n],\"displayTimeUnit\":\"ms\"}\n";
+      if (dropped > 0U) {
+        ilp_movie::LogMsg(
+          ilp_movie::LogLevel::kWarning, "Trace events were dropped, buffers were full\n");
+      }
+      return static_cast<bool>(ofs);
+    } catch (...) {
+      ilp_movie::LogMsg(ilp_movie::LogLevel::kError, "Cannot write trace file\n");
+      return false;
+    }
+  }
+
+  void Clear() noexcept
+  {
+    std::lock_guard<std::mutex> lock{ _mutex };
+    for (auto &&te : _threads) {
+      std::lock_guard<std::mutex> te_lock{ te->mutex };
+      te->events.clear();
+      te->dropped = 0U;
+    }
+  }
+
+private:
+  Tracer() noexcept = default;
+  ~Tracer() = default;
+
+  [[nodiscard]] auto _ThreadEvents() noexcept -> ThreadEvents *
+  {
+    // The buffer is shared with the tracer, so events survive the thread.
+    thread_local std::shared_ptr<ThreadEvents> te = _Register();
+    return te.get();
+  }
+
+  [[nodiscard]] auto _Register() noexcept -> std::shared_ptr<ThreadEvents>
+  {
+    try {
+      auto te = std::make_shared<ThreadEvents>();
+      std::lock_guard<std::mutex> lock{ _mutex };
+      te->tid = ++_last_tid;
+      _threads.push_back(te);
+      return te;
+    } catch (...) {
+      return nullptr;
+    }
+  }
+
+  static void _WriteString(std::ostream &os, const char *s)
+  {
+    os << '"';
+    for (; s != nullptr && *s != '\0'; ++s) {// NOLINT
+      if (*s == '"' || *s == '\\') { os << '\\'; }
+      os << *s;
+    }
+    os << '"';
+  }
+
+  // Chrome trace-event format, timestamps in [us].
+  static void _WriteEvent(std::ostream &os, const TraceEvent &e, const int pid, const int tid)
+  {
+    constexpr double kNsPerUs = 1000.0;
+    os << "{\"name\":";
+    _WriteString(os, e.name);
+    os << ",\"cat\":";
+    _WriteString(os, e.category);
+    os << ",\"pid\":" << pid << ",\"tid\":" << tid
+       << ",\"ts\":" << static_cast<double>(e.begin_ns) / kNsPerUs;
+    if (e.duration_ns >= 0) {
+      os << ",\"ph\":\"X\",\"dur\":" << static_cast<double>(e.duration_ns) / kNsPerUs;
+    } else {
+      os << ",\"ph\":\"i\",\"s\":\"t\"";
+    }
+    if (e.arg_name != nullptr) {
+      os << ",\"args\":{";
+      _WriteString(os, e.arg_name);
+      os << ':' << e.arg_value << '}';
+    }
+    os << '}';
+  }
+
+  std::atomic<bool> _enabled{ false };
+  const Clock::time_point _epoch = Clock::now();
+
+  std::mutex _mutex;
+  std::vector<std::shared_ptr<ThreadEvents>> _threads;
+  int _last_tid = 0;
+};
+
+// Enables tracing when the library is loaded, and writes the trace when the process exits, if
+// the ILP_MOVIE_TRACE environment variable is set.
+class TraceFromEnvironment
+{
+public:
+  TraceFromEnvironment() noexcept
+  {
+    const char *path = std::getenv("ILP_MOVIE_TRACE");// NOLINT
+    if (path != nullptr && *path != '\0') {
+      try {
+        _path = path;
+        Tracer::Instance().SetEnabled(true);
+      } catch (...) {// NOLINT
+        // Leave tracing disabled.
+      }
+    }
+  }
+
+  ~TraceFromEnvironment()
+  {
+    if (!_path.empty()) { (void)Tracer::Instance().Write(_path); }
+  }
+
+  // Not copyable or movable.
+  TraceFromEnvironment(const TraceFromEnvironment &rhs) = delete;
+  TraceFromEnvironment &operator=(const TraceFromEnvironment &rhs) = delete;
+  TraceFromEnvironment(TraceFromEnvironment &&rhs) = delete;
+  TraceFromEnvironment &operator=(TraceFromEnvironment &&rhs) = delete;
+
+private:
+  std::string _path;
+};
+
+const TraceFromEnvironment trace_from_environment;
+
+}// namespace
+
+namespace ilp_movie {
+
+void SetTraceEnabled(const bool enabled) noexcept { Tracer::Instance().SetEnabled(enabled); }
+
+auto IsTraceEnabled() noexcept -> bool { return Tracer::Instance().Enabled(); }
+
+auto WriteTrace(const std::string &path) noexcept -> bool
+{
+  return Tracer::Instance().Write(path);
+}
+
+void ClearTrace() noexcept { Tracer::Instance().Clear(); }
+
+TraceSpan::TraceSpan(const char *category,
+  const char *name,
+  const char *arg_name,
+  const int64_t arg_value) noexcept
+  : _category{ category }, _name{ name }, _arg_name{ arg_name }, _arg_value{ arg_value }
+{
+  auto &tracer = Tracer::Instance();
+  if (tracer.Enabled()) { _begin_ns = tracer.Now(); }
+}
+
+TraceSpan::~TraceSpan()
+{
+  if (_begin_ns < 0) { return; }
+  auto &tracer = Tracer::Instance();
+  tracer.Record(
+    TraceEvent{ _category, _name, _arg_name, _arg_value, _begin_ns, tracer.Now() - _begin_ns });
+}
+
+void TraceInstant(const char *category,
+  const char *name,
+  const char *arg_name,
+  const int64_t arg_value) noexcept
+{
+  auto &tracer = Tracer::Instance();
+  if (!tracer.Enabled()) { return; }
+  tracer.Record(
+    TraceEvent{ category, name, arg_name, arg_value, tracer.Now(), /*duration_ns=*/-1 });
+}
+
+}// namespace ilp_movie
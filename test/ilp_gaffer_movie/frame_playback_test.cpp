@@ -0,0 +1,192 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>// std::size_t
+#include <string>// std::string
+#include <unordered_set>// std::unordered_set
+#include <vector>// std::vector
+
+#include <boost/functional/hash.hpp>// boost::hash_combine
+
+#include "internal/FramePlayback.h"
+#include "internal/SharedDecoders.h"
+#include "internal/SharedFrames.h"
+
+// The eviction policy is tested in isolation, the frame cache is replaced by a fake that only
+// keeps track of which frames are cached.
+
+namespace {
+
+using IlpGafferMovie::frame_playback_internal::FramePlayback;
+using IlpGafferMovie::shared_decoders_internal::DecoderCacheKey;
+using IlpGafferMovie::shared_decoders_internal::DecoderHandle;
+using IlpGafferMovie::shared_frames_internal::FrameCacheKey;
+
+constexpr std::size_t kFrameCost = 100U;
+
+[[nodiscard]] FrameCacheKey MakeKey(const int frame)
+{
+  FrameCacheKey key{};
+  key.decoder_handle = 0;
+  key.video_stream_index = 0;
+  key.frame_nb = frame;
+  return key;
+}
+
+// Requests frames the way SharedFrames does, evicting frames as soon as the limit is exceeded.
+class FakeCache
+{
+public:
+  explicit FakeCache(const std::size_t maxFrames) : _limit{ maxFrames * kFrameCost } {}
+
+  // Returns true for a hit.
+  bool get(const int frame)
+  {
+    const FrameCacheKey key = MakeKey(frame);
+    _playback.request(key);
+    if (_frames.count(frame) > 0U) { return true; }
+
+    _frames.insert(frame);
+    _playback.insert(key, kFrameCost);
+    const std::size_t usage = _frames.size() * kFrameCost;
+    if (usage > _limit) {
+      for (auto &&victim : _playback.victims(usage - _limit, &key)) {
+        _frames.erase(victim.frame_nb);
+        _playback.remove(victim);
+      }
+    }
+    return false;
+  }
+
+  [[nodiscard]] bool cached(const int frame) const { return _frames.count(frame) > 0U; }
+
+  [[nodiscard]] std::size_t available() const
+  {
+    const std::size_t usage = _frames.size() * kFrameCost;
+    return usage < _limit ? _limit - usage : 0U;
+  }
+
+  [[nodiscard]] FramePlayback &playback() { return _playback; }
+
+private:
+  std::size_t _limit;
+  std::unordered_set<int> _frames;
+  FramePlayback _playback;
+};
+
+}// namespace
+
+namespace IlpGafferMovie::shared_decoders_internal {
+
+const DecoderCacheKey &SharedDecoders::resolve(const DecoderHandle /*handle*/)
+{
+  static const DecoderCacheKey key{ "movie.mp4", {} };
+  return key;
+}
+
+}// namespace IlpGafferMovie::shared_decoders_internal
+
+namespace IlpGafferMovie::shared_frames_internal {
+
+bool operator==(const FrameCacheKey &lhs, const FrameCacheKey &rhs) noexcept
+{
+  return lhs.decoder_handle == rhs.decoder_handle
+         && lhs.video_stream_index == rhs.video_stream_index && lhs.frame_nb == rhs.frame_nb
+         && lhs.color_processor_handle == rhs.color_processor_handle;
+}
+
+std::size_t hash_value(const FrameCacheKey &k)
+{
+  std::size_t seed = 0;
+  boost::hash_combine(/*out*/ seed, k.decoder_handle);
+  boost::hash_combine(/*out*/ seed, k.video_stream_index);
+  boost::hash_combine(/*out*/ seed, k.frame_nb);
+  boost::hash_combine(/*out*/ seed, k.color_processor_handle);
+  return seed;
+}
+
+}// namespace IlpGafferMovie::shared_frames_internal
+
+namespace {
+
+// A range slightly larger than the cache.
+constexpr std::size_t kMaxFrames = 20U;
+constexpr int kFirstFrame = 1;
+constexpr int kLastFrame = 22;
+constexpr int kLoops = 10;
+constexpr int kOutsideFrame = 100;
+
+TEST_CASE("FramePlayback looped forward playback")
+{
+  FakeCache cache{ kMaxFrames };
+  for (int frame = kFirstFrame; frame <= kLastFrame; ++frame) { cache.get(frame); }
+
+  // An LRU cache would miss every frame, here only the frames that don't fit are decoded again
+  // on each loop.
+  int hits = 0;
+  for (int loop = 0; loop < kLoops; ++loop) {
+    for (int frame = kFirstFrame; frame <= kLastFrame; ++frame) {
+      if (cache.get(frame)) { ++hits; }
+    }
+  }
+  REQUIRE(hits >= kLoops * (static_cast<int>(kMaxFrames) - 2));
+}
+
+TEST_CASE("FramePlayback looped reverse playback")
+{
+  FakeCache cache{ kMaxFrames };
+  for (int frame = kLastFrame; frame >= kFirstFrame; --frame) { cache.get(frame); }
+
+  int hits = 0;
+  for (int loop = 0; loop < kLoops; ++loop) {
+    for (int frame = kLastFrame; frame >= kFirstFrame; --frame) {
+      if (cache.get(frame)) { ++hits; }
+    }
+  }
+  REQUIRE(hits >= kLoops * (static_cast<int>(kMaxFrames) - 2));
+}
+
+TEST_CASE("FramePlayback evicts frames outside the loop range first")
+{
+  FakeCache cache{ kMaxFrames };
+
+  // Frames viewed before playback started, away from the loop range.
+  cache.get(kOutsideFrame);
+  cache.get(kOutsideFrame + 1);
+
+  // Loop over a range that exactly fits in the cache.
+  constexpr int kLoopLast = kFirstFrame + static_cast<int>(kMaxFrames) - 1;
+  for (int frame = kFirstFrame; frame <= kLoopLast; ++frame) { cache.get(frame); }
+  REQUIRE(!cache.cached(kOutsideFrame));
+  REQUIRE(!cache.cached(kOutsideFrame + 1));
+  for (int frame = kFirstFrame; frame <= kLoopLast; ++frame) { REQUIRE(cache.cached(frame)); }
+
+  // Looping again only hits.
+  for (int frame = kFirstFrame; frame <= kLoopLast; ++frame) { REQUIRE(cache.get(frame)); }
+}
+
+TEST_CASE("FramePlayback would keep")
+{
+  FakeCache cache{ kMaxFrames };
+  for (int loop = 0; loop < 2; ++loop) {
+    for (int frame = kFirstFrame; frame <= kLastFrame; ++frame) { cache.get(frame); }
+  }
+  for (int frame = kFirstFrame; frame <= 5; ++frame) { cache.get(frame); }
+  REQUIRE(cache.available() == 0U);
+
+  // Some frame ahead of the playhead is not cached, since the range doesn't fit. Prefetching it
+  // is worth it, since frames needed later can be evicted instead.
+  int ahead = -1;
+  for (int frame = 6; frame <= kLastFrame && ahead < 0; ++frame) {
+    if (!cache.cached(frame)) { ahead = frame; }
+  }
+  REQUIRE(ahead > 0);
+  REQUIRE(cache.playback().wouldKeep(MakeKey(ahead), kFrameCost, cache.available()));
+
+  // A frame outside the loop range would be the first to be evicted.
+  REQUIRE(!cache.playback().wouldKeep(MakeKey(kOutsideFrame), kFrameCost, cache.available()));
+
+  // Frames always fit when there is room for them.
+  REQUIRE(cache.playback().wouldKeep(MakeKey(kOutsideFrame), kFrameCost, kFrameCost));
+}
+
+}// namespace
@@ -0,0 +1,180 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>// std::size_t
+#include <functional>// std::function
+#include <utility>// std::move
+#include <vector>// std::vector
+
+#include <boost/functional/hash.hpp>// boost::hash_combine
+
+#include "internal/DecodeScheduler.h"
+#include "internal/FramePrefetcher.h"
+#include "internal/SharedFrames.h"
+
+// The prefetcher is tested in isolation, the scheduler and the frame cache are replaced by fakes
+// that record submitted work and prefetched frames instead of decoding anything.
+
+namespace {
+
+using IlpGafferMovie::decode_scheduler_internal::CancellationTokenPtr;
+using IlpGafferMovie::decode_scheduler_internal::DecodePriority;
+using IlpGafferMovie::frame_prefetcher_internal::FramePrefetcher;
+using IlpGafferMovie::shared_frames_internal::FrameCacheKey;
+
+struct Job
+{
+  DecodePriority priority = DecodePriority::kInteractive;
+  CancellationTokenPtr token;
+  std::function<void()> work;
+};
+
+std::vector<Job> g_jobs;// NOLINT
+std::vector<int> g_prefetched;// NOLINT
+
+// Runs the submitted jobs, as the scheduler would, skipping cancelled ones.
+void RunJobs()
+{
+  std::vector<Job> jobs;
+  jobs.swap(g_jobs);
+  for (auto &&job : jobs) {
+    if (job.token == nullptr || !job.token->cancelled()) { job.work(); }
+  }
+}
+
+// Each test case uses its own video stream, since the prefetcher is shared.
+[[nodiscard]] FrameCacheKey MakeKey(const int videoStreamIndex, const int frame)
+{
+  FrameCacheKey key{};
+  key.decoder_handle = 0;
+  key.video_stream_index = videoStreamIndex;
+  key.frame_nb = frame;
+  return key;
+}
+
+}// namespace
+
+namespace IlpGafferMovie::decode_scheduler_internal {
+
+void CancellationToken::cancel() { _cancelled.store(true, std::memory_order_release); }
+
+void DecodeScheduler::submit(const DecodePriority priority,
+  CancellationTokenPtr token,
+  std::function<void()> work)
+{
+  g_jobs.push_back(Job{ priority, std::move(token), std::move(work) });
+}
+
+}// namespace IlpGafferMovie::decode_scheduler_internal
+
+namespace IlpGafferMovie::shared_frames_internal {
+
+bool operator==(const FrameCacheKey &lhs, const FrameCacheKey &rhs) noexcept
+{
+  return lhs.decoder_handle == rhs.decoder_handle
+         && lhs.video_stream_index == rhs.video_stream_index && lhs.frame_nb == rhs.frame_nb
+         && lhs.color_processor_handle == rhs.color_processor_handle;
+}
+
+std::size_t hash_value(const FrameCacheKey &k)
+{
+  std::size_t seed = 0;
+  boost::hash_combine(/*out*/ seed, k.decoder_handle);
+  boost::hash_combine(/*out*/ seed, k.video_stream_index);
+  boost::hash_combine(/*out*/ seed, k.frame_nb);
+  boost::hash_combine(/*out*/ seed, k.color_processor_handle);
+  return seed;
+}
+
+bool SharedFrames::prefetch(const FrameCacheKey &key)
+{
+  g_prefetched.push_back(key.frame_nb);
+  return true;
+}
+
+}// namespace IlpGafferMovie::shared_frames_internal
+
+namespace {
+
+TEST_CASE("FramePrefetcher playback")
+{
+  g_jobs.clear();
+  g_prefetched.clear();
+  constexpr int kStream = 1;
+  constexpr int kWindow = 4;
+  constexpr int kFirstFrame = 1;
+  constexpr int kLastFrame = 100;
+
+  // The pattern is confirmed by the third request, i.e. the second step of one frame.
+  FramePrefetcher::request(MakeKey(kStream, 1), kWindow, kFirstFrame, kLastFrame);
+  REQUIRE(FramePrefetcher::numPending() == 0U);
+  FramePrefetcher::request(MakeKey(kStream, 2), kWindow, kFirstFrame, kLastFrame);
+  REQUIRE(FramePrefetcher::numPending() == 0U);
+  FramePrefetcher::request(MakeKey(kStream, 3), kWindow, kFirstFrame, kLastFrame);
+  REQUIRE(FramePrefetcher::numPending() == static_cast<std::size_t>(kWindow));
+
+  // Only the next frame has normal priority.
+  REQUIRE(g_jobs.size() == static_cast<std::size_t>(kWindow));
+  REQUIRE(g_jobs[0].priority == DecodePriority::kNormal);
+  for (std::size_t i = 1U; i < g_jobs.size(); ++i) {
+    REQUIRE(g_jobs[i].priority == DecodePriority::kBackground);
+  }
+
+  RunJobs();
+  REQUIRE(g_prefetched == std::vector<int>{ 4, 5, 6, 7 });
+  REQUIRE(FramePrefetcher::numPending() == 0U);
+
+  // Continued playback queues the frames further ahead, frames that are still pending are not
+  // queued twice.
+  FramePrefetcher::request(MakeKey(kStream, 4), kWindow, kFirstFrame, kLastFrame);
+  REQUIRE(g_jobs.size() == static_cast<std::size_t>(kWindow));
+  FramePrefetcher::request(MakeKey(kStream, 5), kWindow, kFirstFrame, kLastFrame);
+  REQUIRE(g_jobs.size() == static_cast<std::size_t>(kWindow) + 1U);
+  RunJobs();
+  REQUIRE(FramePrefetcher::numPending() == 0U);
+}
+
+TEST_CASE("FramePrefetcher backward and range")
+{
+  g_jobs.clear();
+  g_prefetched.clear();
+  constexpr int kStream = 2;
+  constexpr int kWindow = 8;
+  constexpr int kFirstFrame = 3;
+  constexpr int kLastFrame = 20;
+
+  // Stepping backward over every other frame, clamped to the first frame.
+  FramePrefetcher::request(MakeKey(kStream, 10), kWindow, kFirstFrame, kLastFrame);
+  FramePrefetcher::request(MakeKey(kStream, 8), kWindow, kFirstFrame, kLastFrame);
+  FramePrefetcher::request(MakeKey(kStream, 6), kWindow, kFirstFrame, kLastFrame);
+  RunJobs();
+  REQUIRE(g_prefetched == std::vector<int>{ 4 });
+}
+
+TEST_CASE("FramePrefetcher jump cancels")
+{
+  g_jobs.clear();
+  g_prefetched.clear();
+  constexpr int kStream = 3;
+  constexpr int kWindow = 4;
+  constexpr int kFirstFrame = 1;
+  constexpr int kLastFrame = 100;
+
+  FramePrefetcher::request(MakeKey(kStream, 1), kWindow, kFirstFrame, kLastFrame);
+  FramePrefetcher::request(MakeKey(kStream, 2), kWindow, kFirstFrame, kLastFrame);
+  FramePrefetcher::request(MakeKey(kStream, 3), kWindow, kFirstFrame, kLastFrame);
+  REQUIRE(FramePrefetcher::numPending() == 4U);
+
+  // Jumping breaks the pattern, pending frames are dropped without being prefetched.
+  FramePrefetcher::request(MakeKey(kStream, 50), kWindow, kFirstFrame, kLastFrame);
+  REQUIRE(FramePrefetcher::numPending() == 0U);
+  RunJobs();
+  REQUIRE(g_prefetched.empty());
+
+  // Disabled prefetching never queues anything.
+  FramePrefetcher::request(MakeKey(kStream, 51), /*window=*/0, kFirstFrame, kLastFrame);
+  FramePrefetcher::request(MakeKey(kStream, 52), /*window=*/0, kFirstFrame, kLastFrame);
+  REQUIRE(FramePrefetcher::numPending() == 0U);
+  REQUIRE(g_jobs.empty());
+}
+
+}// namespace
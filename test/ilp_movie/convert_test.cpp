@@ -0,0 +1,625 @@
+#include <algorithm>// std::clamp, std::max, std::min
+#include <array>// std::array
+#include <cmath>// std::abs
+#include <cstdint>// uint16_t, uint32_t, uint64_t
+#include <cstring>// std::memcmp, std::memcpy
+#include <functional>// std::function
+#include <memory>// std::unique_ptr
+#include <stdexcept>// std::runtime_error
+#include <string_view>// std::string_view
+#include <vector>// std::vector
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "ilp_movie/convert.hpp"
+#include "ilp_movie/frame.hpp"
+#include "ilp_movie/parallel.hpp"
+
+// clang-format off
+extern "C" {
+#include <libavutil/pixdesc.h>// av_get_pix_fmt
+#include <libswscale/swscale.h>
+}
+// clang-format on
+
+namespace {
+
+// Frame with allocated planes, pixels are not initialized.
+[[nodiscard]] auto MakeFrame(const char *pix_fmt_name, const int w, const int h)
+  -> ilp_movie::Frame
+{
+  ilp_movie::Frame f{};
+  f.hdr.width = w;
+  f.hdr.height = h;
+  f.hdr.pix_fmt_name = pix_fmt_name;
+  f.buf = std::make_unique<uint8_t[]>(// NOLINT
+    ilp_movie::GetBufferSize(pix_fmt_name, w, h).value());
+  REQUIRE(ilp_movie::FillArrays(
+    /*out*/ f.data, /*out*/ f.linesize, f.buf.get(), pix_fmt_name, w, h));
+  return f;
+}
+
+[[nodiscard]] auto View(const ilp_movie::Frame &f) -> ilp_movie::FrameView
+{
+  ilp_movie::FrameView v{};
+  v.hdr = f.hdr;
+  v.data = f.data;
+  v.linesize = f.linesize;
+  v.buf = f.buf.get();
+  return v;
+}
+
+// Fill planes with a pattern that covers the full code range, including values outside the
+// nominal video range.
+void FillYuv(ilp_movie::Frame &f, const int depth, const int chroma_w, const int chroma_h)
+{
+  const int max_value = (1 << depth) - 1;
+  for (std::size_t p = 0U; p < 3U; ++p) {
+    const int pw = p == 0U ? f.hdr.width : chroma_w;
+    const int ph = p == 0U ? f.hdr.height : chroma_h;
+    for (int y = 0; y < ph; ++y) {
+      uint8_t *line = f.data.at(p) + static_cast<std::ptrdiff_t>(y) * f.linesize.at(p);// NOLINT
+      for (int x = 0; x < pw; ++x) {
+        const int v = (x * 7 + y * 13 + static_cast<int>(p) * 101) % (max_value + 1);// NOLINT
+        if (depth > 8) {
+          reinterpret_cast<uint16_t *>(line)[x] = static_cast<uint16_t>(v);// NOLINT
+        } else {
+          line[x] = static_cast<uint8_t>(v);// NOLINT
+        }
+      }
+    }
+  }
+}
+
+// Fill planes with a pattern in [-0.1, 1.1], i.e. including values that are clamped.
+void FillRgb(ilp_movie::Frame &f)
+{
+  for (const auto c : { ilp_movie::Comp::kR, ilp_movie::Comp::kG, ilp_movie::Comp::kB }) {
+    const auto pixels = ilp_movie::CompPixelData<float>(f, c);
+    for (std::size_t i = 0U; i < pixels.count; ++i) {
+      const auto k = static_cast<int>(i * 7U + static_cast<std::size_t>(c) * 101U) % 1200;// NOLINT
+      pixels.data[i] = static_cast<float>(k) / 1000.F - 0.1F;// NOLINT
+    }
+  }
+}
+
+[[nodiscard]] auto SamePixels(const ilp_movie::Frame &a, const ilp_movie::Frame &b) -> bool
+{
+  const auto sz = ilp_movie::GetBufferSize(a.hdr.pix_fmt_name, a.hdr.width, a.hdr.height);
+  return sz.has_value() && std::memcmp(a.buf.get(), b.buf.get(), *sz) == 0;
+}
+
+TEST_CASE("CanConvertFrame")
+{
+  REQUIRE(ilp_movie::CanConvertFrame("yuv420p", ilp_movie::PixFmt::kRGB_P_F32));
+  REQUIRE(ilp_movie::CanConvertFrame("yuv422p10le", ilp_movie::PixFmt::kRGB_P_F32));
+  REQUIRE(ilp_movie::CanConvertFrame("yuv444p12le", ilp_movie::PixFmt::kRGB_P_F32));
+  REQUIRE(ilp_movie::CanConvertFrame("yuvj420p", ilp_movie::PixFmt::kRGB_P_F32));
+
+  REQUIRE(!ilp_movie::CanConvertFrame("nv12", ilp_movie::PixFmt::kRGB_P_F32));
+  REQUIRE(!ilp_movie::CanConvertFrame("yuva444p10le", ilp_movie::PixFmt::kRGB_P_F32));
+  REQUIRE(!ilp_movie::CanConvertFrame("yuv422p10be", ilp_movie::PixFmt::kRGB_P_F32));
+  REQUIRE(!ilp_movie::CanConvertFrame("yuv420p", ilp_movie::PixFmt::kRGBA_P_F32));
+  REQUIRE(!ilp_movie::CanConvertFrame("not_a_pix_fmt_name", ilp_movie::PixFmt::kRGB_P_F32));
+  REQUIRE(!ilp_movie::CanConvertFrame(nullptr, ilp_movie::PixFmt::kRGB_P_F32));
+
+  REQUIRE(ilp_movie::CanConvertFrame(ilp_movie::PixFmt::kRGB_P_F32, "yuv420p"));
+  REQUIRE(ilp_movie::CanConvertFrame(ilp_movie::PixFmt::kRGB_P_F32, "yuv422p10le"));
+  REQUIRE(ilp_movie::CanConvertFrame(ilp_movie::PixFmt::kRGB_P_F32, "yuv444p10le"));
+  REQUIRE(ilp_movie::CanConvertFrame(ilp_movie::PixFmt::kRGBA_P_F32, "yuv444p10le"));
+
+  REQUIRE(!ilp_movie::CanConvertFrame(ilp_movie::PixFmt::kRGB_P_F32, "yuva444p10le"));
+  REQUIRE(!ilp_movie::CanConvertFrame(ilp_movie::PixFmt::kRGB_P_F32, "nv12"));
+  REQUIRE(!ilp_movie::CanConvertFrame(ilp_movie::PixFmt::kRGB_P_F32, nullptr));
+}
+
+TEST_CASE("ConvertFrame")
+{
+  // Odd dimensions to exercise chroma edges and vector tails.
+  constexpr int kWidth = 67;
+  constexpr int kHeight = 37;
+
+  SECTION("isa bit-exact")
+  {
+    struct Format
+    {
+      const char *pix_fmt_name;
+      int depth;
+      int log2_chroma_w;
+      int log2_chroma_h;
+    };
+    const std::vector<Format> formats = {
+      { "yuv420p", 8, 1, 1 },
+      { "yuv422p10le", 10, 1, 0 },
+      { "yuv444p12le", 12, 0, 0 },
+    };
+    for (auto &&fmt : formats) {
+      auto src = MakeFrame(fmt.pix_fmt_name, kWidth, kHeight);
+      src.hdr.color_range_name = ilp_movie::ColorRange::kTv;
+      src.hdr.color_space_name = ilp_movie::Colorspace::kBt709;
+      FillYuv(src,
+        fmt.depth,
+        (kWidth + (1 << fmt.log2_chroma_w) - 1) >> fmt.log2_chroma_w,// NOLINT
+        (kHeight + (1 << fmt.log2_chroma_h) - 1) >> fmt.log2_chroma_h);// NOLINT
+
+      auto scalar = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+      ilp_movie::ConvertOptions opts{};
+      opts.isa = ilp_movie::ConvertIsa::kScalar;
+      REQUIRE(ilp_movie::ConvertFrame(View(src), View(scalar), opts));
+
+      for (const auto isa : { ilp_movie::ConvertIsa::kSse41, ilp_movie::ConvertIsa::kAvx2 }) {
+        auto simd = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+        opts.isa = isa;
+        REQUIRE(ilp_movie::ConvertFrame(View(src), View(simd), opts));
+        REQUIRE(SamePixels(scalar, simd));
+      }
+    }
+  }
+
+  SECTION("vflip")
+  {
+    auto src = MakeFrame("yuv420p", kWidth, kHeight);
+    FillYuv(src, 8, (kWidth + 1) / 2, (kHeight + 1) / 2);// NOLINT
+
+    auto dst = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+    auto dst_flip = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+    REQUIRE(ilp_movie::ConvertFrame(View(src), View(dst)));
+    ilp_movie::ConvertOptions opts{};
+    opts.vflip = true;
+    REQUIRE(ilp_movie::ConvertFrame(View(src), View(dst_flip), opts));
+
+    for (std::size_t p = 0U; p < 3U; ++p) {
+      for (int y = 0; y < kHeight; ++y) {
+        const uint8_t *line = dst.data.at(p) + y * dst.linesize.at(p);// NOLINT
+        const uint8_t *line_flip =
+          dst_flip.data.at(p) + (kHeight - 1 - y) * dst_flip.linesize.at(p);// NOLINT
+        REQUIRE(std::memcmp(line, line_flip, kWidth * sizeof(float)) == 0);
+      }
+    }
+  }
+
+  SECTION("range")
+  {
+    // Limited range black, white and mid-gray, 10-bit.
+    auto src = MakeFrame("yuv444p10le", 3, 1);
+    src.hdr.color_range_name = ilp_movie::ColorRange::kTv;
+    src.hdr.color_space_name = ilp_movie::Colorspace::kBt709;
+    const std::array<uint16_t, 3> y_values = { 64, 940, 502 };
+    for (std::size_t x = 0U; x < 3U; ++x) {
+      reinterpret_cast<uint16_t *>(src.data[0])[x] = y_values.at(x);// NOLINT
+      reinterpret_cast<uint16_t *>(src.data[1])[x] = 512;// NOLINT
+      reinterpret_cast<uint16_t *>(src.data[2])[x] = 512;// NOLINT
+    }
+
+    auto dst = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, 3, 1);
+    REQUIRE(ilp_movie::ConvertFrame(View(src), View(dst)));
+    for (const auto c : { ilp_movie::Comp::kR, ilp_movie::Comp::kG, ilp_movie::Comp::kB }) {
+      const auto pixels = ilp_movie::CompPixelData<const float>(dst, c);
+      REQUIRE(std::abs(pixels.data[0] - 0.F) < 1e-6F);// NOLINT
+      REQUIRE(std::abs(pixels.data[1] - 1.F) < 1e-6F);// NOLINT
+      REQUIRE(std::abs(pixels.data[2] - 0.5F) < 1e-6F);// NOLINT
+    }
+  }
+
+  SECTION("external parallel for")
+  {
+    auto src = MakeFrame("yuv420p", kWidth, kHeight);
+    FillYuv(src, 8, (kWidth + 1) / 2, (kHeight + 1) / 2);// NOLINT
+    auto dst = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+    REQUIRE(ilp_movie::ConvertFrame(View(src), View(dst)));
+
+    // Process sub-ranges in reverse order on the calling thread.
+    int call_count = 0;
+    ilp_movie::SetParallelFor(
+      [&](const int begin,
+        const int end,
+        const int grain_size,
+        const std::function<void(int, int)> &func) {
+        ++call_count;
+        for (int b = begin + ((end - begin - 1) / grain_size) * grain_size; b >= begin;
+             b -= grain_size) {
+          func(b, std::min(b + grain_size, end));
+        }
+      },
+      /*concurrency=*/4);
+    auto dst_external = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+    const bool ok = ilp_movie::ConvertFrame(View(src), View(dst_external));
+    ilp_movie::SetParallelFor(/*parallel_for=*/{}, /*concurrency=*/0);
+    REQUIRE(ok);
+    REQUIRE(call_count > 0);
+    REQUIRE(SamePixels(dst, dst_external));
+  }
+
+  SECTION("failing external parallel for")
+  {
+    auto src = MakeFrame("yuv420p", kWidth, kHeight);
+    FillYuv(src, 8, (kWidth + 1) / 2, (kHeight + 1) / 2);// NOLINT
+    auto dst = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+    REQUIRE(ilp_movie::ConvertFrame(View(src), View(dst)));
+
+    // Process every other sub-range and then fail, the remaining rows are converted by the
+    // library.
+    ilp_movie::SetParallelFor(
+      [](const int begin,
+        const int end,
+        const int grain_size,
+        const std::function<void(int, int)> &func) {
+        for (int b = begin; b < end; b += 2 * grain_size) {
+          func(b, std::min(b + grain_size, end));
+        }
+        throw std::runtime_error("Cancelled");
+      },
+      /*concurrency=*/4);
+    auto dst_external = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+    const bool ok = ilp_movie::ConvertFrame(View(src), View(dst_external));
+    ilp_movie::SetParallelFor(/*parallel_for=*/{}, /*concurrency=*/0);
+    REQUIRE(ok);
+    REQUIRE(SamePixels(dst, dst_external));
+  }
+
+  SECTION("unsupported")
+  {
+    auto src = MakeFrame("yuv420p", kWidth, kHeight);
+    auto dst = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+    src.hdr.color_space_name = "bt2020nc";
+    REQUIRE(!ilp_movie::ConvertFrame(View(src), View(dst)));
+
+    src.hdr.color_space_name = ilp_movie::Colorspace::kBt709;
+    auto dst_small = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth - 1, kHeight);
+    REQUIRE(!ilp_movie::ConvertFrame(View(src), View(dst_small)));
+  }
+}
+
+TEST_CASE("ConvertFrameRegion")
+{
+  constexpr int kWidth = 67;
+  constexpr int kHeight = 37;
+
+  SECTION("same as ConvertFrame")
+  {
+    struct Format
+    {
+      const char *pix_fmt_name;
+      int depth;
+      int log2_chroma_w;
+      int log2_chroma_h;
+    };
+    const std::vector<Format> formats = {
+      { "yuv420p", 8, 1, 1 },
+      { "yuv422p10le", 10, 1, 0 },
+      { "yuv444p12le", 12, 0, 0 },
+    };
+    struct Region
+    {
+      int x;
+      int y;
+      int w;
+      int h;
+    };
+    // Even and odd edges, the right and bottom edges of the frame, and the whole frame.
+    const std::vector<Region> regions = {
+      { 0, 0, 16, 16 },
+      { 17, 5, 13, 9 },
+      { 20, 10, 1, 1 },
+      { 51, 21, 16, 16 },
+      { 0, 0, kWidth, kHeight },
+    };
+    for (auto &&fmt : formats) {
+      auto src = MakeFrame(fmt.pix_fmt_name, kWidth, kHeight);
+      src.hdr.color_range_name = ilp_movie::ColorRange::kTv;
+      src.hdr.color_space_name = ilp_movie::Colorspace::kBt709;
+      FillYuv(src,
+        fmt.depth,
+        (kWidth + (1 << fmt.log2_chroma_w) - 1) >> fmt.log2_chroma_w,// NOLINT
+        (kHeight + (1 << fmt.log2_chroma_h) - 1) >> fmt.log2_chroma_h);// NOLINT
+
+      for (const bool vflip : { false, true }) {
+        ilp_movie::ConvertOptions opts{};
+        opts.vflip = vflip;
+        auto dst = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+        REQUIRE(ilp_movie::ConvertFrame(View(src), View(dst), opts));
+
+        for (auto &&r : regions) {
+          for (const auto c : { ilp_movie::Comp::kR, ilp_movie::Comp::kG, ilp_movie::Comp::kB }) {
+            // Padded rows, to check the stride.
+            const int stride = r.w + 3;
+            std::vector<float> region(static_cast<std::size_t>(stride * r.h));
+            REQUIRE(ilp_movie::ConvertFrameRegion(
+              View(src), c, r.x, r.y, r.w, r.h, region.data(), stride, opts));
+
+            const auto pixels = ilp_movie::CompPixelData<const float>(dst, c);
+            for (int y = 0; y < r.h; ++y) {
+              const float *expected = pixels.data + (r.y + y) * kWidth + r.x;// NOLINT
+              const float *actual = region.data() + y * stride;// NOLINT
+              REQUIRE(std::memcmp(expected, actual, r.w * sizeof(float)) == 0);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  SECTION("unsupported")
+  {
+    auto src = MakeFrame("yuv420p", kWidth, kHeight);
+    FillYuv(src, 8, (kWidth + 1) / 2, (kHeight + 1) / 2);// NOLINT
+    std::vector<float> region(static_cast<std::size_t>(kWidth * kHeight));
+    REQUIRE(!ilp_movie::ConvertFrameRegion(
+      View(src), ilp_movie::Comp::kA, 0, 0, 8, 8, region.data(), kWidth));
+    REQUIRE(!ilp_movie::ConvertFrameRegion(
+      View(src), ilp_movie::Comp::kR, kWidth - 7, 0, 8, 8, region.data(), kWidth));
+    REQUIRE(!ilp_movie::ConvertFrameRegion(
+      View(src), ilp_movie::Comp::kR, 0, 0, 8, 8, region.data(), /*dst_stride=*/7));
+
+    src.hdr.color_space_name = "bt2020nc";
+    REQUIRE(!ilp_movie::ConvertFrameRegion(
+      View(src), ilp_movie::Comp::kR, 0, 0, 8, 8, region.data(), kWidth));
+
+    auto rgb = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+    REQUIRE(!ilp_movie::ConvertFrameRegion(
+      View(rgb), ilp_movie::Comp::kR, 0, 0, 8, 8, region.data(), kWidth));
+  }
+}
+
+TEST_CASE("ConvertFrame(rgb to yuv)")
+{
+  // Odd dimensions to exercise chroma edges and vector tails.
+  constexpr int kWidth = 67;
+  constexpr int kHeight = 37;
+
+  SECTION("isa bit-exact")
+  {
+    for (const auto *pix_fmt_name : { "yuv420p", "yuv422p10le", "yuv444p10le" }) {
+      auto src = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+      FillRgb(src);
+
+      auto scalar = MakeFrame(pix_fmt_name, kWidth, kHeight);
+      scalar.hdr.color_range_name = ilp_movie::ColorRange::kTv;
+      scalar.hdr.color_space_name = ilp_movie::Colorspace::kBt709;
+      ilp_movie::ConvertOptions opts{};
+      opts.isa = ilp_movie::ConvertIsa::kScalar;
+      REQUIRE(ilp_movie::ConvertFrame(View(src), View(scalar), opts));
+
+      for (const auto isa : { ilp_movie::ConvertIsa::kSse41, ilp_movie::ConvertIsa::kAvx2 }) {
+        auto simd = MakeFrame(pix_fmt_name, kWidth, kHeight);
+        simd.hdr.color_range_name = scalar.hdr.color_range_name;
+        simd.hdr.color_space_name = scalar.hdr.color_space_name;
+        opts.isa = isa;
+        REQUIRE(ilp_movie::ConvertFrame(View(src), View(simd), opts));
+        REQUIRE(SamePixels(scalar, simd));
+      }
+    }
+  }
+
+  SECTION("range")
+  {
+    // Black, white and mid-gray, 10-bit.
+    auto src = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, 3, 1);
+    for (const auto c : { ilp_movie::Comp::kR, ilp_movie::Comp::kG, ilp_movie::Comp::kB }) {
+      const auto pixels = ilp_movie::CompPixelData<float>(src, c);
+      pixels.data[0] = 0.F;// NOLINT
+      pixels.data[1] = 1.F;// NOLINT
+      pixels.data[2] = 0.5F;// NOLINT
+    }
+
+    struct Case
+    {
+      const char *color_range_name;
+      std::array<uint16_t, 3> y_values;
+    };
+    for (auto &&c : { Case{ ilp_movie::ColorRange::kTv, { 64, 940, 502 } },
+           Case{ ilp_movie::ColorRange::kPc, { 0, 1023, 512 } } }) {
+      auto dst = MakeFrame("yuv444p10le", 3, 1);
+      dst.hdr.color_range_name = c.color_range_name;
+      dst.hdr.color_space_name = ilp_movie::Colorspace::kBt709;
+      REQUIRE(ilp_movie::ConvertFrame(View(src), View(dst)));
+      for (std::size_t x = 0U; x < 3U; ++x) {
+        REQUIRE(reinterpret_cast<const uint16_t *>(dst.data[0])[x] == c.y_values.at(x));// NOLINT
+        REQUIRE(reinterpret_cast<const uint16_t *>(dst.data[1])[x] == 512);// NOLINT
+        REQUIRE(reinterpret_cast<const uint16_t *>(dst.data[2])[x] == 512);// NOLINT
+      }
+    }
+  }
+
+  SECTION("round trip")
+  {
+    // Without chroma subsampling the only error is from quantization, which is less than two
+    // 10-bit code values after conversion back to RGB.
+    constexpr float kTolerance = 2.F / 1023.F;
+
+    auto src = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+    FillRgb(src);
+    for (const auto c : { ilp_movie::Comp::kR, ilp_movie::Comp::kG, ilp_movie::Comp::kB }) {
+      const auto pixels = ilp_movie::CompPixelData<float>(src, c);
+      for (std::size_t i = 0U; i < pixels.count; ++i) {
+        pixels.data[i] = std::clamp(pixels.data[i], 0.F, 1.F);// NOLINT
+      }
+    }
+
+    for (const auto *color_range_name : { ilp_movie::ColorRange::kTv, ilp_movie::ColorRange::kPc }) {
+      auto yuv = MakeFrame("yuv444p10le", kWidth, kHeight);
+      yuv.hdr.color_range_name = color_range_name;
+      yuv.hdr.color_space_name = ilp_movie::Colorspace::kBt709;
+      REQUIRE(ilp_movie::ConvertFrame(View(src), View(yuv)));
+
+      auto dst = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+      REQUIRE(ilp_movie::ConvertFrame(View(yuv), View(dst)));
+
+      float max_err = 0.F;
+      for (const auto comp : { ilp_movie::Comp::kR, ilp_movie::Comp::kG, ilp_movie::Comp::kB }) {
+        const auto a = ilp_movie::CompPixelData<const float>(src, comp);
+        const auto b = ilp_movie::CompPixelData<const float>(dst, comp);
+        for (std::size_t i = 0U; i < a.count; ++i) {
+          max_err = std::max(max_err, std::abs(a.data[i] - b.data[i]));// NOLINT
+        }
+      }
+      REQUIRE(max_err < kTolerance);
+    }
+  }
+
+  SECTION("vflip")
+  {
+    auto src = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+    FillRgb(src);
+
+    auto dst = MakeFrame("yuv444p10le", kWidth, kHeight);
+    auto dst_flip = MakeFrame("yuv444p10le", kWidth, kHeight);
+    REQUIRE(ilp_movie::ConvertFrame(View(src), View(dst)));
+    ilp_movie::ConvertOptions opts{};
+    opts.vflip = true;
+    REQUIRE(ilp_movie::ConvertFrame(View(src), View(dst_flip), opts));
+
+    for (std::size_t p = 0U; p < 3U; ++p) {
+      for (int y = 0; y < kHeight; ++y) {
+        const uint8_t *line = dst.data.at(p) + y * dst.linesize.at(p);// NOLINT
+        const uint8_t *line_flip =
+          dst_flip.data.at(p) + (kHeight - 1 - y) * dst_flip.linesize.at(p);// NOLINT
+        REQUIRE(std::memcmp(line, line_flip, kWidth * sizeof(uint16_t)) == 0);
+      }
+    }
+  }
+}
+
+TEST_CASE("ConvertFrame(swscale)")
+{
+  // Compare against libswscale for 4:4:4 input, where there is no chroma interpolation
+  // that may differ between implementations. The fixed-point swscale path is not expected to be
+  // bit-exact with our floating point conversion, but it should be well within one 10-bit code
+  // value.
+  constexpr int kWidth = 64;
+  constexpr int kHeight = 48;
+  constexpr float kTolerance = 1.F / 1023.F;
+
+  struct Case
+  {
+    const char *pix_fmt_name;
+    int depth;
+    const char *color_range_name;
+    const char *color_space_name;
+    int sws_colorspace;
+  };
+  const std::vector<Case> cases = {
+    { "yuv444p10le", 10, ilp_movie::ColorRange::kTv, ilp_movie::Colorspace::kBt709, SWS_CS_ITU709 },
+    { "yuv444p10le", 10, ilp_movie::ColorRange::kPc, ilp_movie::Colorspace::kBt709, SWS_CS_ITU709 },
+    { "yuv444p", 8, ilp_movie::ColorRange::kTv, "smpte170m", SWS_CS_ITU601 },
+    { "yuv444p", 8, ilp_movie::ColorRange::kPc, "smpte170m", SWS_CS_ITU601 },
+  };
+
+  for (auto &&c : cases) {
+    auto src = MakeFrame(c.pix_fmt_name, kWidth, kHeight);
+    src.hdr.color_range_name = c.color_range_name;
+    src.hdr.color_space_name = c.color_space_name;
+    FillYuv(src, c.depth, kWidth, kHeight);
+
+    auto dst = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+    REQUIRE(ilp_movie::ConvertFrame(View(src), View(dst)));
+
+    auto ref = MakeFrame(ilp_movie::PixFmt::kRGB_P_F32, kWidth, kHeight);
+    SwsContext *sws_ctx = sws_getContext(kWidth,
+      kHeight,
+      av_get_pix_fmt(c.pix_fmt_name),
+      kWidth,
+      kHeight,
+      av_get_pix_fmt(ilp_movie::PixFmt::kRGB_P_F32),
+      SWS_POINT | SWS_ACCURATE_RND | SWS_FULL_CHR_H_INT | SWS_FULL_CHR_H_INP,// NOLINT
+      /*srcFilter=*/nullptr,
+      /*dstFilter=*/nullptr,
+      /*param=*/nullptr);
+    REQUIRE(sws_ctx != nullptr);
+    const bool src_full_range = std::string_view{ c.color_range_name } == ilp_movie::ColorRange::kPc;
+    REQUIRE(sws_setColorspaceDetails(sws_ctx,
+              sws_getCoefficients(c.sws_colorspace),
+              src_full_range ? 1 : 0,
+              sws_getCoefficients(SWS_CS_DEFAULT),
+              /*dstRange=*/1,
+              /*brightness=*/0,
+              /*contrast=*/1 << 16,// NOLINT
+              /*saturation=*/1 << 16)// NOLINT
+            >= 0);
+    const int out_height = sws_scale(sws_ctx,
+      src.data.data(),
+      src.linesize.data(),
+      /*srcSliceY=*/0,
+      kHeight,
+      ref.data.data(),
+      ref.linesize.data());
+    sws_freeContext(sws_ctx);
+    REQUIRE(out_height == kHeight);
+
+    float max_err = 0.F;
+    for (const auto comp : { ilp_movie::Comp::kR, ilp_movie::Comp::kG, ilp_movie::Comp::kB }) {
+      const auto a = ilp_movie::CompPixelData<const float>(dst, comp);
+      const auto b = ilp_movie::CompPixelData<const float>(ref, comp);
+      REQUIRE(a.count == b.count);
+      for (std::size_t i = 0U; i < a.count; ++i) {
+        max_err = std::max(max_err, std::abs(a.data[i] - b.data[i]));// NOLINT
+      }
+    }
+    REQUIRE(max_err < kTolerance);
+  }
+}
+
+TEST_CASE("FloatToHalf")
+{
+  SECTION("known values")
+  {
+    // clang-format off
+    const std::array<float, 10> in = {
+      0.F, -0.F, 1.F, -2.F, 0.1F, 65504.F, 65520.F, 1.F / 16777216.F, 1.F / 33554432.F, 6.1e-5F
+    };
+    const std::array<uint16_t, 10> expected = {
+      0x0000, 0x8000, 0x3c00, 0xc000, 0x2e66, 0x7bff, 0x7c00, 0x0001, 0x0000, 0x03ff
+    };
+    // clang-format on
+    for (const auto isa : { ilp_movie::ConvertIsa::kScalar, ilp_movie::ConvertIsa::kAuto }) {
+      std::array<uint16_t, 10> out = {};
+      ilp_movie::FloatToHalf(in.data(), out.data(), static_cast<int>(in.size()), isa);
+      REQUIRE(out == expected);
+    }
+  }
+
+  SECTION("round trip")
+  {
+    // All half values, which are exactly representable as floats.
+    std::vector<uint16_t> in(std::size_t{ 1 } << 16U);
+    for (std::size_t i = 0U; i < in.size(); ++i) { in[i] = static_cast<uint16_t>(i); }
+    for (const auto isa : { ilp_movie::ConvertIsa::kScalar, ilp_movie::ConvertIsa::kAuto }) {
+      std::vector<float> f(in.size());
+      std::vector<uint16_t> out(in.size());
+      ilp_movie::HalfToFloat(in.data(), f.data(), static_cast<int>(in.size()), isa);
+      ilp_movie::FloatToHalf(f.data(), out.data(), static_cast<int>(f.size()), isa);
+      for (std::size_t i = 0U; i < in.size(); ++i) {
+        // NaNs are quieted.
+        const bool nan = (in[i] & 0x7c00U) == 0x7c00U && (in[i] & 0x3ffU) != 0U;// NOLINT
+        REQUIRE(out[i] == (nan ? (in[i] | 0x200U) : in[i]));// NOLINT
+      }
+    }
+  }
+
+  SECTION("isa bit-exact")
+  {
+    // A sample of float bit patterns covering all exponents, including rounding ties.
+    constexpr uint32_t kStep = 4099U;
+    std::vector<float> in;
+    for (uint64_t bits = 0U; bits <= 0xffffffffU; bits += kStep) {
+      const auto b = static_cast<uint32_t>(bits);
+      float f = 0.F;
+      std::memcpy(&f, &b, sizeof(f));
+      in.push_back(f);
+    }
+    const auto n = static_cast<int>(in.size());
+    std::vector<uint16_t> ref(in.size());
+    std::vector<uint16_t> out(in.size());
+    ilp_movie::FloatToHalf(in.data(), ref.data(), n, ilp_movie::ConvertIsa::kScalar);
+    ilp_movie::FloatToHalf(in.data(), out.data(), n, ilp_movie::ConvertIsa::kAvx2);
+    REQUIRE(ref == out);
+
+    std::vector<float> ref_f(in.size());
+    std::vector<float> out_f(in.size());
+    ilp_movie::HalfToFloat(ref.data(), ref_f.data(), n, ilp_movie::ConvertIsa::kScalar);
+    ilp_movie::HalfToFloat(ref.data(), out_f.data(), n, ilp_movie::ConvertIsa::kAvx2);
+    REQUIRE(std::memcmp(ref_f.data(), out_f.data(), sizeof(float) * in.size()) == 0);
+  }
+}
+
+}// namespace
@@ -1,17 +1,22 @@
 #include <algorithm>// std::shuffle
 #include <array>// std::array
+#include <cstring>// std::memcmp
+#include <functional>// std::function
 #include <iostream>// std::cout, std::cerr
 #include <mutex>//std::call_once
 #include <random>// std::default_random_engine
 #include <sstream>// std::ostringstream
 #include <string>// std::string
+#include <string_view>// std::string_view
 #include <thread>//std::thread
 #include <vector>// std::vector
 
 #include <catch2/catch_test_macros.hpp>
 
+#include "ilp_movie/convert.hpp"
 #include "ilp_movie/decoder.hpp"
 #include "ilp_movie/frame.hpp"
+#include "ilp_movie/frame_filter.hpp"
 #include "ilp_movie/log.hpp"
 #include "ilp_movie/mux.hpp"
 
@@ -355,6 +360,189 @@ TEST_CASE("seek(prores)")
     REQUIRE(dump_log_on_fail(bad_frame == -1));
   }
 
+  SECTION("RGB(native)")
+  {
+    // Pass-through filter graph, frames are converted without libswscale.
+    ilp_movie::Decoder decoder{};
+    REQUIRE(dump_log_on_fail(decoder.Open(kFilename.data(),
+      ilp_movie::DecoderFilterGraphDescription{ "null", ilp_movie::PixFmt::kRGB_P_F32 })));
+
+    const auto frame_stats = SeekFrames(decoder, /*stream_index=*/0, kFrameCount);
+    REQUIRE(dump_log_on_fail(frame_stats.size() == kFrameCount));
+
+    int bad_frame = -1;
+    for (int i = 0; i < kFrameCount; ++i) {
+      const auto &fs = frame_stats.at(static_cast<std::size_t>(i));
+
+      // clang-format off
+      if (!(0.0 <= fs.r_avg_err && fs.r_avg_err < 0.01 &&
+            0.0 <= fs.g_avg_err && fs.g_avg_err < 0.01 &&
+            0.0 <= fs.b_avg_err && fs.b_avg_err < 0.01 &&
+            0.0 <= fs.r_max_err && fs.r_max_err < 0.03 &&
+            0.0 <= fs.g_max_err && fs.g_max_err < 0.03 &&
+            0.0 <= fs.b_max_err && fs.b_max_err < 0.03)) {
+        bad_frame = i;
+        break;
+      }
+      // clang-format on
+    }
+    REQUIRE(dump_log_on_fail(bad_frame == -1));
+  }
+
+  SECTION("filtered header")
+  {
+    // The filtered header should describe the decoded frames without having to decode a frame.
+    ilp_movie::Decoder decoder{};
+    REQUIRE(dump_log_on_fail(decoder.Open(kFilename.data(),
+      ilp_movie::DecoderFilterGraphDescription{ "scale=320:240", ilp_movie::PixFmt::kRGB_P_F32 })));
+
+    const auto hdr = decoder.FilteredVideoStreamHeader(/*stream_index=*/-1);
+    REQUIRE(dump_log_on_fail(hdr.has_value()));
+    REQUIRE(dump_log_on_fail(hdr->stream_index == 0));
+    REQUIRE(dump_log_on_fail(hdr->width == 320));
+    REQUIRE(dump_log_on_fail(hdr->height == 240));
+    REQUIRE(dump_log_on_fail(hdr->first_frame_nb == 1));
+    REQUIRE(dump_log_on_fail(hdr->frame_count == kFrameCount));
+    REQUIRE(dump_log_on_fail(
+      std::string_view{ hdr->pix_fmt_name } == std::string_view{ ilp_movie::PixFmt::kRGB_P_F32 }));
+
+    // Unfiltered header is unchanged.
+    const auto in_hdr = decoder.VideoStreamHeader(/*stream_index=*/-1);
+    REQUIRE(dump_log_on_fail(in_hdr.has_value()));
+    REQUIRE(dump_log_on_fail(in_hdr->width == kWidth));
+    REQUIRE(dump_log_on_fail(in_hdr->height == kHeight));
+
+    ilp_movie::Frame frame{};
+    REQUIRE(dump_log_on_fail(decoder.DecodeVideoFrame(/*stream_index=*/0, /*frame_nb=*/1, frame)));
+    REQUIRE(dump_log_on_fail(frame.hdr.width == hdr->width));
+    REQUIRE(dump_log_on_fail(frame.hdr.height == hdr->height));
+    REQUIRE(dump_log_on_fail(std::string_view{ frame.hdr.pix_fmt_name } == hdr->pix_fmt_name));
+  }
+
+  SECTION("hibernate")
+  {
+    ilp_movie::Decoder decoder{};
+    REQUIRE(dump_log_on_fail(decoder.Open(kFilename.data(),
+      ilp_movie::DecoderFilterGraphDescription{ "null", ilp_movie::PixFmt::kRGB_P_F32 })));
+    const std::string probe = decoder.Probe();
+
+    ilp_movie::Frame frame{};
+    REQUIRE(dump_log_on_fail(decoder.DecodeVideoFrame(/*stream_index=*/0, /*frame_nb=*/1, frame)));
+
+    // Headers and probe information are kept while hibernating.
+    decoder.Hibernate();
+    REQUIRE(dump_log_on_fail(decoder.IsHibernating()));
+    REQUIRE(dump_log_on_fail(decoder.IsOpen()));
+    REQUIRE(dump_log_on_fail(decoder.Probe() == probe));
+    REQUIRE(dump_log_on_fail(decoder.VideoStreamHeaders().size() == 1U));
+    REQUIRE(dump_log_on_fail(decoder.FilteredVideoStreamHeader(/*stream_index=*/0).has_value()));
+
+    // Decoding wakes up the decoder.
+    REQUIRE(
+      dump_log_on_fail(decoder.DecodeVideoFrame(/*stream_index=*/0, /*frame_nb=*/100, frame)));
+    REQUIRE(dump_log_on_fail(!decoder.IsHibernating()));
+    REQUIRE(dump_log_on_fail(frame.hdr.frame_nb == 100));
+    REQUIRE(dump_log_on_fail(frame.hdr.width == kWidth));
+    REQUIRE(dump_log_on_fail(frame.hdr.height == kHeight));
+
+    // An idle decoder can always be hibernated without waiting.
+    REQUIRE(dump_log_on_fail(decoder.TryHibernate()));
+    REQUIRE(dump_log_on_fail(decoder.IsHibernating()));
+    REQUIRE(dump_log_on_fail(decoder.TryHibernate()));
+    REQUIRE(
+      dump_log_on_fail(decoder.DecodeVideoFrame(/*stream_index=*/0, /*frame_nb=*/2, frame)));
+    REQUIRE(dump_log_on_fail(!decoder.IsHibernating()));
+
+    // Closing a hibernating decoder.
+    decoder.Hibernate();
+    decoder.Close();
+    REQUIRE(dump_log_on_fail(!decoder.IsOpen()));
+    REQUIRE(dump_log_on_fail(!decoder.IsHibernating()));
+  }
+
+  SECTION("raw frames")
+  {
+    // No output pixel format, frames are decoded without filtering.
+    ilp_movie::Decoder raw_decoder{};
+    REQUIRE(dump_log_on_fail(raw_decoder.Open(kFilename.data(),
+      ilp_movie::DecoderFilterGraphDescription{ "null", /*out_pix_fmt_name=*/"" })));
+    const auto raw_hdr = raw_decoder.VideoStreamHeader(/*stream_index=*/0);
+    REQUIRE(dump_log_on_fail(raw_hdr.has_value()));
+    REQUIRE(dump_log_on_fail(std::string_view{ raw_hdr->pix_fmt_name } == "yuv422p10le"sv));
+
+    ilp_movie::Frame raw_frame{};
+    REQUIRE(dump_log_on_fail(
+      raw_decoder.DecodeVideoFrame(/*stream_index=*/0, /*frame_nb=*/10, raw_frame)));
+    REQUIRE(dump_log_on_fail(raw_frame.hdr.frame_nb == 10));
+    REQUIRE(dump_log_on_fail(raw_frame.hdr.width == kWidth));
+    REQUIRE(dump_log_on_fail(raw_frame.hdr.height == kHeight));
+    REQUIRE(dump_log_on_fail(std::string_view{ raw_frame.hdr.pix_fmt_name } == "yuv422p10le"sv));
+
+    // Filtering a raw frame gives the same result as decoding a filtered frame.
+    const ilp_movie::DecoderFilterGraphDescription dfgd{ "null", ilp_movie::PixFmt::kRGB_P_F32 };
+    ilp_movie::FrameFilter filter{};
+    REQUIRE(dump_log_on_fail(filter.SetDescription(dfgd, *raw_hdr)));
+    ilp_movie::Frame filt_frame{};
+    REQUIRE(dump_log_on_fail(filter.FilterFrame(raw_frame, filt_frame)));
+
+    ilp_movie::Decoder decoder{};
+    REQUIRE(dump_log_on_fail(decoder.Open(kFilename.data(), dfgd)));
+    ilp_movie::Frame frame{};
+    REQUIRE(dump_log_on_fail(decoder.DecodeVideoFrame(/*stream_index=*/0, /*frame_nb=*/10, frame)));
+
+    REQUIRE(dump_log_on_fail(filt_frame.hdr.frame_nb == frame.hdr.frame_nb));
+    REQUIRE(dump_log_on_fail(filt_frame.hdr.width == frame.hdr.width));
+    REQUIRE(dump_log_on_fail(filt_frame.hdr.height == frame.hdr.height));
+    REQUIRE(dump_log_on_fail(std::string_view{ filt_frame.hdr.pix_fmt_name }
+                             == std::string_view{ frame.hdr.pix_fmt_name }));
+    const auto buf_size =
+      ilp_movie::GetBufferSize(frame.hdr.pix_fmt_name, frame.hdr.width, frame.hdr.height);
+    REQUIRE(dump_log_on_fail(buf_size.has_value()));
+    REQUIRE(dump_log_on_fail(std::memcmp(filt_frame.buf.get(), frame.buf.get(), *buf_size) == 0));
+
+    // Pure pixel format conversions can be done lazily, region by region.
+    const auto native_convert = filter.NativeConvert();
+    REQUIRE(dump_log_on_fail(native_convert.has_value()));
+    REQUIRE(dump_log_on_fail(!native_convert->vflip));
+    ilp_movie::FrameView raw_view{};
+    raw_view.hdr = raw_frame.hdr;
+    raw_view.data = raw_frame.data;
+    raw_view.linesize = raw_frame.linesize;
+    raw_view.buf = raw_frame.buf.get();
+    constexpr int kRegionSize = 16;
+    std::vector<float> region(kRegionSize * kRegionSize);
+    REQUIRE(dump_log_on_fail(ilp_movie::ConvertFrameRegion(raw_view,
+      ilp_movie::Comp::kG,
+      /*x=*/kRegionSize,
+      /*y=*/kRegionSize,
+      kRegionSize,
+      kRegionSize,
+      region.data(),
+      /*dst_stride=*/kRegionSize,
+      *native_convert)));
+    const auto g = ilp_movie::CompPixelData<const float>(filt_frame, ilp_movie::Comp::kG);
+    for (int y = 0; y < kRegionSize; ++y) {
+      REQUIRE(dump_log_on_fail(std::memcmp(region.data() + y * kRegionSize,// NOLINT
+                                 g.data + (kRegionSize + y) * kWidth + kRegionSize,// NOLINT
+                                 kRegionSize * sizeof(float))
+                               == 0));
+    }
+
+    // The output header is known without filtering any frames.
+    ilp_movie::FrameFilter scale_filter{};
+    REQUIRE(dump_log_on_fail(scale_filter.SetDescription(
+      ilp_movie::DecoderFilterGraphDescription{ "scale=320:240", ilp_movie::PixFmt::kRGB_P_F32 },
+      *raw_hdr)));
+    const auto out_hdr = scale_filter.OutputHeader();
+    REQUIRE(dump_log_on_fail(out_hdr.has_value()));
+    REQUIRE(dump_log_on_fail(out_hdr->width == 320));
+    REQUIRE(dump_log_on_fail(out_hdr->height == 240));
+    REQUIRE(dump_log_on_fail(!scale_filter.NativeConvert().has_value()));
+    REQUIRE(dump_log_on_fail(scale_filter.FilterFrame(raw_frame, filt_frame)));
+    REQUIRE(dump_log_on_fail(filt_frame.hdr.width == 320));
+    REQUIRE(dump_log_on_fail(filt_frame.hdr.height == 240));
+  }
+
   // dump_log_on_fail(false);// TMP!!
 }
 
@@ -435,6 +623,106 @@ TEST_CASE("seek(h.264)")
     REQUIRE(dump_log_on_fail(bad_frame == -1));
   }
 
+  SECTION("cancel")
+  {
+    ilp_movie::Decoder decoder{};
+    REQUIRE(dump_log_on_fail(decoder.Open(kFilename.data(),
+      ilp_movie::DecoderFilterGraphDescription{ "null", ilp_movie::PixFmt::kRGB_P_F32 })));
+
+    // The last frame of the stream is furthest from a key frame, so seeking to it requires
+    // decoding several packets.
+    int poll_count = 0;
+    ilp_movie::Frame dec_frame{};
+    REQUIRE(dump_log_on_fail(!decoder.DecodeVideoFrame(
+      /*stream_index=*/0, kFrameCount, /*out*/ dec_frame, [&poll_count]() {
+        return ++poll_count > 2;
+      })));
+    REQUIRE(dump_log_on_fail(poll_count == 3));
+
+    // Decoding continues as usual after a cancelled decode.
+    ilp_movie::Frame expected_frame{};
+    ilp_movie::Decoder expected_decoder{};
+    REQUIRE(dump_log_on_fail(expected_decoder.Open(kFilename.data(),
+      ilp_movie::DecoderFilterGraphDescription{ "null", ilp_movie::PixFmt::kRGB_P_F32 })));
+    REQUIRE(dump_log_on_fail(
+      expected_decoder.DecodeVideoFrame(/*stream_index=*/0, kFrameCount, expected_frame)));
+    REQUIRE(dump_log_on_fail(decoder.DecodeVideoFrame(
+      /*stream_index=*/0, kFrameCount, /*out*/ dec_frame, []() { return false; })));
+    REQUIRE(dump_log_on_fail(dec_frame.hdr.frame_nb == kFrameCount));
+    const auto buf_size = ilp_movie::GetBufferSize(
+      dec_frame.hdr.pix_fmt_name, dec_frame.hdr.width, dec_frame.hdr.height);
+    REQUIRE(dump_log_on_fail(buf_size.has_value()));
+    REQUIRE(dump_log_on_fail(
+      std::memcmp(dec_frame.buf.get(), expected_frame.buf.get(), *buf_size) == 0));
+  }
+
+  SECTION("stats")
+  {
+    ilp_movie::Decoder decoder{};
+    REQUIRE(dump_log_on_fail(decoder.Open(kFilename.data(),
+      ilp_movie::DecoderFilterGraphDescription{ "null", ilp_movie::PixFmt::kRGB_P_F32 })));
+
+    ilp_movie::Frame dec_frame{};
+    REQUIRE(dump_log_on_fail(decoder.DecodeVideoFrame(/*stream_index=*/0, kFrameCount, dec_frame)));
+    REQUIRE(dump_log_on_fail(!decoder.DecodeVideoFrame(/*stream_index=*/0, -1, dec_frame)));
+
+    auto stats = decoder.Stats();
+    REQUIRE(dump_log_on_fail(stats.decode_calls == 2));
+    REQUIRE(dump_log_on_fail(stats.failed_decodes == 1));
+    REQUIRE(dump_log_on_fail(stats.cancelled_decodes == 0));
+    REQUIRE(dump_log_on_fail(stats.seeks == 1));
+
+    // The last frame is not a key frame, so preceding frames are decoded and discarded.
+    REQUIRE(dump_log_on_fail(stats.packets_read > 1));
+    REQUIRE(dump_log_on_fail(stats.frames_decoded > 1));
+    REQUIRE(dump_log_on_fail(stats.frames_discarded == stats.frames_decoded - 1));
+    REQUIRE(dump_log_on_fail(stats.decode_ns > 0 && stats.filter_ns > 0 && stats.copy_ns >= 0));
+
+    decoder.ResetStats();
+    stats = decoder.Stats();
+    REQUIRE(dump_log_on_fail(stats.decode_calls == 0 && stats.decode_ns == 0));
+  }
+
+  SECTION("async")
+  {
+    ilp_movie::Decoder decoder{};
+    REQUIRE(dump_log_on_fail(decoder.Open(kFilename.data(),
+      ilp_movie::DecoderFilterGraphDescription{ "null", ilp_movie::PixFmt::kRGB_P_F32 })));
+
+    // Jobs are run explicitly, so that requests are still queued when duplicates are made.
+    std::vector<std::function<void()>> jobs;
+    decoder.SetExecutor([&jobs](std::function<void()> job) { jobs.push_back(std::move(job)); });
+
+    std::vector<int> decoded;
+    const auto on_decoded = [&decoded](const ilp_movie::DecodedFrame &f) {
+      decoded.push_back(f != nullptr ? static_cast<int>(f->hdr.frame_nb) : -1);
+    };
+    auto f10 = decoder.DecodeVideoFrameAsync(/*stream_index=*/0, /*frame_nb=*/10);
+    decoder.DecodeVideoFrameAsync(/*stream_index=*/0, /*frame_nb=*/5, on_decoded);
+    decoder.DecodeVideoFrameAsync(/*stream_index=*/0, /*frame_nb=*/20, on_decoded);
+    auto f5 = decoder.DecodeVideoFrameAsync(/*stream_index=*/0, /*frame_nb=*/5);
+    REQUIRE(dump_log_on_fail(decoder.PendingDecodeCount() == 3));
+    REQUIRE(dump_log_on_fail(jobs.size() == 1U));
+
+    while (!jobs.empty()) {
+      auto job = std::move(jobs.back());
+      jobs.pop_back();
+      job();
+    }
+    REQUIRE(dump_log_on_fail(decoder.PendingDecodeCount() == 0));
+    REQUIRE(dump_log_on_fail(decoded == std::vector<int>{ 5, 20 }));
+    REQUIRE(dump_log_on_fail(f10.get() != nullptr && f10.get()->hdr.frame_nb == 10));
+    REQUIRE(dump_log_on_fail(f5.get() != nullptr && f5.get()->hdr.frame_nb == 5));
+
+    // Closing the decoder cancels queued requests.
+    auto f30 = decoder.DecodeVideoFrameAsync(/*stream_index=*/0, /*frame_nb=*/30);
+    REQUIRE(dump_log_on_fail(jobs.size() == 1U));
+    decoder.Close();
+    REQUIRE(dump_log_on_fail(f30.get() == nullptr));
+    jobs.front()();
+    REQUIRE(dump_log_on_fail(decoder.PendingDecodeCount() == 0));
+  }
+
   SECTION("multiple_decoders_same_file")
   {
     ilp_movie::Decoder d0{};
@@ -199,3 +199,33 @@ TEST_CASE("CompPixelData")
 }
 
 }// namespace
+
+TEST_CASE("HasCompPixelData")
+{
+  using ilp_movie::HasCompPixelData;
+  namespace Comp = ilp_movie::Comp;
+
+  SECTION("rgb")
+  {
+    REQUIRE(HasCompPixelData(Comp::kR, ilp_movie::PixFmt::kRGB_P_F32));
+    REQUIRE(HasCompPixelData(Comp::kG, ilp_movie::PixFmt::kRGB_P_F32));
+    REQUIRE(HasCompPixelData(Comp::kB, ilp_movie::PixFmt::kRGB_P_F32));
+    REQUIRE(!HasCompPixelData(Comp::kA, ilp_movie::PixFmt::kRGB_P_F32));
+  }
+
+  SECTION("rgba")
+  {
+    REQUIRE(HasCompPixelData(Comp::kR, ilp_movie::PixFmt::kRGBA_P_F32));
+    REQUIRE(HasCompPixelData(Comp::kG, ilp_movie::PixFmt::kRGBA_P_F32));
+    REQUIRE(HasCompPixelData(Comp::kB, ilp_movie::PixFmt::kRGBA_P_F32));
+    REQUIRE(HasCompPixelData(Comp::kA, ilp_movie::PixFmt::kRGBA_P_F32));
+  }
+
+  SECTION("fail")
+  {
+    REQUIRE(!HasCompPixelData(Comp::kR, nullptr));
+    REQUIRE(!HasCompPixelData(Comp::kUnknown, ilp_movie::PixFmt::kRGB_P_F32));
+    REQUIRE(!HasCompPixelData(Comp::kY, "yuv422p10le"));
+    REQUIRE(!HasCompPixelData(Comp::kR, "gbrp"));
+  }
+}
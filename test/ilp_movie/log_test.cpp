@@ -0,0 +1,85 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>// std::string, std::to_string
+#include <thread>// std::thread
+#include <vector>// std::vector
+
+#include "ilp_movie/log.hpp"
+
+namespace {
+
+TEST_CASE("log")
+{
+  std::vector<std::string> log_lines = {};
+  ilp_movie::SetLogCallback(
+    [&log_lines](int /*level*/, const char *s) { log_lines.emplace_back(std::string{ s }); });
+  ilp_movie::SetLogLevel(ilp_movie::LogLevel::kInfo);
+
+  SECTION("level")
+  {
+    ilp_movie::LogMsg(ilp_movie::LogLevel::kDebug, "debug\n");
+    ilp_movie::LogMsg(ilp_movie::LogLevel::kInfo, "info\n");
+    REQUIRE(log_lines == std::vector<std::string>{ "info\n" });
+  }
+
+  SECTION("repeated")
+  {
+    for (int i = 0; i < 5; ++i) { ilp_movie::LogMsg(ilp_movie::LogLevel::kError, "error\n"); }
+    ilp_movie::LogMsg(ilp_movie::LogLevel::kWarning, "warning\n");
+    REQUIRE(log_lines.size() == 3U);
+    REQUIRE(log_lines[0] == "error\n");
+    REQUIRE(log_lines[1].find("repeated 4 times") != std::string::npos);
+    REQUIRE(log_lines[2] == "warning\n");
+  }
+
+  SECTION("async")
+  {
+    ilp_movie::SetAsyncLogging(true);
+    REQUIRE(ilp_movie::IsAsyncLogging());
+
+    constexpr int kThreadCount = 4;
+    constexpr int kMessageCount = 50;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreadCount; ++t) {
+      threads.emplace_back([t]() {
+        for (int i = 0; i < kMessageCount; ++i) {
+          const std::string msg = std::to_string(t) + ":" + std::to_string(i) + "\n";
+          ilp_movie::LogMsg(ilp_movie::LogLevel::kInfo, msg.c_str());
+        }
+      });
+    }
+    for (auto &&t : threads) { t.join(); }
+    ilp_movie::FlushLog();
+
+    // Messages may be dropped if the queue is full, but messages from a thread are in order.
+    REQUIRE(!log_lines.empty());
+    REQUIRE(log_lines.size() <= kThreadCount * kMessageCount + kThreadCount);
+    std::vector<int> last(kThreadCount, -1);
+    for (auto &&line : log_lines) {
+      if (line.find("Dropped") != std::string::npos) { continue; }
+      const auto sep = line.find(':');
+      const int t = std::stoi(line.substr(0, sep));
+      const int i = std::stoi(line.substr(sep + 1));
+      REQUIRE(i > last.at(static_cast<std::size_t>(t)));
+      last.at(static_cast<std::size_t>(t)) = i;
+    }
+
+    // Queued messages are delivered to the callback that was set when they were logged.
+    std::string probe;
+    ilp_movie::SetLogCallback([&probe](int /*level*/, const char *s) { probe += s; });
+    ilp_movie::LogMsg(ilp_movie::LogLevel::kInfo, "probe\n");
+    ilp_movie::SetLogCallback(
+      [&log_lines](int /*level*/, const char *s) { log_lines.emplace_back(std::string{ s }); });
+    REQUIRE(probe == "probe\n");
+
+    ilp_movie::SetAsyncLogging(false);
+    REQUIRE(!ilp_movie::IsAsyncLogging());
+    log_lines.clear();
+    ilp_movie::LogMsg(ilp_movie::LogLevel::kInfo, "sync\n");
+    REQUIRE(log_lines == std::vector<std::string>{ "sync\n" });
+  }
+
+  ilp_movie::SetLogCallback([](int /*level*/, const char * /*s*/) {});
+}
+
+}// namespace
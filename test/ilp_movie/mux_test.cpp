@@ -1,4 +1,5 @@
 #include <algorithm>// std::fill
+#include <chrono>// std::chrono
 #include <iostream>// std::cout, std::cerr
 #include <string>// std::string
 #include <string_view>// std::string_view
@@ -6,6 +7,7 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <ilp_movie/frame.hpp>
 #include <ilp_movie/log.hpp>
 #include <ilp_movie/mux.hpp>
 
@@ -432,4 +434,88 @@ TEST_CASE("ProRes")
   }
 }
 
+// Hidden benchmark, run with: mux_test "[benchmark]"
+TEST_CASE("RGB to YUV throughput", "[.][benchmark]")
+{
+  ilp_movie::SetLogLevel(ilp_movie::LogLevel::kWarning);
+
+  constexpr int kWidth = 1920;
+  constexpr int kHeight = 1080;
+  constexpr int kFrameCount = 48;
+
+  // Frames per second when encoding, including the pixel format conversion.
+  const auto frames_per_second = [&](ilp_movie::MuxParameters mux_params,
+                                   const std::string_view filter_graph) {
+    // Prefixing the default filter graph with a "null" filter gives the same output, but
+    // disables the native conversion.
+    if (!filter_graph.empty()) { mux_params.filter_graph = filter_graph; }
+    const auto mux_ctx = ilp_movie::MakeMuxContext(mux_params);
+    REQUIRE(mux_ctx != nullptr);
+
+    const char *pix_fmt_name = ilp_movie::PixFmt::kRGB_P_F32;
+    const auto buf_size = ilp_movie::GetBufferSize(pix_fmt_name, kWidth, kHeight);
+    REQUIRE(buf_size.has_value());
+    std::vector<uint8_t> buf(*buf_size);
+    ilp_movie::FrameView frame = {};
+    frame.hdr.width = kWidth;
+    frame.hdr.height = kHeight;
+    frame.hdr.pix_fmt_name = pix_fmt_name;
+    REQUIRE(ilp_movie::FillArrays(
+      frame.data, frame.linesize, buf.data(), pix_fmt_name, kWidth, kHeight));
+    for (const auto c : { ilp_movie::Comp::kR, ilp_movie::Comp::kG, ilp_movie::Comp::kB }) {
+      const auto pixels = ilp_movie::CompPixelData<float>(frame, c);
+      for (std::size_t i = 0U; i < pixels.count; ++i) {
+        pixels.data[i] = static_cast<float>((i + static_cast<std::size_t>(c) * 97U) % 1024U)// NOLINT
+                         / 1023.F;
+      }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kFrameCount; ++i) {
+      frame.hdr.frame_nb = i;
+      REQUIRE(ilp_movie::MuxWriteFrame(*mux_ctx, frame));
+    }
+    REQUIRE(ilp_movie::MuxFinish(*mux_ctx));
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(kFrameCount) / elapsed.count();
+  };
+
+  const auto run = [&](const char *name, const ilp_movie::MuxParameters &mux_params) {
+    const double native_fps = frames_per_second(mux_params, /*filter_graph=*/""sv);
+    const double filter_fps =
+      frames_per_second(mux_params, "null," + mux_params.filter_graph);
+    std::cout << name << " (" << kWidth << "x" << kHeight << ", " << mux_params.pix_fmt
+              << "): native " << native_fps << " frames/s, libavfilter " << filter_fps
+              << " frames/s\n";
+  };
+
+  SECTION("ProRes")
+  {
+    ilp_movie::ProRes::EncodeParameters enc_params = {};
+    enc_params.profile_name = ilp_movie::ProRes::ProfileName::kHq;
+    const auto mux_params = ilp_movie::MakeMuxParameters(
+      /*filename=*/"/tmp/test_data/mux_benchmark_prores.mov",
+      kWidth,
+      kHeight,
+      /*frame_rate=*/24.0,
+      enc_params);
+    REQUIRE(mux_params.has_value());
+    run("ProRes HQ", *mux_params);
+  }
+
+  SECTION("H264")
+  {
+    ilp_movie::H264::EncodeParameters enc_params = {};
+    enc_params.preset = ilp_movie::H264::Preset::kUltrafast;
+    const auto mux_params = ilp_movie::MakeMuxParameters(
+      /*filename=*/"/tmp/test_data/mux_benchmark_h264.mp4",
+      kWidth,
+      kHeight,
+      /*frame_rate=*/24.0,
+      enc_params);
+    REQUIRE(mux_params.has_value());
+    run("H.264 ultrafast", *mux_params);
+  }
+}
+
 }// namespace
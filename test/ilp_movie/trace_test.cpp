@@ -0,0 +1,68 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <fstream>// std::ifstream
+#include <iterator>// std::istreambuf_iterator
+#include <string>// std::string
+#include <thread>// std::thread
+
+#include "ilp_movie/trace.hpp"
+
+namespace {
+
+[[nodiscard]] auto ReadFile(const std::string &path) -> std::string
+{
+  std::ifstream ifs{ path };
+  return std::string{ std::istreambuf_iterator<char>{ ifs }, std::istreambuf_iterator<char>{} };
+}
+
+TEST_CASE("trace")
+{
+  const std::string kFilename = "/tmp/trace_test.json";
+  ilp_movie::ClearTrace();
+
+  SECTION("disabled")
+  {
+    ilp_movie::SetTraceEnabled(false);
+    REQUIRE(!ilp_movie::IsTraceEnabled());
+    {
+      const ilp_movie::TraceSpan span{ "test", "disabled span" };
+    }
+    ilp_movie::TraceInstant("test", "disabled instant");
+
+    REQUIRE(ilp_movie::WriteTrace(kFilename));
+    const std::string json = ReadFile(kFilename);
+    REQUIRE(json.find("\"traceEvents\"") != std::string::npos);
+    REQUIRE(json.find("disabled span") == std::string::npos);
+    REQUIRE(json.find("disabled instant") == std::string::npos);
+  }
+
+  SECTION("enabled")
+  {
+    ilp_movie::SetTraceEnabled(true);
+    REQUIRE(ilp_movie::IsTraceEnabled());
+    {
+      const ilp_movie::TraceSpan span{ "test", "enabled span", "frame", 42 };
+    }
+    std::thread{ [] { ilp_movie::TraceInstant("test", "thread instant"); } }.join();
+    ilp_movie::SetTraceEnabled(false);
+
+    REQUIRE(ilp_movie::WriteTrace(kFilename));
+    const std::string json = ReadFile(kFilename);
+    REQUIRE(json.find("\"name\":\"enabled span\"") != std::string::npos);
+    REQUIRE(json.find("\"ph\":\"X\"") != std::string::npos);
+    REQUIRE(json.find("\"args\":{\"frame\":42}") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"thread instant\"") != std::string::npos);
+    REQUIRE(json.find("\"ph\":\"i\"") != std::string::npos);
+
+    // Events are discarded once written.
+    REQUIRE(ilp_movie::WriteTrace(kFilename));
+    REQUIRE(ReadFile(kFilename).find("enabled span") == std::string::npos);
+  }
+
+  SECTION("bad path")
+  {
+    REQUIRE(!ilp_movie::WriteTrace("/non/existent/dir/trace.json"));
+  }
+}
+
+}// namespace